@@ -0,0 +1,191 @@
+#include "doctest.h"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+#include <new>
+
+#include "ECSManager.hpp"
+#include "World.hpp"
+
+// Replacing the global operator new lets the tests below count every heap allocation made while
+// counting is switched on. The other tests in this binary run with it switched off.
+namespace
+{
+	std::atomic<bool> counting{ false };
+	std::atomic<size_t> allocations{ 0 };
+}
+
+void* operator new(std::size_t size)
+{
+	if (counting)
+	{
+		allocations++;
+	}
+
+	if (void* memory = std::malloc(size == 0 ? 1 : size))
+	{
+		return memory;
+	}
+
+#ifdef BABS_ECS_NO_EXCEPTIONS
+	std::abort();
+#else
+	throw std::bad_alloc();
+#endif
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+// component data comes from the aligned overloads, see AlignedAllocator
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	if (counting)
+	{
+		allocations++;
+	}
+
+	size_t bytes = (size + static_cast<size_t>(alignment) - 1) / static_cast<size_t>(alignment) * static_cast<size_t>(alignment);
+
+#ifdef _MSC_VER
+	if (void* memory = _aligned_malloc(bytes, static_cast<size_t>(alignment)))
+#else
+	if (void* memory = std::aligned_alloc(static_cast<size_t>(alignment), bytes))
+#endif
+	{
+		return memory;
+	}
+
+#ifdef BABS_ECS_NO_EXCEPTIONS
+	std::abort();
+#else
+	throw std::bad_alloc();
+#endif
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+#ifdef _MSC_VER
+	_aligned_free(memory);
+#else
+	std::free(memory);
+#endif
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(memory, alignment);
+}
+
+namespace
+{
+	struct Position
+	{
+		float x;
+		float y;
+	};
+
+	struct Velocity
+	{
+		float x;
+		float y;
+	};
+
+	// Churn runs every per-entity operation on a batch of entities and removes them again, so
+	// running it twice in a row visits the same ids and needs the same storage.
+	template <typename Registry>
+	void Churn(Registry& registry)
+	{
+		std::array<babs_ecs::Entity, 64> spawned;
+
+		for (babs_ecs::Entity& e : spawned)
+		{
+			e = registry.CreateEntity();
+			registry.AddComponent(e, Position{ 1.0f, 2.0f });
+			registry.AddComponent(e, Velocity{ 0.5f, 0.5f });
+		}
+
+		for (babs_ecs::Entity& e : spawned)
+		{
+			registry.template GetComponent<Position>(e)->x += 1.0f;
+			CHECK(registry.template HasComponent<Velocity>(e));
+			registry.template RemoveComponent<Velocity>(e);
+		}
+
+		for (babs_ecs::Entity& e : spawned)
+		{
+			registry.RemoveEntity(e);
+		}
+	}
+}
+
+TEST_SUITE("Allocations")
+{
+	TEST_CASE("ECSManager per-entity operations don't allocate once storage has grown")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		ecs.RegisterComponent<Velocity>();
+
+		// entities enter and leave the collector within each pass, so it stays empty
+		babs_ecs::Collector& moving = ecs.Collect<Position, Velocity>();
+
+		int added = 0;
+		auto subscription = ecs.events.Subscribe<babs_ecs::ComponentAdded<Position>>([&added](const babs_ecs::ComponentAdded<Position>&) {
+			added++;
+		});
+
+		// the first pass grows every container, entity table and free list to their final size
+		Churn(ecs);
+
+		allocations = 0;
+		counting = true;
+
+		for (int i = 0; i < 10; ++i)
+		{
+			Churn(ecs);
+
+			babs_ecs::Entity e = ecs.CreateEntity();
+			ecs.AddComponent(e, Position{ 0.0f, 0.0f });
+			ecs.Patch<Position>(e, [](Position& p) { p.y += 1.0f; });
+			ecs.RemoveEntity(e);
+		}
+
+		counting = false;
+
+		REQUIRE(allocations == 0);
+		REQUIRE(added == 11 * 64 + 10);
+		REQUIRE(moving.Empty());
+
+		ecs.events.Unsubscribe<babs_ecs::ComponentAdded<Position>>(subscription);
+	}
+
+	TEST_CASE("World per-entity operations don't allocate once storage has grown")
+	{
+		babs_ecs::World<Position, Velocity> world;
+		Churn(world);
+
+		allocations = 0;
+		counting = true;
+
+		for (int i = 0; i < 10; ++i)
+		{
+			Churn(world);
+		}
+
+		counting = false;
+
+		REQUIRE(allocations == 0);
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bitfield/bitfield.hpp"
+#include "Entity.hpp"
+
+namespace babs_ecs
+{
+	// Collector gathers the entities that started or stopped matching a set of components, created
+	// by ECSManager::Collect. The manager records every change to the collector as it happens, and
+	// systems drain the packed Entered() and Left() lists once per frame, then Clear() them.
+	//
+	// The lists hold net changes since the last Clear. An entity that enters and leaves again
+	// in between appears in neither. An entity that leaves and enters again appears in both, since
+	// its id may now belong to a different entity. Handle Left() before Entered() in that case.
+	//
+	// Typical usage:
+	//   auto& moved = ecs.Collect<Transform, Collider>();
+	//   for (babs_ecs::Entity e : moved.Left()) broadphase.Remove(e);
+	//   for (babs_ecs::Entity e : moved.Entered()) broadphase.Insert(e);
+	//   moved.Clear();
+	class Collector
+	{
+	public:
+		Collector(bitfield::Bitfield mask) : mask(mask) {}
+
+		// Entered lists the entities that started matching since the last Clear.
+		const std::vector<Entity>& Entered() const
+		{
+			return this->entered;
+		}
+
+		// Left lists the entities that stopped matching since the last Clear, including removed ones.
+		const std::vector<Entity>& Left() const
+		{
+			return this->left;
+		}
+
+		bool Empty() const
+		{
+			return this->entered.empty() && this->left.empty();
+		}
+
+		// Clear forgets the collected entities. The lists keep their capacity, so collecting again
+		// doesn't allocate.
+		void Clear()
+		{
+			for (const Entity& e : this->entered)
+			{
+				this->enteredSlots[e.UUID] = 0;
+			}
+
+			this->entered.clear();
+			this->left.clear();
+		}
+
+		// Record is called by the manager whenever an entity's signature changes, with the
+		// signature before and after the change.
+		void Record(uint32_t uuid, bitfield::Bitfield before, bitfield::Bitfield after)
+		{
+			bool matched = bitfield::Has(before, this->mask);
+			bool matches = bitfield::Has(after, this->mask);
+
+			if (!matched && matches)
+			{
+				this->Enter(uuid);
+			}
+			else if (matched && !matches)
+			{
+				this->Leave(uuid);
+			}
+		}
+
+		bitfield::Bitfield mask;
+
+	private:
+		void Enter(uint32_t uuid)
+		{
+			if (uuid >= this->enteredSlots.size())
+			{
+				this->enteredSlots.resize(uuid + 1, 0);
+			}
+
+			this->entered.emplace_back(uuid);
+			this->enteredSlots[uuid] = static_cast<uint32_t>(this->entered.size());
+		}
+
+		void Leave(uint32_t uuid)
+		{
+			uint32_t slot = uuid < this->enteredSlots.size() ? this->enteredSlots[uuid] : 0;
+
+			if (slot == 0)
+			{
+				this->left.emplace_back(uuid);
+				return;
+			}
+
+			// it entered since the last Clear, so the two cancel out
+			Entity last = this->entered.back();
+			this->entered[slot - 1] = last;
+			this->enteredSlots[last.UUID] = slot;
+			this->entered.pop_back();
+			this->enteredSlots[uuid] = 0;
+		}
+
+		std::vector<Entity> entered;
+		std::vector<Entity> left;
+
+		// enteredSlots maps a UUID to its index in entered plus one, 0 means it isn't in there
+		std::vector<uint32_t> enteredSlots;
+	};
+}
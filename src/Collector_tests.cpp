@@ -0,0 +1,140 @@
+#include "doctest.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "Collector.hpp"
+#include "ECSManager.hpp"
+#include "Prefab.hpp"
+
+namespace
+{
+	struct Transform
+	{
+		float x;
+		float y;
+	};
+
+	struct Collider
+	{
+		float radius;
+	};
+
+	std::vector<uint32_t> Ids(const std::vector<babs_ecs::Entity>& entities)
+	{
+		std::vector<uint32_t> ids;
+		for (const babs_ecs::Entity& e : entities)
+		{
+			ids.push_back(e.UUID);
+		}
+		return ids;
+	}
+}
+
+TEST_SUITE("Collectors")
+{
+	TEST_CASE("Collectors record entities that start and stop matching")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Transform>();
+		ecs.RegisterComponent<Collider>();
+
+		auto& collisions = ecs.Collect<Transform, Collider>();
+		babs_ecs::Entity a = ecs.CreateEntity();
+		babs_ecs::Entity b = ecs.CreateEntity();
+
+		ecs.AddComponent(a, Transform{ 0.0f, 0.0f });
+		REQUIRE(collisions.Empty());
+
+		ecs.AddComponent(a, Collider{ 1.0f });
+		ecs.AddComponent(b, Collider{ 1.0f });
+		ecs.AddComponent(b, Transform{ 0.0f, 0.0f });
+
+		// overwriting a component doesn't change the signature
+		ecs.AddComponent(b, Transform{ 1.0f, 1.0f });
+
+		REQUIRE(Ids(collisions.Entered()) == std::vector<uint32_t>{ a.UUID, b.UUID });
+		REQUIRE(collisions.Left().empty());
+
+		collisions.Clear();
+		REQUIRE(collisions.Empty());
+
+		ecs.RemoveComponent<Collider>(a);
+		ecs.RemoveEntity(b);
+
+		REQUIRE(collisions.Entered().empty());
+		REQUIRE(Ids(collisions.Left()) == std::vector<uint32_t>{ a.UUID, b.UUID });
+	}
+
+	TEST_CASE("Entering and leaving between clears cancel out")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Transform>();
+		ecs.RegisterComponent<Collider>();
+
+		auto& collisions = ecs.Collect<Transform, Collider>();
+
+		std::vector<babs_ecs::Entity> spawned;
+		for (int i = 0; i < 4; ++i)
+		{
+			spawned.push_back(ecs.CreateEntity());
+			ecs.AddComponent(spawned.back(), Transform{ 0.0f, 0.0f });
+			ecs.AddComponent(spawned.back(), Collider{ 1.0f });
+		}
+
+		ecs.RemoveComponent<Collider>(spawned[1]);
+		ecs.RemoveEntity(spawned[2]);
+
+		std::vector<uint32_t> entered = Ids(collisions.Entered());
+		REQUIRE(entered.size() == 2);
+		REQUIRE(std::count(entered.begin(), entered.end(), spawned[0].UUID) == 1);
+		REQUIRE(std::count(entered.begin(), entered.end(), spawned[3].UUID) == 1);
+		REQUIRE(collisions.Left().empty());
+
+		collisions.Clear();
+
+		// leaving and coming back is reported both ways, in case the id now means a different entity
+		ecs.RemoveEntity(spawned[0]);
+		babs_ecs::Entity reused = ecs.CreateEntity();
+		ecs.AddComponent(reused, Transform{ 0.0f, 0.0f });
+		ecs.AddComponent(reused, Collider{ 1.0f });
+
+		REQUIRE(reused.UUID == spawned[0].UUID);
+		REQUIRE(Ids(collisions.Left()) == std::vector<uint32_t>{ reused.UUID });
+		REQUIRE(Ids(collisions.Entered()) == std::vector<uint32_t>{ reused.UUID });
+	}
+
+	TEST_CASE("New collectors start with the entities that already match")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Transform>();
+		ecs.RegisterComponent<Collider>();
+
+		babs_ecs::Prefab prefab;
+		prefab.Set(Transform{ 0.0f, 0.0f });
+		prefab.Set(Collider{ 1.0f });
+		ecs.Instantiate(prefab, 3);
+
+		auto& collisions = ecs.Collect<Collider, Transform>();
+		REQUIRE(collisions.Entered().size() == 3);
+
+		// asking again, in any order, gives the same collector
+		REQUIRE(&ecs.Collect<Transform, Collider>() == &collisions);
+
+		auto& transforms = ecs.Collect<Transform>();
+		collisions.Clear();
+		transforms.Clear();
+
+		ecs.Instantiate(prefab, 2);
+		REQUIRE(collisions.Entered().size() == 2);
+		REQUIRE(transforms.Entered().size() == 2);
+	}
+
+	TEST_CASE("Collecting unregistered components throws")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Transform>();
+
+		REQUIRE_THROWS_AS((ecs.Collect<Transform, Collider>()), const babs_ecs::ComponentNotRegisteredException&);
+	}
+}
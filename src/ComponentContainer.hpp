@@ -0,0 +1,1774 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Entity.hpp"
+#include "Hash.hpp"
+#include "Layout.hpp"
+#include "SharedPages.hpp"
+#include "SparseTable.hpp"
+
+namespace babs_ecs
+{
+	// SortMode picks the algorithm used when reordering a container.
+	//
+	// Full is a stable O(n log n) sort and works for any starting order. Insertion is an in-place
+	// insertion sort, which is close to O(n) when the data is almost sorted already (e.g. sorting
+	// by position every frame when only a few entities moved since the last sort).
+	enum class SortMode
+	{
+		Full,
+		Insertion
+	};
+
+	// BufferSwap picks what the write buffer of a double-buffered component holds after a swap.
+	//
+	// Swap is O(1) and leaves last frame's data in the write buffer, which is fine when every entity
+	// is written every frame. CopyForward also copies the new snapshot into the write buffer (O(n)),
+	// so systems that only write some entities don't leave stale values behind for the rest.
+	enum class BufferSwap
+	{
+		Swap,
+		CopyForward
+	};
+
+	// ComponentFamily is the TypeIds family for component types. ECSManager indexes its per-component
+	// tables with these ids, so looking up a component's container is a single indexed load.
+	struct ComponentFamily {};
+
+	// BaseContainer is the type-erased view of a component pool. It lets the manager and groups
+	// find and move entities around inside a pool without knowing the component type.
+	class BaseContainer
+	{
+	public:
+		BaseContainer() {};
+		virtual ~BaseContainer() {};
+
+		// Clone returns a deep copy of the container, or nullptr if the component can't be copied.
+		virtual std::unique_ptr<BaseContainer> Clone() const = 0;
+
+		// CreateEmpty returns a new empty container of the same type and storage.
+		virtual std::unique_ptr<BaseContainer> CreateEmpty() const = 0;
+
+		// IsCopyable is false when Clone would return nullptr, without making the copy.
+		virtual bool IsCopyable() const = 0;
+
+		// IsHashable is false when Hash can't see the components' values, see component_hash.
+		virtual bool IsHashable() const = 0;
+
+		// IsDoubleBuffered is true for pools that may be written from several threads at once,
+		// see DoubleBufferedContainer.
+		virtual bool IsDoubleBuffered() const
+		{
+			return false;
+		}
+
+		// MoveInto moves the component of every entity in `from` that has one into `target`, under the
+		// entity at the same position in `to`. target must be a container of the same type. The
+		// moved-from components stay here until they are removed.
+		virtual void MoveInto(BaseContainer& target, const std::vector<uint32_t>& from, const std::vector<Entity>& to) = 0;
+
+		// Hash returns the sum of HashComponent over every entity in the container, which doesn't
+		// depend on the order of the slots.
+		virtual uint64_t Hash() const = 0;
+
+		virtual size_t Size() const = 0;
+
+		// Entities returns the packed entity array, in the same order as the component data.
+		virtual const Entity* Entities() const = 0;
+
+		virtual bool Contains(uint32_t uuid) const = 0;
+		virtual size_t IndexOf(uint32_t uuid) const = 0;
+		virtual Entity EntityAt(size_t index) const = 0;
+		virtual void Swap(size_t lhs, size_t rhs) = 0;
+		virtual void Remove(uint32_t uuid) = 0;
+
+		// Clear removes every entity, starting from the back so nothing has to be moved.
+		void Clear()
+		{
+			while (this->Size() > 0)
+			{
+				this->Remove(this->EntityAt(this->Size() - 1).UUID);
+			}
+		}
+
+		// Arrange swaps the entities listed in `order` into consecutive slots starting at `begin`.
+		// Every entity in `order` must already be in the container at or after `begin`.
+		void Arrange(size_t begin, const std::vector<uint32_t>& order)
+		{
+			for (size_t i = 0; i < order.size(); ++i)
+			{
+				this->Swap(begin + i, this->IndexOf(order[i]));
+			}
+		}
+
+		// SortByKey reorders the slots in [begin, end) by key(uuid), keeping the relative order of
+		// entities with equal keys.
+		template <typename Key>
+		void SortByKey(size_t begin, size_t end, Key key, SortMode mode)
+		{
+			if (mode == SortMode::Insertion)
+			{
+				for (size_t i = begin + 1; i < end; ++i)
+				{
+					for (size_t j = i; j > begin && key(this->EntityAt(j).UUID) < key(this->EntityAt(j - 1).UUID); --j)
+					{
+						this->Swap(j, j - 1);
+					}
+				}
+				return;
+			}
+
+			std::vector<uint32_t> order;
+			order.reserve(end - begin);
+			for (size_t i = begin; i < end; ++i)
+			{
+				order.push_back(this->EntityAt(i).UUID);
+			}
+
+			std::stable_sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) {
+				return key(lhs) < key(rhs);
+			});
+
+			this->Arrange(begin, order);
+		}
+
+	protected:
+		// SortSlots reorders the slots in [begin, end) so that less(i, i + 1) never fails, keeping
+		// the relative order of equal elements. less compares the components in two slots by index.
+		template <typename Less>
+		void SortSlots(size_t begin, size_t end, Less less, SortMode mode)
+		{
+			if (mode == SortMode::Insertion)
+			{
+				for (size_t i = begin + 1; i < end; ++i)
+				{
+					for (size_t j = i; j > begin && less(j, j - 1); --j)
+					{
+						this->Swap(j, j - 1);
+					}
+				}
+				return;
+			}
+
+			std::vector<size_t> indices(end - begin);
+			std::iota(indices.begin(), indices.end(), begin);
+			std::stable_sort(indices.begin(), indices.end(), less);
+
+			std::vector<uint32_t> order;
+			order.reserve(indices.size());
+			for (size_t index : indices)
+			{
+				order.push_back(this->EntityAt(index).UUID);
+			}
+
+			this->Arrange(begin, order);
+		}
+	};
+
+	// ComponentArray is a plain view of a packed pool for handing to SIMD kernels: data[i] belongs
+	// to entities[i]. data is aligned to BABS_ECS_ALIGNMENT, and can be read and written up to
+	// PaddedSize() so loops don't need a scalar remainder. The view is invalidated by any insertion,
+	// removal or reordering of the pool.
+	template <typename T>
+	struct ComponentArray
+	{
+		T* data;
+		const Entity* entities;
+		size_t size;
+
+		T* begin() const
+		{
+			return this->data;
+		}
+
+		T* end() const
+		{
+			return this->data + this->size;
+		}
+
+		T& operator[](size_t index) const
+		{
+			return this->data[index];
+		}
+
+		size_t PaddedSize() const
+		{
+			return PaddedCount<T>(this->size);
+		}
+	};
+
+	// This is the concrete type created by RegisterComponent and inserted into the map.
+	// This container will hold all of the component data for a specific component type.
+	//
+	// Component data is packed: `data[i]` belongs to `entities[i]`, and `sparse` maps an entity
+	// UUID back to its slot. Lookups are O(1), and removal swaps the last element into the hole
+	// so the arrays never have gaps. The sparse table is paged, so a rare component only pays for
+	// the pages its entities fall in.
+	//
+	// The class is final so calls made on a concrete container (like World does) never go through
+	// the vtable.
+	template <typename T>
+	class ComponentContainer final : public BaseContainer
+	{
+	public:
+		ComponentContainer() {};
+		virtual ~ComponentContainer() {};
+
+		std::unique_ptr<BaseContainer> Clone() const override
+		{
+			if constexpr (std::is_copy_constructible_v<T>)
+			{
+				return std::make_unique<ComponentContainer>(*this);
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+		std::unique_ptr<BaseContainer> CreateEmpty() const override
+		{
+			return std::make_unique<ComponentContainer>();
+		}
+
+		bool IsCopyable() const override
+		{
+			return std::is_copy_constructible_v<T>;
+		}
+
+		bool IsHashable() const override
+		{
+			return is_hashable_component_v<T>;
+		}
+
+		void MoveInto(BaseContainer& target, const std::vector<uint32_t>& from, const std::vector<Entity>& to) override
+		{
+			ComponentContainer& other = static_cast<ComponentContainer&>(target);
+			for (size_t i = 0; i < from.size(); ++i)
+			{
+				if (T* component = this->Get(from[i]))
+				{
+					other.Insert(to[i], std::move(*component));
+				}
+			}
+		}
+
+		AlignedVector<T> data;
+		std::vector<Entity> entities;
+		SparseTable sparse;
+
+		ComponentArray<T> Array()
+		{
+			return ComponentArray<T>{ this->data.data(), this->entities.data(), this->data.size() };
+		}
+
+		size_t Size() const override
+		{
+			return this->data.size();
+		}
+
+		const Entity* Entities() const override
+		{
+			return this->entities.data();
+		}
+
+		uint64_t Hash() const override
+		{
+			uint64_t sum = 0;
+			for (size_t i = 0; i < this->data.size(); ++i)
+			{
+				sum += HashComponent(this->entities[i].UUID, this->data[i]);
+			}
+			return sum;
+		}
+
+		bool Contains(uint32_t uuid) const override
+		{
+			return this->sparse.Contains(uuid);
+		}
+
+		// IndexOf assumes the entity is in the container, check with Contains first.
+		size_t IndexOf(uint32_t uuid) const override
+		{
+			return this->sparse[uuid];
+		}
+
+		Entity EntityAt(size_t index) const override
+		{
+			return this->entities[index];
+		}
+
+		// Get returns a pointer to the entity's component data, or nullptr if it has none.
+		// The pointer is invalidated by any insertion, removal or reordering of this container.
+		T* Get(uint32_t uuid)
+		{
+			if (!this->Contains(uuid))
+			{
+				return nullptr;
+			}
+
+			return &this->data[this->sparse[uuid]];
+		}
+
+		const T* Get(uint32_t uuid) const
+		{
+			return this->Contains(uuid) ? &this->data[this->sparse[uuid]] : nullptr;
+		}
+
+		// Insert adds the component to the end of the packed arrays, or overwrites the existing
+		// data if the entity already has this component.
+		T& Insert(Entity entity, T component)
+		{
+			if (this->Contains(entity.UUID))
+			{
+				T& existing = this->data[this->sparse[entity.UUID]];
+				existing = std::move(component);
+				return existing;
+			}
+
+			this->sparse.Set(entity.UUID, static_cast<uint32_t>(this->data.size()));
+			this->entities.push_back(Entity(entity.UUID));
+			this->data.push_back(std::move(component));
+			return this->data.back();
+		}
+
+		// Append copies count components stored back to back into the end of the pool, for the
+		// entities listed in uuids, with one block copy and a single pass over the sparse table.
+		// None of the entities may already be in the container.
+		void Append(const uint32_t* uuids, const T* components, size_t count)
+		{
+			size_t first = this->data.size();
+			this->sparse.SetMany(uuids, count, static_cast<uint32_t>(first));
+			this->entities.insert(this->entities.end(), uuids, uuids + count);
+			this->data.insert(this->data.end(), components, components + count);
+		}
+
+		// InsertBulk appends the same component value for every entity in one go, growing each array
+		// only once. None of the entities may already be in the container.
+		void InsertBulk(const std::vector<Entity>& newEntities, const T& component)
+		{
+			if (newEntities.empty())
+			{
+				return;
+			}
+
+			size_t first = this->data.size();
+			size_t count = newEntities.size();
+
+			this->entities.reserve(first + count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				this->sparse.Set(newEntities[i].UUID, static_cast<uint32_t>(first + i));
+				this->entities.push_back(Entity(newEntities[i].UUID));
+			}
+
+			if constexpr (std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>)
+			{
+				// copy one value, then keep doubling the block we memcpy from
+				this->data.resize(first + count);
+				T* destination = this->data.data() + first;
+				std::memcpy(static_cast<void*>(destination), &component, sizeof(T));
+
+				size_t copied = 1;
+				while (copied < count)
+				{
+					size_t block = std::min(copied, count - copied);
+					std::memcpy(static_cast<void*>(destination + copied), destination, block * sizeof(T));
+					copied += block;
+				}
+			}
+			else
+			{
+				this->data.insert(this->data.end(), count, component);
+			}
+		}
+
+		void Swap(size_t lhs, size_t rhs) override
+		{
+			if (lhs == rhs)
+			{
+				return;
+			}
+
+			std::swap(this->data[lhs], this->data[rhs]);
+			std::swap(this->entities[lhs], this->entities[rhs]);
+			this->sparse.Set(this->entities[lhs].UUID, static_cast<uint32_t>(lhs));
+			this->sparse.Set(this->entities[rhs].UUID, static_cast<uint32_t>(rhs));
+		}
+
+		// Sort reorders the slots in [begin, end) so that compare(data[i], data[i + 1]) never fails,
+		// keeping the relative order of equal elements.
+		template <typename Compare>
+		void Sort(size_t begin, size_t end, Compare compare, SortMode mode)
+		{
+			if (mode == SortMode::Insertion)
+			{
+				for (size_t i = begin + 1; i < end; ++i)
+				{
+					for (size_t j = i; j > begin && compare(this->data[j], this->data[j - 1]); --j)
+					{
+						this->Swap(j, j - 1);
+					}
+				}
+				return;
+			}
+
+			// sort slot indices first so the component data is only swapped into place once at the end
+			std::vector<size_t> indices(end - begin);
+			std::iota(indices.begin(), indices.end(), begin);
+
+			std::stable_sort(indices.begin(), indices.end(), [&](size_t lhs, size_t rhs) {
+				return compare(this->data[lhs], this->data[rhs]);
+			});
+
+			std::vector<uint32_t> order;
+			order.reserve(indices.size());
+			for (size_t index : indices)
+			{
+				order.push_back(this->entities[index].UUID);
+			}
+
+			this->Arrange(begin, order);
+		}
+
+		// Remove moves the last element into the removed slot. Removing an entity that isn't in
+		// the container does nothing.
+		void Remove(uint32_t uuid) override
+		{
+			if (!this->Contains(uuid))
+			{
+				return;
+			}
+
+			this->Swap(this->sparse[uuid], this->data.size() - 1);
+
+			this->sparse.Erase(uuid);
+			this->entities.pop_back();
+			this->data.pop_back();
+		}
+	};
+
+	template <typename T>
+	class FieldArrays;
+
+	// SoAContainer stores a component listed in soa_layout as one aligned array per member, so
+	// kernels can stream x[], y[] and z[] with full-width vector loads. It keeps the same packed
+	// entity bookkeeping as ComponentContainer, but has no T objects to point into: whole components
+	// are rebuilt with Load and written back with Store.
+	template <typename T, typename Fields = typename soa_layout<T>::fields>
+	class SoAContainer;
+
+	template <typename T, auto... Members>
+	class SoAContainer<T, soa_fields<Members...>> final : public BaseContainer
+	{
+		static_assert(sizeof...(Members) > 0, "soa_fields needs at least one member");
+		static_assert((std::is_same_v<typename member_pointer<decltype(Members)>::owner, T> && ...), "soa_fields must only list members of the component");
+		static_assert(std::is_default_constructible_v<T>, "SoA components must be default constructible");
+
+	public:
+		SoAContainer() {};
+		virtual ~SoAContainer() {};
+
+		std::unique_ptr<BaseContainer> Clone() const override
+		{
+			if constexpr (std::is_copy_constructible_v<T>)
+			{
+				return std::make_unique<SoAContainer>(*this);
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+		std::unique_ptr<BaseContainer> CreateEmpty() const override
+		{
+			return std::make_unique<SoAContainer>();
+		}
+
+		bool IsCopyable() const override
+		{
+			return std::is_copy_constructible_v<T>;
+		}
+
+		bool IsHashable() const override
+		{
+			return has_component_hash_v<T> || (is_bytewise_hashable_v<typename member_pointer<decltype(Members)>::field> && ...);
+		}
+
+		void MoveInto(BaseContainer& target, const std::vector<uint32_t>& from, const std::vector<Entity>& to) override
+		{
+			SoAContainer& other = static_cast<SoAContainer&>(target);
+			for (size_t i = 0; i < from.size(); ++i)
+			{
+				if (this->Contains(from[i]))
+				{
+					other.Insert(to[i], this->Load(this->IndexOf(from[i])));
+				}
+			}
+		}
+
+		std::tuple<AlignedVector<typename member_pointer<decltype(Members)>::field>...> fields;
+		std::vector<Entity> entities;
+		SparseTable sparse;
+
+		FieldArrays<T> Array()
+		{
+			return FieldArrays<T>(this);
+		}
+
+		size_t Size() const override
+		{
+			return this->entities.size();
+		}
+
+		const Entity* Entities() const override
+		{
+			return this->entities.data();
+		}
+
+		// Hash hashes each entity's members one after the other, so padding between them doesn't
+		// matter, but the members themselves have to be byte-wise hashable (see IsHashable). If
+		// component_hash is specialized for T, each component is rebuilt and hashed with it.
+		uint64_t Hash() const override
+		{
+			uint64_t sum = 0;
+			for (size_t i = 0; i < this->entities.size(); ++i)
+			{
+				if constexpr (has_component_hash_v<T>)
+				{
+					sum += HashComponent(this->entities[i].UUID, this->Load(i));
+				}
+				else
+				{
+					uint64_t h = HashMix(0, this->entities[i].UUID);
+					std::apply([&](const auto&... arrays) {
+						((h = HashBytes(&arrays[i], sizeof(arrays[i]), h)), ...);
+					}, this->fields);
+					sum += h;
+				}
+			}
+			return sum;
+		}
+
+		bool Contains(uint32_t uuid) const override
+		{
+			return this->sparse.Contains(uuid);
+		}
+
+		// IndexOf assumes the entity is in the container, check with Contains first.
+		size_t IndexOf(uint32_t uuid) const override
+		{
+			return this->sparse[uuid];
+		}
+
+		Entity EntityAt(size_t index) const override
+		{
+			return this->entities[index];
+		}
+
+		// Field returns the packed array for one member, e.g. Field<&Particle::x>().
+		template <auto Member>
+		auto* Field()
+		{
+			return std::get<FieldIndex<Member>()>(this->fields).data();
+		}
+
+		// Load rebuilds the component stored in slot index.
+		T Load(size_t index) const
+		{
+			T value{};
+			std::apply([&](const auto&... arrays) {
+				((value.*Members = arrays[index]), ...);
+			}, this->fields);
+			return value;
+		}
+
+		// Store writes every member of value into slot index.
+		void Store(size_t index, const T& value)
+		{
+			std::apply([&](auto&... arrays) {
+				((arrays[index] = value.*Members), ...);
+			}, this->fields);
+		}
+
+		// Insert adds the component to the end of the packed arrays, or overwrites the existing
+		// data if the entity already has this component.
+		void Insert(Entity entity, const T& component)
+		{
+			if (this->Contains(entity.UUID))
+			{
+				this->Store(this->sparse[entity.UUID], component);
+				return;
+			}
+
+			this->sparse.Set(entity.UUID, static_cast<uint32_t>(this->entities.size()));
+			this->entities.push_back(Entity(entity.UUID));
+			std::apply([&](auto&... arrays) {
+				(arrays.push_back(component.*Members), ...);
+			}, this->fields);
+		}
+
+		// InsertBulk appends the same component value for every entity in one go. None of the
+		// entities may already be in the container.
+		void InsertBulk(const std::vector<Entity>& newEntities, const T& component)
+		{
+			for (const Entity& entity : newEntities)
+			{
+				this->sparse.Set(entity.UUID, static_cast<uint32_t>(this->entities.size()));
+				this->entities.push_back(Entity(entity.UUID));
+			}
+
+			std::apply([&](auto&... arrays) {
+				(arrays.insert(arrays.end(), newEntities.size(), component.*Members), ...);
+			}, this->fields);
+		}
+
+		void Swap(size_t lhs, size_t rhs) override
+		{
+			if (lhs == rhs)
+			{
+				return;
+			}
+
+			std::apply([&](auto&... arrays) {
+				(std::swap(arrays[lhs], arrays[rhs]), ...);
+			}, this->fields);
+			std::swap(this->entities[lhs], this->entities[rhs]);
+			this->sparse.Set(this->entities[lhs].UUID, static_cast<uint32_t>(lhs));
+			this->sparse.Set(this->entities[rhs].UUID, static_cast<uint32_t>(rhs));
+		}
+
+		// Sort reorders the slots in [begin, end) so that compare(Load(i), Load(i + 1)) never fails,
+		// keeping the relative order of equal elements.
+		template <typename Compare>
+		void Sort(size_t begin, size_t end, Compare compare, SortMode mode)
+		{
+			if (mode == SortMode::Insertion)
+			{
+				for (size_t i = begin + 1; i < end; ++i)
+				{
+					for (size_t j = i; j > begin && compare(this->Load(j), this->Load(j - 1)); --j)
+					{
+						this->Swap(j, j - 1);
+					}
+				}
+				return;
+			}
+
+			// rebuild every component once up front rather than on each comparison
+			std::vector<T> values;
+			values.reserve(end - begin);
+			for (size_t i = begin; i < end; ++i)
+			{
+				values.push_back(this->Load(i));
+			}
+
+			std::vector<size_t> indices(end - begin);
+			std::iota(indices.begin(), indices.end(), 0);
+
+			std::stable_sort(indices.begin(), indices.end(), [&](size_t lhs, size_t rhs) {
+				return compare(values[lhs], values[rhs]);
+			});
+
+			std::vector<uint32_t> order;
+			order.reserve(indices.size());
+			for (size_t index : indices)
+			{
+				order.push_back(this->entities[begin + index].UUID);
+			}
+
+			this->Arrange(begin, order);
+		}
+
+		// Remove moves the last element into the removed slot. Removing an entity that isn't in
+		// the container does nothing.
+		void Remove(uint32_t uuid) override
+		{
+			if (!this->Contains(uuid))
+			{
+				return;
+			}
+
+			this->Swap(this->sparse[uuid], this->entities.size() - 1);
+
+			this->sparse.Erase(uuid);
+			this->entities.pop_back();
+			std::apply([](auto&... arrays) {
+				(arrays.pop_back(), ...);
+			}, this->fields);
+		}
+
+	private:
+		template <auto Member>
+		static constexpr size_t FieldIndex()
+		{
+			static_assert((SameMember<Member, Members>() || ...), "Member is not part of the component's soa_layout");
+
+			size_t index = 0;
+			size_t found = 0;
+			((SameMember<Member, Members>() ? (found = index++) : index++), ...);
+			return found;
+		}
+
+		template <auto Lhs, auto Rhs>
+		static constexpr bool SameMember()
+		{
+			if constexpr (std::is_same_v<decltype(Lhs), decltype(Rhs)>)
+			{
+				return Lhs == Rhs;
+			}
+			else
+			{
+				return false;
+			}
+		}
+	};
+
+	// FieldArrays is the SoA counterpart of ComponentArray. Field<&T::x>() returns the aligned array
+	// for one member, with entities[i] owning slot i of every array. Like ComponentArray, it's
+	// invalidated by any insertion, removal or reordering of the pool.
+	//
+	// Typical usage:
+	//   auto particles = ecs.GetComponentArray<Particle>();
+	//   float* x = particles.Field<&Particle::x>();
+	//   const float* vx = particles.Field<&Particle::vx>();
+	//   for (size_t i = 0; i < particles.PaddedSize<&Particle::x>(); ++i) x[i] += vx[i] * dt;
+	template <typename T>
+	class FieldArrays
+	{
+	public:
+		FieldArrays(SoAContainer<T>* container = nullptr) : container(container) {}
+
+		template <auto Member>
+		auto* Field() const
+		{
+			using Field = typename member_pointer<decltype(Member)>::field;
+			return this->container != nullptr ? this->container->template Field<Member>() : static_cast<Field*>(nullptr);
+		}
+
+		const Entity* Entities() const
+		{
+			return this->container != nullptr ? this->container->entities.data() : nullptr;
+		}
+
+		size_t Size() const
+		{
+			return this->container != nullptr ? this->container->Size() : 0;
+		}
+
+		// PaddedSize is how far Field<Member>() can be processed without a scalar remainder loop.
+		template <auto Member>
+		size_t PaddedSize() const
+		{
+			return PaddedCount<typename member_pointer<decltype(Member)>::field>(this->Size());
+		}
+
+	private:
+		SoAContainer<T>* container;
+	};
+
+	// BufferedArray is the view GetComponentArray returns for double-buffered components. current
+	// is this frame's snapshot and next is the buffer being written, both indexed like entities.
+	template <typename T>
+	struct BufferedArray
+	{
+		const T* current;
+		T* next;
+		const Entity* entities;
+		size_t size;
+
+		size_t PaddedSize() const
+		{
+			return PaddedCount<T>(this->size);
+		}
+	};
+
+	// DoubleBufferedContainer keeps two copies of every component that share one set of packed
+	// entity bookkeeping. `current` is the snapshot of the frame being simulated and is only read,
+	// `next` is the frame being built and is the one Get writes into. SwapBuffers flips them in O(1).
+	//
+	// Because no system writes the snapshot, any number of systems can read neighbouring entities
+	// in parallel while writing their own entities' next values.
+	template <typename T>
+	class DoubleBufferedContainer final : public BaseContainer
+	{
+	public:
+		DoubleBufferedContainer() {};
+		virtual ~DoubleBufferedContainer() {};
+
+		std::unique_ptr<BaseContainer> Clone() const override
+		{
+			if constexpr (std::is_copy_constructible_v<T>)
+			{
+				return std::make_unique<DoubleBufferedContainer>(*this);
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+		std::unique_ptr<BaseContainer> CreateEmpty() const override
+		{
+			return std::make_unique<DoubleBufferedContainer>();
+		}
+
+		bool IsCopyable() const override
+		{
+			return std::is_copy_constructible_v<T>;
+		}
+
+		bool IsHashable() const override
+		{
+			return is_hashable_component_v<T>;
+		}
+
+		bool IsDoubleBuffered() const override
+		{
+			return true;
+		}
+
+		// MoveInto carries both buffers over, so a move in the middle of a frame keeps the snapshot.
+		void MoveInto(BaseContainer& target, const std::vector<uint32_t>& from, const std::vector<Entity>& to) override
+		{
+			DoubleBufferedContainer& other = static_cast<DoubleBufferedContainer&>(target);
+			for (size_t i = 0; i < from.size(); ++i)
+			{
+				if (this->Contains(from[i]))
+				{
+					size_t index = this->IndexOf(from[i]);
+					other.Insert(to[i], std::move(this->current[index]));
+					*other.Get(to[i].UUID) = std::move(this->next[index]);
+				}
+			}
+		}
+
+		AlignedVector<T> current;
+		AlignedVector<T> next;
+		std::vector<Entity> entities;
+		SparseTable sparse;
+
+		BufferedArray<T> Array()
+		{
+			return BufferedArray<T>{ this->current.data(), this->next.data(), this->entities.data(), this->entities.size() };
+		}
+
+		size_t Size() const override
+		{
+			return this->entities.size();
+		}
+
+		const Entity* Entities() const override
+		{
+			return this->entities.data();
+		}
+
+		// Hash covers the current snapshot, which is the state every system saw this frame.
+		uint64_t Hash() const override
+		{
+			uint64_t sum = 0;
+			for (size_t i = 0; i < this->entities.size(); ++i)
+			{
+				sum += HashComponent(this->entities[i].UUID, this->current[i]);
+			}
+			return sum;
+		}
+
+		bool Contains(uint32_t uuid) const override
+		{
+			return this->sparse.Contains(uuid);
+		}
+
+		// IndexOf assumes the entity is in the container, check with Contains first.
+		size_t IndexOf(uint32_t uuid) const override
+		{
+			return this->sparse[uuid];
+		}
+
+		Entity EntityAt(size_t index) const override
+		{
+			return this->entities[index];
+		}
+
+		// Get returns a pointer to the entity's value in the next frame, or nullptr if it has none.
+		T* Get(uint32_t uuid)
+		{
+			if (!this->Contains(uuid))
+			{
+				return nullptr;
+			}
+
+			return &this->next[this->sparse[uuid]];
+		}
+
+		// Read returns a pointer to the entity's value in the current snapshot, or nullptr if it has none.
+		const T* Read(uint32_t uuid) const
+		{
+			if (!this->Contains(uuid))
+			{
+				return nullptr;
+			}
+
+			return &this->current[this->sparse[uuid]];
+		}
+
+		// Insert sets both buffers, so a newly added component can be read straight away.
+		T& Insert(Entity entity, T component)
+		{
+			if (this->Contains(entity.UUID))
+			{
+				size_t index = this->sparse[entity.UUID];
+				this->current[index] = component;
+				this->next[index] = std::move(component);
+				return this->next[index];
+			}
+
+			this->sparse.Set(entity.UUID, static_cast<uint32_t>(this->entities.size()));
+			this->entities.push_back(Entity(entity.UUID));
+			this->current.push_back(component);
+			this->next.push_back(std::move(component));
+			return this->next.back();
+		}
+
+		// InsertBulk appends the same component value for every entity in one go. None of the
+		// entities may already be in the container.
+		void InsertBulk(const std::vector<Entity>& newEntities, const T& component)
+		{
+			for (const Entity& entity : newEntities)
+			{
+				this->sparse.Set(entity.UUID, static_cast<uint32_t>(this->entities.size()));
+				this->entities.push_back(Entity(entity.UUID));
+			}
+
+			this->current.insert(this->current.end(), newEntities.size(), component);
+			this->next.insert(this->next.end(), newEntities.size(), component);
+		}
+
+		// SwapBuffers makes the next frame the current snapshot. See BufferSwap for what the new
+		// next buffer starts out with.
+		void SwapBuffers(BufferSwap mode)
+		{
+			std::swap(this->current, this->next);
+
+			if (mode == BufferSwap::CopyForward)
+			{
+				std::copy(this->current.begin(), this->current.end(), this->next.begin());
+			}
+		}
+
+		void Swap(size_t lhs, size_t rhs) override
+		{
+			if (lhs == rhs)
+			{
+				return;
+			}
+
+			std::swap(this->current[lhs], this->current[rhs]);
+			std::swap(this->next[lhs], this->next[rhs]);
+			std::swap(this->entities[lhs], this->entities[rhs]);
+			this->sparse.Set(this->entities[lhs].UUID, static_cast<uint32_t>(lhs));
+			this->sparse.Set(this->entities[rhs].UUID, static_cast<uint32_t>(rhs));
+		}
+
+		// Sort reorders the slots in [begin, end) by the current snapshot, keeping the relative
+		// order of equal elements. Both buffers move together.
+		template <typename Compare>
+		void Sort(size_t begin, size_t end, Compare compare, SortMode mode)
+		{
+			if (mode == SortMode::Insertion)
+			{
+				for (size_t i = begin + 1; i < end; ++i)
+				{
+					for (size_t j = i; j > begin && compare(this->current[j], this->current[j - 1]); --j)
+					{
+						this->Swap(j, j - 1);
+					}
+				}
+				return;
+			}
+
+			std::vector<size_t> indices(end - begin);
+			std::iota(indices.begin(), indices.end(), begin);
+
+			std::stable_sort(indices.begin(), indices.end(), [&](size_t lhs, size_t rhs) {
+				return compare(this->current[lhs], this->current[rhs]);
+			});
+
+			std::vector<uint32_t> order;
+			order.reserve(indices.size());
+			for (size_t index : indices)
+			{
+				order.push_back(this->entities[index].UUID);
+			}
+
+			this->Arrange(begin, order);
+		}
+
+		// Remove moves the last element into the removed slot. Removing an entity that isn't in
+		// the container does nothing.
+		void Remove(uint32_t uuid) override
+		{
+			if (!this->Contains(uuid))
+			{
+				return;
+			}
+
+			this->Swap(this->sparse[uuid], this->entities.size() - 1);
+
+			this->sparse.Erase(uuid);
+			this->entities.pop_back();
+			this->current.pop_back();
+			this->next.pop_back();
+		}
+	};
+
+	// TagContainer stores components that have no data. It only keeps the packed entity list and the
+	// sparse lookup, and every Get returns the same shared instance, so tagging an entity costs a few
+	// bytes and no component copies.
+	template <typename T>
+	class TagContainer final : public BaseContainer
+	{
+		static_assert(std::is_empty_v<T>, "tag_storage is only for components without data");
+
+	public:
+		TagContainer() {};
+		virtual ~TagContainer() {};
+
+		std::unique_ptr<BaseContainer> Clone() const override
+		{
+			if constexpr (std::is_copy_constructible_v<T>)
+			{
+				return std::make_unique<TagContainer>(*this);
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+		std::unique_ptr<BaseContainer> CreateEmpty() const override
+		{
+			return std::make_unique<TagContainer>();
+		}
+
+		bool IsCopyable() const override
+		{
+			return std::is_copy_constructible_v<T>;
+		}
+
+		bool IsHashable() const override
+		{
+			return is_hashable_component_v<T>;
+		}
+
+		void MoveInto(BaseContainer& target, const std::vector<uint32_t>& from, const std::vector<Entity>& to) override
+		{
+			TagContainer& other = static_cast<TagContainer&>(target);
+			for (size_t i = 0; i < from.size(); ++i)
+			{
+				if (this->Contains(from[i]))
+				{
+					other.Insert(to[i], this->value);
+				}
+			}
+		}
+
+		std::vector<Entity> entities;
+		SparseTable sparse;
+
+		size_t Size() const override
+		{
+			return this->entities.size();
+		}
+
+		const Entity* Entities() const override
+		{
+			return this->entities.data();
+		}
+
+		uint64_t Hash() const override
+		{
+			uint64_t sum = 0;
+			for (const Entity& entity : this->entities)
+			{
+				sum += HashComponent(entity.UUID, this->value);
+			}
+			return sum;
+		}
+
+		bool Contains(uint32_t uuid) const override
+		{
+			return this->sparse.Contains(uuid);
+		}
+
+		// IndexOf assumes the entity is in the container, check with Contains first.
+		size_t IndexOf(uint32_t uuid) const override
+		{
+			return this->sparse[uuid];
+		}
+
+		Entity EntityAt(size_t index) const override
+		{
+			return this->entities[index];
+		}
+
+		// Get returns the shared instance if the entity has the tag, or nullptr if it doesn't.
+		T* Get(uint32_t uuid)
+		{
+			return this->Contains(uuid) ? &this->value : nullptr;
+		}
+
+		const T* Get(uint32_t uuid) const
+		{
+			return this->Contains(uuid) ? &this->value : nullptr;
+		}
+
+		T& Insert(Entity entity, T)
+		{
+			if (!this->Contains(entity.UUID))
+			{
+				this->sparse.Set(entity.UUID, static_cast<uint32_t>(this->entities.size()));
+				this->entities.push_back(Entity(entity.UUID));
+			}
+
+			return this->value;
+		}
+
+		// InsertBulk tags every entity in one go. None of the entities may already be in the container.
+		void InsertBulk(const std::vector<Entity>& newEntities, const T&)
+		{
+			this->entities.reserve(this->entities.size() + newEntities.size());
+			for (const Entity& entity : newEntities)
+			{
+				this->Insert(entity, this->value);
+			}
+		}
+
+		void Swap(size_t lhs, size_t rhs) override
+		{
+			std::swap(this->entities[lhs], this->entities[rhs]);
+			this->sparse.Set(this->entities[lhs].UUID, static_cast<uint32_t>(lhs));
+			this->sparse.Set(this->entities[rhs].UUID, static_cast<uint32_t>(rhs));
+		}
+
+		// Sort does nothing, every tag compares equal and the sort is stable.
+		template <typename Compare>
+		void Sort(size_t, size_t, Compare, SortMode)
+		{
+		}
+
+		void Remove(uint32_t uuid) override
+		{
+			if (!this->Contains(uuid))
+			{
+				return;
+			}
+
+			this->Swap(this->sparse[uuid], this->entities.size() - 1);
+
+			this->sparse.Erase(uuid);
+			this->entities.pop_back();
+		}
+
+	private:
+		T value;
+	};
+
+	// PagedContainer keeps components in fixed-size pages that are never reallocated, so adding
+	// components never copies the ones already there.
+	//
+	// With Stable false the pages are packed like ComponentContainer: removal moves the last
+	// component into the hole, and sorting moves components around. With Stable true each entity
+	// keeps the slot its component was constructed in until it's removed, and the packed order is
+	// kept in a separate slot list, so pointers returned by Get stay valid through any other
+	// insertion, removal or sort. Freed slots are reused by later insertions.
+	template <typename T, bool Stable>
+	class PagedContainer final : public BaseContainer
+	{
+	public:
+		// PageSize is the number of components per page: a power of two that fills about 16KB.
+		static constexpr size_t PageSize = [] {
+			size_t size = 1;
+			while (size * 2 * sizeof(T) <= 16384)
+			{
+				size *= 2;
+			}
+			return size;
+		}();
+
+		PagedContainer() {};
+		// copying shares every page with the original until one of them writes to it, see
+		// PageRefCount. The entity list and the slot bookkeeping are copied.
+		PagedContainer(const PagedContainer& other)
+			: entities(other.entities), sparse(other.sparse), pages(other.pages), slots(other.slots), freeSlots(other.freeSlots), slotCount(other.slotCount)
+		{
+			for (Page* page : this->pages)
+			{
+				page->refs.Acquire();
+			}
+		}
+
+		PagedContainer& operator=(const PagedContainer&) = delete;
+
+		virtual ~PagedContainer()
+		{
+			for (Page* page : this->pages)
+			{
+				ReleasePage(page);
+			}
+		}
+
+		std::unique_ptr<BaseContainer> Clone() const override
+		{
+			if constexpr (std::is_copy_constructible_v<T>)
+			{
+				return std::make_unique<PagedContainer>(*this);
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+		std::unique_ptr<BaseContainer> CreateEmpty() const override
+		{
+			return std::make_unique<PagedContainer>();
+		}
+
+		bool IsCopyable() const override
+		{
+			return std::is_copy_constructible_v<T>;
+		}
+
+		bool IsHashable() const override
+		{
+			return is_hashable_component_v<T>;
+		}
+
+		void MoveInto(BaseContainer& target, const std::vector<uint32_t>& from, const std::vector<Entity>& to) override
+		{
+			PagedContainer& other = static_cast<PagedContainer&>(target);
+			for (size_t i = 0; i < from.size(); ++i)
+			{
+				if (T* component = this->Get(from[i]))
+				{
+					other.Insert(to[i], std::move(*component));
+				}
+			}
+		}
+
+		std::vector<Entity> entities;
+		SparseTable sparse;
+
+		size_t Size() const override
+		{
+			return this->entities.size();
+		}
+
+		const Entity* Entities() const override
+		{
+			return this->entities.data();
+		}
+
+		uint64_t Hash() const override
+		{
+			uint64_t sum = 0;
+			for (size_t i = 0; i < this->entities.size(); ++i)
+			{
+				sum += HashComponent(this->entities[i].UUID, this->At(this->SlotOf(i)));
+			}
+			return sum;
+		}
+
+		bool Contains(uint32_t uuid) const override
+		{
+			return this->sparse.Contains(uuid);
+		}
+
+		// IndexOf assumes the entity is in the container, check with Contains first.
+		size_t IndexOf(uint32_t uuid) const override
+		{
+			return this->sparse[uuid];
+		}
+
+		Entity EntityAt(size_t index) const override
+		{
+			return this->entities[index];
+		}
+
+		// Get returns a pointer to the entity's component data, or nullptr if it has none. With
+		// Stable the pointer is valid until the component is removed, otherwise until the next
+		// removal or reordering of this container.
+		T* Get(uint32_t uuid)
+		{
+			if (!this->Contains(uuid))
+			{
+				return nullptr;
+			}
+
+			return &this->At(this->SlotOf(this->sparse[uuid]));
+		}
+
+		// The const Get never copies a page shared with a fork.
+		const T* Get(uint32_t uuid) const
+		{
+			return this->Contains(uuid) ? &this->At(this->SlotOf(this->sparse[uuid])) : nullptr;
+		}
+
+		// Insert constructs the component in a free slot, or overwrites the existing data if the
+		// entity already has this component.
+		T& Insert(Entity entity, T component)
+		{
+			if (this->Contains(entity.UUID))
+			{
+				T& existing = this->At(this->SlotOf(this->sparse[entity.UUID]));
+				existing = std::move(component);
+				return existing;
+			}
+
+			size_t slot = this->AllocateSlot();
+			Page* page = this->Writable(slot / PageSize);
+			T* constructed = ::new (static_cast<void*>(page->Slot(slot % PageSize))) T(std::move(component));
+			page->live[slot % PageSize / 64] |= uint64_t(1) << (slot % PageSize % 64);
+
+			this->sparse.Set(entity.UUID, static_cast<uint32_t>(this->entities.size()));
+			this->entities.push_back(Entity(entity.UUID));
+			if constexpr (Stable)
+			{
+				this->slots.push_back(static_cast<uint32_t>(slot));
+			}
+
+			return *constructed;
+		}
+
+		// InsertBulk adds the same component value for every entity. None of the entities may
+		// already be in the container.
+		void InsertBulk(const std::vector<Entity>& newEntities, const T& component)
+		{
+			this->entities.reserve(this->entities.size() + newEntities.size());
+			for (const Entity& entity : newEntities)
+			{
+				this->Insert(entity, component);
+			}
+		}
+
+		void Swap(size_t lhs, size_t rhs) override
+		{
+			if (lhs == rhs)
+			{
+				return;
+			}
+
+			if constexpr (Stable)
+			{
+				std::swap(this->slots[lhs], this->slots[rhs]);
+			}
+			else
+			{
+				std::swap(this->At(lhs), this->At(rhs));
+			}
+
+			std::swap(this->entities[lhs], this->entities[rhs]);
+			this->sparse.Set(this->entities[lhs].UUID, static_cast<uint32_t>(lhs));
+			this->sparse.Set(this->entities[rhs].UUID, static_cast<uint32_t>(rhs));
+		}
+
+		// Sort reorders the slots in [begin, end) so that compare(a, b) never fails for neighbours,
+		// keeping the relative order of equal elements. With Stable only the packed order changes,
+		// the components themselves stay where they are.
+		template <typename Compare>
+		void Sort(size_t begin, size_t end, Compare compare, SortMode mode)
+		{
+			// comparing only reads, so pages shared with a fork stay shared unless components move
+			const PagedContainer& self = *this;
+			this->SortSlots(begin, end, [&](size_t lhs, size_t rhs) {
+				return compare(self.At(self.SlotOf(lhs)), self.At(self.SlotOf(rhs)));
+			}, mode);
+		}
+
+		// Remove destroys the entity's component and moves the last entity into its packed slot.
+		// Removing an entity that isn't in the container does nothing.
+		void Remove(uint32_t uuid) override
+		{
+			if (!this->Contains(uuid))
+			{
+				return;
+			}
+
+			size_t last = this->entities.size() - 1;
+			this->Swap(this->sparse[uuid], last);
+
+			size_t slot = this->SlotOf(last);
+			Page* page = this->Writable(slot / PageSize);
+			std::launder(reinterpret_cast<T*>(page->Slot(slot % PageSize)))->~T();
+			page->live[slot % PageSize / 64] &= ~(uint64_t(1) << (slot % PageSize % 64));
+			if constexpr (Stable)
+			{
+				this->slots.pop_back();
+				this->freeSlots.push_back(static_cast<uint32_t>(slot));
+			}
+
+			this->sparse.Erase(uuid);
+			this->entities.pop_back();
+		}
+
+	private:
+		// Page holds PageSize slots, live marks the ones holding a component so a page shared
+		// between copies can be copied and destroyed on its own, without the container it came from.
+		struct alignas(AlignedAllocator<T>::alignment) Page
+		{
+			unsigned char bytes[sizeof(T) * PageSize];
+			uint64_t live[(PageSize + 63) / 64] = {};
+			PageRefCount refs;
+
+			// default-initialised, there's no point zeroing memory that components are built in
+			Page() {}
+
+			Page(const Page& other)
+			{
+				std::copy(std::begin(other.live), std::end(other.live), std::begin(this->live));
+				this->Each([&](size_t slot) {
+					::new (this->Slot(slot)) T(*std::launder(reinterpret_cast<const T*>(other.Slot(slot))));
+				});
+			}
+
+			Page& operator=(const Page&) = delete;
+
+			~Page()
+			{
+				this->Each([&](size_t slot) {
+					std::launder(reinterpret_cast<T*>(this->Slot(slot)))->~T();
+				});
+			}
+
+			void* Slot(size_t slot)
+			{
+				return this->bytes + slot * sizeof(T);
+			}
+
+			const void* Slot(size_t slot) const
+			{
+				return this->bytes + slot * sizeof(T);
+			}
+
+			template <typename Func>
+			void Each(Func func) const
+			{
+				for (size_t slot = 0; slot < PageSize; ++slot)
+				{
+					if ((this->live[slot / 64] >> (slot % 64) & 1) != 0)
+					{
+						func(slot);
+					}
+				}
+			}
+		};
+
+		std::vector<Page*> pages;
+
+		// slots[i] is where the component of entities[i] lives, only used with Stable
+		std::vector<uint32_t> slots;
+		std::vector<uint32_t> freeSlots;
+		size_t slotCount = 0;
+
+		// At copies the slot's page first if it's shared with a fork, the const At never does.
+		T& At(size_t slot)
+		{
+			return *std::launder(reinterpret_cast<T*>(this->Writable(slot / PageSize)->bytes) + slot % PageSize);
+		}
+
+		const T& At(size_t slot) const
+		{
+			return *std::launder(reinterpret_cast<const T*>(this->pages[slot / PageSize]->bytes) + slot % PageSize);
+		}
+
+		size_t SlotOf(size_t index) const
+		{
+			if constexpr (Stable)
+			{
+				return this->slots[index];
+			}
+			else
+			{
+				return index;
+			}
+		}
+
+		// AllocateSlot returns uninitialised storage for one component, adding a page if needed.
+		size_t AllocateSlot()
+		{
+			if constexpr (Stable)
+			{
+				if (!this->freeSlots.empty())
+				{
+					size_t slot = this->freeSlots.back();
+					this->freeSlots.pop_back();
+					return slot;
+				}
+			}
+
+			size_t slot = Stable ? this->slotCount++ : this->entities.size();
+			if (slot / PageSize >= this->pages.size())
+			{
+				this->pages.push_back(new Page);
+			}
+
+			return slot;
+		}
+
+		// Writable returns the page ready to be written, copying it first if it's shared. Pages of
+		// components that can't be copied are never shared, since Clone refuses to copy the pool.
+		Page* Writable(size_t page)
+		{
+			if constexpr (std::is_copy_constructible_v<T>)
+			{
+				return OwnPage(this->pages[page]);
+			}
+			else
+			{
+				return this->pages[page];
+			}
+		}
+	};
+
+	// MapContainer keeps components in a hash map keyed by UUID, for components so rare that a
+	// sparse array with a slot for every UUID would be mostly empty. Lookups cost a hash instead of
+	// an indexed load. The packed entity list is kept as usual so queries can walk the pool.
+	//
+	// Pointers returned by Get stay valid until the component is removed.
+	template <typename T>
+	class MapContainer final : public BaseContainer
+	{
+	public:
+		MapContainer() {};
+		virtual ~MapContainer() {};
+
+		std::unique_ptr<BaseContainer> Clone() const override
+		{
+			if constexpr (std::is_copy_constructible_v<T>)
+			{
+				return std::make_unique<MapContainer>(*this);
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+		std::unique_ptr<BaseContainer> CreateEmpty() const override
+		{
+			return std::make_unique<MapContainer>();
+		}
+
+		bool IsCopyable() const override
+		{
+			return std::is_copy_constructible_v<T>;
+		}
+
+		bool IsHashable() const override
+		{
+			return is_hashable_component_v<T>;
+		}
+
+		void MoveInto(BaseContainer& target, const std::vector<uint32_t>& from, const std::vector<Entity>& to) override
+		{
+			MapContainer& other = static_cast<MapContainer&>(target);
+			for (size_t i = 0; i < from.size(); ++i)
+			{
+				if (T* component = this->Get(from[i]))
+				{
+					other.Insert(to[i], std::move(*component));
+				}
+			}
+		}
+
+		std::vector<Entity> entities;
+
+		size_t Size() const override
+		{
+			return this->entities.size();
+		}
+
+		const Entity* Entities() const override
+		{
+			return this->entities.data();
+		}
+
+		uint64_t Hash() const override
+		{
+			uint64_t sum = 0;
+			for (const auto& entry : this->entries)
+			{
+				sum += HashComponent(entry.first, entry.second.value);
+			}
+			return sum;
+		}
+
+		bool Contains(uint32_t uuid) const override
+		{
+			return this->entries.find(uuid) != this->entries.end();
+		}
+
+		// IndexOf assumes the entity is in the container, check with Contains first.
+		size_t IndexOf(uint32_t uuid) const override
+		{
+			return this->entries.find(uuid)->second.index;
+		}
+
+		Entity EntityAt(size_t index) const override
+		{
+			return this->entities[index];
+		}
+
+		// Get returns a pointer to the entity's component data, or nullptr if it has none.
+		T* Get(uint32_t uuid)
+		{
+			auto entry = this->entries.find(uuid);
+			return entry != this->entries.end() ? &entry->second.value : nullptr;
+		}
+
+		const T* Get(uint32_t uuid) const
+		{
+			auto entry = this->entries.find(uuid);
+			return entry != this->entries.end() ? &entry->second.value : nullptr;
+		}
+
+		// Insert adds the component, or overwrites the existing data if the entity already has it.
+		T& Insert(Entity entity, T component)
+		{
+			auto entry = this->entries.find(entity.UUID);
+			if (entry != this->entries.end())
+			{
+				entry->second.value = std::move(component);
+				return entry->second.value;
+			}
+
+			entry = this->entries.emplace(entity.UUID, Entry{ this->entities.size(), std::move(component) }).first;
+			this->entities.push_back(Entity(entity.UUID));
+			return entry->second.value;
+		}
+
+		// InsertBulk adds the same component value for every entity. None of the entities may
+		// already be in the container.
+		void InsertBulk(const std::vector<Entity>& newEntities, const T& component)
+		{
+			this->entries.reserve(this->entries.size() + newEntities.size());
+			this->entities.reserve(this->entities.size() + newEntities.size());
+			for (const Entity& entity : newEntities)
+			{
+				this->Insert(entity, component);
+			}
+		}
+
+		void Swap(size_t lhs, size_t rhs) override
+		{
+			if (lhs == rhs)
+			{
+				return;
+			}
+
+			std::swap(this->entities[lhs], this->entities[rhs]);
+			this->entries.find(this->entities[lhs].UUID)->second.index = lhs;
+			this->entries.find(this->entities[rhs].UUID)->second.index = rhs;
+		}
+
+		// Sort reorders the packed entities in [begin, end) so that compare(a, b) never fails for
+		// neighbours, keeping the relative order of equal elements. The components don't move.
+		template <typename Compare>
+		void Sort(size_t begin, size_t end, Compare compare, SortMode mode)
+		{
+			this->SortSlots(begin, end, [&](size_t lhs, size_t rhs) {
+				return compare(*this->Get(this->entities[lhs].UUID), *this->Get(this->entities[rhs].UUID));
+			}, mode);
+		}
+
+		// Remove moves the last entity into the removed slot. Removing an entity that isn't in the
+		// container does nothing.
+		void Remove(uint32_t uuid) override
+		{
+			auto entry = this->entries.find(uuid);
+			if (entry == this->entries.end())
+			{
+				return;
+			}
+
+			this->Swap(entry->second.index, this->entities.size() - 1);
+			this->entries.erase(entry);
+			this->entities.pop_back();
+		}
+
+	private:
+		struct Entry
+		{
+			size_t index;
+			T value;
+		};
+
+		std::unordered_map<uint32_t, Entry> entries;
+	};
+
+	template <typename T, typename Policy = storage_policy_t<T>>
+	struct StorageFor;
+
+	template <typename T>
+	struct StorageFor<T, dense_storage>
+	{
+		using type = ComponentContainer<T>;
+	};
+
+	template <typename T>
+	struct StorageFor<T, soa_storage>
+	{
+		using type = SoAContainer<T>;
+	};
+
+	template <typename T>
+	struct StorageFor<T, double_buffered_storage>
+	{
+		using type = DoubleBufferedContainer<T>;
+	};
+
+	template <typename T>
+	struct StorageFor<T, paged_storage>
+	{
+		using type = PagedContainer<T, false>;
+	};
+
+	template <typename T>
+	struct StorageFor<T, stable_storage>
+	{
+		using type = PagedContainer<T, true>;
+	};
+
+	template <typename T>
+	struct StorageFor<T, tag_storage>
+	{
+		using type = TagContainer<T>;
+	};
+
+	template <typename T>
+	struct StorageFor<T, map_storage>
+	{
+		using type = MapContainer<T>;
+	};
+
+	// Storage is the container ECSManager keeps T in, picked by component_traits<T>::storage.
+	// Everything ECSManager does with a component goes through this type, so the calls resolve at
+	// compile time to the chosen container.
+	template <typename T>
+	using Storage = typename StorageFor<T>::type;
+}
@@ -0,0 +1,393 @@
+#include "doctest.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "ComponentContainer.hpp"
+
+struct Position
+{
+	int x;
+	int y;
+};
+
+struct Particle
+{
+	float x;
+	float y;
+	int id;
+};
+
+struct Heading
+{
+	float angle;
+	int turns;
+};
+
+namespace babs_ecs
+{
+	template <>
+	struct soa_layout<Particle>
+	{
+		using fields = soa_fields<&Particle::x, &Particle::y, &Particle::id>;
+	};
+
+	template <>
+	struct soa_layout<Heading>
+	{
+		using fields = soa_fields<&Heading::angle, &Heading::turns>;
+	};
+
+	// treats -0.0f and 0.0f as the same angle
+	template <>
+	struct component_hash<Heading>
+	{
+		uint64_t operator()(const Heading& heading, uint64_t seed) const
+		{
+			float angle = heading.angle == 0.0f ? 0.0f : heading.angle;
+			return HashMix(HashBytes(&angle, sizeof(angle), seed), uint64_t(heading.turns));
+		}
+	};
+}
+
+TEST_SUITE("Component Container")
+{
+	TEST_CASE("Insert packs component data and Get finds it")
+	{
+		babs_ecs::ComponentContainer<Position> container;
+
+		container.Insert(babs_ecs::Entity(7), Position{ 1, 2 });
+		container.Insert(babs_ecs::Entity(3), Position{ 3, 4 });
+
+		REQUIRE(container.Size() == 2);
+		REQUIRE(container.Contains(7));
+		REQUIRE(container.Contains(3));
+		REQUIRE(container.Contains(4) == false);
+		REQUIRE(container.Contains(100) == false);
+
+		REQUIRE(container.Get(7)->x == 1);
+		REQUIRE(container.Get(3)->y == 4);
+		REQUIRE(container.Get(4) == nullptr);
+
+		REQUIRE(container.EntityAt(0).UUID == 7);
+		REQUIRE(container.EntityAt(1).UUID == 3);
+	}
+
+	TEST_CASE("Insert on an existing entity overwrites the data")
+	{
+		babs_ecs::ComponentContainer<Position> container;
+
+		container.Insert(babs_ecs::Entity(1), Position{ 1, 1 });
+		container.Insert(babs_ecs::Entity(1), Position{ 5, 5 });
+
+		REQUIRE(container.Size() == 1);
+		REQUIRE(container.Get(1)->x == 5);
+	}
+
+	TEST_CASE("Remove swaps the last element into the hole")
+	{
+		babs_ecs::ComponentContainer<Position> container;
+
+		container.Insert(babs_ecs::Entity(1), Position{ 1, 0 });
+		container.Insert(babs_ecs::Entity(2), Position{ 2, 0 });
+		container.Insert(babs_ecs::Entity(3), Position{ 3, 0 });
+
+		container.Remove(1);
+
+		REQUIRE(container.Size() == 2);
+		REQUIRE(container.Contains(1) == false);
+		REQUIRE(container.IndexOf(3) == 0);
+		REQUIRE(container.Get(3)->x == 3);
+		REQUIRE(container.Get(2)->x == 2);
+
+		// removing something that isn't there is a no-op
+		container.Remove(1);
+		container.Remove(42);
+		REQUIRE(container.Size() == 2);
+	}
+
+	TEST_CASE("Swap keeps the entity mapping in sync")
+	{
+		babs_ecs::ComponentContainer<Position> container;
+
+		container.Insert(babs_ecs::Entity(1), Position{ 1, 0 });
+		container.Insert(babs_ecs::Entity(2), Position{ 2, 0 });
+
+		container.Swap(0, 1);
+
+		REQUIRE(container.EntityAt(0).UUID == 2);
+		REQUIRE(container.IndexOf(1) == 1);
+		REQUIRE(container.Get(1)->x == 1);
+		REQUIRE(container.data[0].x == 2);
+	}
+
+	TEST_CASE("InsertBulk appends copies for every entity")
+	{
+		babs_ecs::ComponentContainer<Position> container;
+		container.Insert(babs_ecs::Entity(2), Position{ 0, 0 });
+
+		std::vector<babs_ecs::Entity> entities;
+		for (uint32_t i = 10; i < 47; ++i)
+		{
+			entities.push_back(babs_ecs::Entity(i));
+		}
+
+		container.InsertBulk(entities, Position{ 7, 8 });
+
+		REQUIRE(container.Size() == 38);
+		REQUIRE(container.Get(2)->x == 0);
+		for (auto e : entities)
+		{
+			REQUIRE(container.Get(e.UUID)->x == 7);
+			REQUIRE(container.Get(e.UUID)->y == 8);
+		}
+		REQUIRE(container.EntityAt(37).UUID == 46);
+	}
+
+	TEST_CASE("Array is aligned and padded for SIMD loads")
+	{
+		babs_ecs::ComponentContainer<Position> container;
+
+		for (uint32_t uuid = 1; uuid <= 5; ++uuid)
+		{
+			container.Insert(babs_ecs::Entity(uuid), Position{ static_cast<int>(uuid), 0 });
+		}
+
+		babs_ecs::ComponentArray<Position> array = container.Array();
+		REQUIRE(array.size == 5);
+		REQUIRE(reinterpret_cast<uintptr_t>(array.data) % BABS_ECS_ALIGNMENT == 0);
+		REQUIRE(array.PaddedSize() == BABS_ECS_ALIGNMENT / sizeof(Position));
+		REQUIRE(array.entities[4].UUID == 5);
+
+		int sum = 0;
+		for (Position& p : array)
+		{
+			sum += p.x;
+		}
+		REQUIRE(sum == 15);
+	}
+}
+
+TEST_SUITE("SoA Container")
+{
+	TEST_CASE("Components are split into one aligned array per member")
+	{
+		REQUIRE(babs_ecs::is_soa_v<Particle>);
+		REQUIRE_FALSE(babs_ecs::is_soa_v<Position>);
+
+		babs_ecs::SoAContainer<Particle> container;
+		container.Insert(babs_ecs::Entity(4), Particle{ 1.0f, 2.0f, 40 });
+		container.Insert(babs_ecs::Entity(2), Particle{ 3.0f, 4.0f, 20 });
+
+		REQUIRE(container.Size() == 2);
+		REQUIRE(container.Contains(4));
+		REQUIRE_FALSE(container.Contains(3));
+
+		float* x = container.Field<&Particle::x>();
+		int* id = container.Field<&Particle::id>();
+		REQUIRE(reinterpret_cast<uintptr_t>(x) % BABS_ECS_ALIGNMENT == 0);
+		REQUIRE(reinterpret_cast<uintptr_t>(id) % BABS_ECS_ALIGNMENT == 0);
+		REQUIRE(x[1] == 3.0f);
+		REQUIRE(id[0] == 40);
+
+		Particle loaded = container.Load(container.IndexOf(2));
+		REQUIRE(loaded.y == 4.0f);
+		REQUIRE(loaded.id == 20);
+
+		// inserting again overwrites every member
+		container.Insert(babs_ecs::Entity(4), Particle{ 5.0f, 6.0f, 41 });
+		REQUIRE(container.Size() == 2);
+		REQUIRE(container.Load(0).x == 5.0f);
+		REQUIRE(container.Load(0).id == 41);
+	}
+
+	TEST_CASE("Remove and Sort keep every member array in step")
+	{
+		babs_ecs::SoAContainer<Particle> container;
+		container.Insert(babs_ecs::Entity(1), Particle{ 3.0f, 0.0f, 1 });
+		container.Insert(babs_ecs::Entity(2), Particle{ 1.0f, 0.0f, 2 });
+		container.Insert(babs_ecs::Entity(3), Particle{ 2.0f, 0.0f, 3 });
+		container.Insert(babs_ecs::Entity(4), Particle{ 0.0f, 0.0f, 4 });
+
+		container.Remove(1);
+		REQUIRE(container.Size() == 3);
+		REQUIRE_FALSE(container.Contains(1));
+		REQUIRE(container.Load(container.IndexOf(4)).id == 4);
+
+		container.Sort(0, container.Size(), [](const Particle& lhs, const Particle& rhs) { return lhs.x < rhs.x; }, babs_ecs::SortMode::Full);
+
+		float* x = container.Field<&Particle::x>();
+		int* id = container.Field<&Particle::id>();
+		REQUIRE(x[0] == 0.0f);
+		REQUIRE(x[1] == 1.0f);
+		REQUIRE(x[2] == 2.0f);
+		REQUIRE(id[0] == 4);
+		REQUIRE(id[2] == 3);
+		REQUIRE(container.EntityAt(1).UUID == 2);
+		REQUIRE(container.IndexOf(3) == 2);
+	}
+
+	TEST_CASE("Hash goes through component_hash when it's specialized")
+	{
+		REQUIRE(babs_ecs::has_component_hash_v<Heading>);
+		REQUIRE_FALSE(babs_ecs::has_component_hash_v<Particle>);
+
+		babs_ecs::SoAContainer<Heading> positive;
+		babs_ecs::SoAContainer<Heading> negative;
+		positive.Insert(babs_ecs::Entity(1), Heading{ 0.0f, 2 });
+		negative.Insert(babs_ecs::Entity(1), Heading{ -0.0f, 2 });
+
+		REQUIRE(positive.Hash() == babs_ecs::HashComponent(1, Heading{ 0.0f, 2 }));
+		REQUIRE(positive.Hash() == negative.Hash());
+
+		negative.Insert(babs_ecs::Entity(1), Heading{ -0.0f, 3 });
+		REQUIRE(positive.Hash() != negative.Hash());
+
+		// without one, the members are hashed byte for byte
+		babs_ecs::SoAContainer<Particle> first;
+		babs_ecs::SoAContainer<Particle> second;
+		first.Insert(babs_ecs::Entity(1), Particle{ 0.0f, 1.0f, 1 });
+		second.Insert(babs_ecs::Entity(1), Particle{ -0.0f, 1.0f, 1 });
+		REQUIRE(first.Hash() != second.Hash());
+	}
+}
+
+TEST_SUITE("Double Buffered Container")
+{
+	TEST_CASE("Writes go to the next buffer until the buffers are swapped")
+	{
+		babs_ecs::DoubleBufferedContainer<Position> container;
+		container.Insert(babs_ecs::Entity(1), Position{ 1, 1 });
+		container.Insert(babs_ecs::Entity(2), Position{ 2, 2 });
+
+		// new components are readable straight away
+		REQUIRE(container.Read(1)->x == 1);
+		REQUIRE(container.Get(1)->x == 1);
+
+		container.Get(1)->x = 10;
+		REQUIRE(container.Read(1)->x == 1);
+
+		container.SwapBuffers(babs_ecs::BufferSwap::Swap);
+		REQUIRE(container.Read(1)->x == 10);
+		REQUIRE(container.Read(2)->x == 2);
+
+		// a plain swap leaves the older frame in the write buffer
+		REQUIRE(container.Get(1)->x == 1);
+
+		container.Get(2)->x = 20;
+		container.SwapBuffers(babs_ecs::BufferSwap::CopyForward);
+		REQUIRE(container.Read(2)->x == 20);
+		REQUIRE(container.Get(1)->x == 1);
+		REQUIRE(container.Get(2)->x == 20);
+	}
+
+	TEST_CASE("Remove and Sort move both buffers together")
+	{
+		babs_ecs::DoubleBufferedContainer<Position> container;
+		container.Insert(babs_ecs::Entity(1), Position{ 3, 30 });
+		container.Insert(babs_ecs::Entity(2), Position{ 1, 10 });
+		container.Insert(babs_ecs::Entity(3), Position{ 2, 20 });
+		container.Get(2)->y = 11;
+
+		container.Remove(1);
+		REQUIRE(container.Size() == 2);
+		REQUIRE(container.Read(1) == nullptr);
+
+		container.Sort(0, container.Size(), [](const Position& lhs, const Position& rhs) { return lhs.x > rhs.x; }, babs_ecs::SortMode::Full);
+		REQUIRE(container.EntityAt(0).UUID == 3);
+		REQUIRE(container.Read(2)->y == 10);
+		REQUIRE(container.Get(2)->y == 11);
+
+		babs_ecs::BufferedArray<Position> array = container.Array();
+		REQUIRE(array.current[1].y == 10);
+		REQUIRE(array.next[1].y == 11);
+	}
+}
+
+TEST_SUITE("Paged Container")
+{
+	TEST_CASE("Growing the pool doesn't move components")
+	{
+		using Pages = babs_ecs::PagedContainer<Position, false>;
+		Pages container;
+
+		container.Insert(babs_ecs::Entity(1), Position{ 1, 1 });
+		Position* first = container.Get(1);
+		for (uint32_t uuid = 2; uuid < 3 * Pages::PageSize; ++uuid)
+		{
+			container.Insert(babs_ecs::Entity(uuid), Position{ int(uuid), 0 });
+		}
+
+		REQUIRE(container.Get(1) == first);
+		REQUIRE(container.Get(Pages::PageSize + 5)->x == int(Pages::PageSize + 5));
+
+		// removal stays packed, the last component fills the hole
+		container.Remove(1);
+		REQUIRE(container.Get(1) == nullptr);
+		REQUIRE(container.EntityAt(0).UUID == 3 * Pages::PageSize - 1);
+		REQUIRE(container.Get(3 * Pages::PageSize - 1) == first);
+	}
+
+	TEST_CASE("Stable pointers survive removals and sorting")
+	{
+		babs_ecs::PagedContainer<Position, true> container;
+		for (uint32_t uuid = 1; uuid <= 5; ++uuid)
+		{
+			container.Insert(babs_ecs::Entity(uuid), Position{ int(10 - uuid), 0 });
+		}
+
+		Position* fifth = container.Get(5);
+		container.Remove(1);
+		container.Sort(0, container.Size(), [](const Position& lhs, const Position& rhs) { return lhs.x < rhs.x; }, babs_ecs::SortMode::Full);
+
+		REQUIRE(container.Get(5) == fifth);
+		REQUIRE(container.EntityAt(0).UUID == 5);
+		REQUIRE(container.EntityAt(3).UUID == 2);
+
+		// the freed slot is reused
+		Position* reused = &container.Insert(babs_ecs::Entity(9), Position{ 0, 9 });
+		REQUIRE(container.Get(9) == reused);
+		REQUIRE(container.Get(5) == fifth);
+		REQUIRE(container.Size() == 5);
+	}
+}
+
+TEST_SUITE("Tag and Map Containers")
+{
+	struct Selected {};
+
+	TEST_CASE("Tags keep entities but no data")
+	{
+		babs_ecs::TagContainer<Selected> container;
+		container.Insert(babs_ecs::Entity(4), Selected{});
+		container.InsertBulk({ babs_ecs::Entity(2), babs_ecs::Entity(8) }, Selected{});
+
+		REQUIRE(container.Size() == 3);
+		REQUIRE(container.Get(2) == container.Get(8));
+		REQUIRE(container.Get(3) == nullptr);
+
+		container.Remove(4);
+		REQUIRE(container.Size() == 2);
+		REQUIRE(container.EntityAt(0).UUID == 8);
+		REQUIRE(container.IndexOf(8) == 0);
+	}
+
+	TEST_CASE("Map containers only store the entities they hold")
+	{
+		babs_ecs::MapContainer<Position> container;
+		container.Insert(babs_ecs::Entity(1'000'000), Position{ 3, 0 });
+		container.Insert(babs_ecs::Entity(7), Position{ 1, 0 });
+		container.Insert(babs_ecs::Entity(42), Position{ 2, 0 });
+
+		Position* big = container.Get(1'000'000);
+		container.Sort(0, container.Size(), [](const Position& lhs, const Position& rhs) { return lhs.x < rhs.x; }, babs_ecs::SortMode::Insertion);
+		REQUIRE(container.EntityAt(0).UUID == 7);
+		REQUIRE(container.IndexOf(1'000'000) == 2);
+
+		container.Remove(7);
+		REQUIRE_FALSE(container.Contains(7));
+		REQUIRE(container.Get(1'000'000) == big);
+		REQUIRE(container.EntityAt(0).UUID == 1'000'000);
+		REQUIRE(container.IndexOf(42) == 1);
+	}
+}
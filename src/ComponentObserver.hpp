@@ -0,0 +1,117 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+
+#include "ECSManager.hpp"
+#include "Entity.hpp"
+#include "Events.hpp"
+#include "events/EventManager.hpp"
+
+namespace babs_ecs
+{
+	// ComponentObserver follows every event that adds, changes or removes component T and boils
+	// them down to two callbacks, so secondary structures kept outside the manager (spatial grids,
+	// field indexes, ...) don't each have to subscribe to all of them.
+	//
+	// update is called with the component's current value on ComponentAdded<T>, ComponentUpdated<T>
+	// (see ECSManager::Patch), ComponentsAdded<T>, and for the entities of EntitiesCreated that have
+	// a T. remove is called on ComponentRemoved<T>, EntityRemoved, ComponentsRemoved<T> and
+	// EntitiesRemoved, also for entities that never had a T. Writes made directly through
+	// GetComponent don't raise events and aren't observed.
+	//
+	// The observer unsubscribes when it's destroyed. Declare it after anything its callbacks use,
+	// so it goes away first.
+	//
+	// Typical usage, as a member of the structure being kept up to date:
+	//   babs_ecs::ComponentObserver<Position> observer{ ecs,
+	//       [this](babs_ecs::Entity e, const Position& p) { this->Insert(e, p); },
+	//       [this](babs_ecs::Entity e) { this->Erase(e); } };
+	template <typename T>
+	class ComponentObserver
+	{
+	public:
+		using UpdateHandler = std::function<void(Entity, const T&)>;
+		using RemoveHandler = std::function<void(Entity)>;
+
+		ComponentObserver(ECSManager& ecs, UpdateHandler update, RemoveHandler remove);
+		~ComponentObserver();
+
+		ComponentObserver(const ComponentObserver&) = delete;
+		ComponentObserver& operator=(const ComponentObserver&) = delete;
+
+	private:
+		ECSManager& ecs;
+		UpdateHandler update;
+		RemoveHandler remove;
+
+		events::EventManager::SubscriptionId addedId;
+		events::EventManager::SubscriptionId updatedId;
+		events::EventManager::SubscriptionId removedId;
+		events::EventManager::SubscriptionId entityRemovedId;
+		events::EventManager::SubscriptionId componentsAddedId;
+		events::EventManager::SubscriptionId componentsRemovedId;
+		events::EventManager::SubscriptionId entitiesRemovedId;
+		events::EventManager::SubscriptionId entitiesCreatedId;
+	};
+
+	template <typename T>
+	inline ComponentObserver<T>::ComponentObserver(ECSManager& ecs, UpdateHandler update, RemoveHandler remove)
+		: ecs(ecs), update(std::move(update)), remove(std::move(remove))
+	{
+		this->addedId = ecs.events.Subscribe<ComponentAdded<T>>([this](const ComponentAdded<T>& e) {
+			this->update(e.entity, e.component);
+		});
+		this->updatedId = ecs.events.Subscribe<ComponentUpdated<T>>([this](const ComponentUpdated<T>& e) {
+			this->update(e.entity, e.component);
+		});
+		this->removedId = ecs.events.Subscribe<ComponentRemoved<T>>([this](const ComponentRemoved<T>& e) {
+			this->remove(e.entity);
+		});
+		this->entityRemovedId = ecs.events.Subscribe<EntityRemoved>([this](const EntityRemoved& e) {
+			this->remove(e.entity);
+		});
+		this->componentsAddedId = ecs.events.Subscribe<ComponentsAdded<T>>([this](const ComponentsAdded<T>& e) {
+			for (const Entity& entity : e.entities)
+			{
+				this->update(entity, e.component);
+			}
+		});
+		this->componentsRemovedId = ecs.events.Subscribe<ComponentsRemoved<T>>([this](const ComponentsRemoved<T>& e) {
+			for (const Entity& entity : e.entities)
+			{
+				this->remove(entity);
+			}
+		});
+		this->entitiesRemovedId = ecs.events.Subscribe<EntitiesRemoved>([this](const EntitiesRemoved& e) {
+			for (const Entity& entity : e.entities)
+			{
+				this->remove(entity);
+			}
+		});
+		this->entitiesCreatedId = ecs.events.Subscribe<EntitiesCreated>([this](const EntitiesCreated& e) {
+			for (const Entity& entity : e.entities)
+			{
+				// only reads, so a shared pool isn't copied (see ECSManager::Fork)
+				const T* component = this->ecs.ReadComponent<T>(entity);
+				if (component != nullptr)
+				{
+					this->update(entity, *component);
+				}
+			}
+		});
+	}
+
+	template <typename T>
+	inline ComponentObserver<T>::~ComponentObserver()
+	{
+		this->ecs.events.Unsubscribe<ComponentAdded<T>>(this->addedId);
+		this->ecs.events.Unsubscribe<ComponentUpdated<T>>(this->updatedId);
+		this->ecs.events.Unsubscribe<ComponentRemoved<T>>(this->removedId);
+		this->ecs.events.Unsubscribe<EntityRemoved>(this->entityRemovedId);
+		this->ecs.events.Unsubscribe<ComponentsAdded<T>>(this->componentsAddedId);
+		this->ecs.events.Unsubscribe<ComponentsRemoved<T>>(this->componentsRemovedId);
+		this->ecs.events.Unsubscribe<EntitiesRemoved>(this->entitiesRemovedId);
+		this->ecs.events.Unsubscribe<EntitiesCreated>(this->entitiesCreatedId);
+	}
+}
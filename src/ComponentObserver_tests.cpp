@@ -0,0 +1,77 @@
+#include "doctest.h"
+
+#include <map>
+
+#include "ComponentObserver.hpp"
+#include "ECSManager.hpp"
+#include "Prefab.hpp"
+
+namespace
+{
+	struct Position
+	{
+		float x;
+		float y;
+	};
+
+	// Mirror keeps the x of every observed Position, like an index would
+	struct Mirror
+	{
+		Mirror(babs_ecs::ECSManager& ecs)
+			: observer(ecs, [this](babs_ecs::Entity e, const Position& p) { this->x[e.UUID] = p.x; }, [this](babs_ecs::Entity e) { this->x.erase(e.UUID); }) {}
+
+		std::map<uint32_t, float> x;
+		babs_ecs::ComponentObserver<Position> observer;
+	};
+}
+
+TEST_SUITE("Component observers")
+{
+	TEST_CASE("Observers see single and bulk changes")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		ecs.RegisterComponent<int>();
+		Mirror mirror(ecs);
+
+		babs_ecs::Entity a = ecs.CreateEntity();
+		ecs.AddComponent(a, Position{ 1.0f, 0.0f });
+		ecs.Patch<Position>(a, [](Position& p) { p.x = 2.0f; });
+		REQUIRE(mirror.x == std::map<uint32_t, float>{ { a.UUID, 2.0f } });
+
+		ecs.RemoveComponent<Position>(a);
+		REQUIRE(mirror.x.empty());
+
+		babs_ecs::Prefab prefab;
+		prefab.Set(Position{ 3.0f, 0.0f });
+		ecs.Instantiate(prefab, 4);
+		REQUIRE(mirror.x.size() == 4);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			ecs.AddComponent(ecs.CreateEntity(), i);
+		}
+		ecs.AddToAll<int>(Position{ 4.0f, 0.0f });
+		REQUIRE(mirror.x.size() == 7);
+
+		ecs.DestroyAll<int>();
+		REQUIRE(mirror.x.size() == 4);
+
+		ecs.Clear<Position>();
+		REQUIRE(mirror.x.empty());
+	}
+
+	TEST_CASE("Observers stop listening once destroyed")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+
+		{
+			Mirror mirror(ecs);
+		}
+
+		babs_ecs::Entity e = ecs.CreateEntity();
+		CHECK_NOTHROW(ecs.AddComponent(e, Position{ 0.0f, 0.0f }));
+		CHECK_NOTHROW(ecs.RemoveEntity(e));
+	}
+}
@@ -1,6 +1,15 @@
 #pragma once
 
+#include "Collector.hpp"
+#include "ComponentObserver.hpp"
 #include "ECSManager.hpp"
 #include "Entity.hpp"
 #include "Events.hpp"
 #include "Exceptions.hpp"
+#include "Group.hpp"
+#include "Layout.hpp"
+#include "Prefab.hpp"
+#include "QueryCursor.hpp"
+#include "Relationship.hpp"
+#include "Resources.hpp"
+#include "SpawnBuffer.hpp"
@@ -1,22 +1,58 @@
 #pragma once
 
 #include <string>
-#include <map>
-#include <iostream>
 #include <stdexcept>
-#include <set>
 #include <typeinfo>
 #include <vector>
-#include <tuple>
+#include <array>
 #include <algorithm>
-#include <queue>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <utility>
 
 #include "bitfield/bitfield.hpp"
+#include "Collector.hpp"
+#include "ComponentContainer.hpp"
 #include "Exceptions.hpp"
 #include "Entity.hpp"
+#include "EntityTable.hpp"
+#include "Group.hpp"
+#include "Hash.hpp"
+#include "Layout.hpp"
+#include "Prefab.hpp"
+#include "PresenceBitmap.hpp"
+#include "QueryCursor.hpp"
+#include "Relationship.hpp"
+#include "Resources.hpp"
+#include "TypeId.hpp"
 #include "events/EventManager.hpp"
 #include "Events.hpp"
 
+namespace persistence
+{
+	template <typename... Ts>
+	class Snapshot;
+}
+
+namespace ipc
+{
+	template <typename... Ts>
+	class Exporter;
+}
+
+namespace streaming
+{
+	template <typename... Ts>
+	class Partition;
+
+	template <typename... Ts>
+	class StagedPartition;
+}
+
 namespace babs_ecs
 {
 	// This is needed to use Entity as a key in a map.
@@ -28,23 +64,20 @@ namespace babs_ecs
 		}
 	};
 
-	// Exists to satisfying compiler warnings
-	class BaseContainer
+	class SpawnBuffer;
+
+	// QueryPlan is how EntitiesWith finds entities with several components, see ECSManager::PlanQuery.
+	enum class QueryPlan
 	{
-	public:
-		BaseContainer() {};
-		virtual ~BaseContainer() {};
+		SmallestPool,
+		Bitmaps
 	};
 
-	// This would be the concrete type created by RegisterComponent and inserted into the map.
-	// This container will hold all of the component data for a specific component type.
-	template <typename T>
-	class ComponentContainer : public BaseContainer
+	// DisabledEntities says whether a query skips entities turned off with ECSManager::SetEnabled.
+	enum class DisabledEntities
 	{
-	public:
-		ComponentContainer() {};
-		virtual ~ComponentContainer() {};
-		std::map<Entity, T, EntityComparer> data;
+		Skip,
+		Include
 	};
 
 	// ECSManageris the manager of the whole dealio.
@@ -56,372 +89,2182 @@ namespace babs_ecs
 		ECSManager()
 		{
 			this->bitIndex = 1;
-			this->entityIndex = 1;  // 0 is used for default/dummy entity
+			this->entities.Append(Entity());  // 0 is used for default/dummy entity
 		}
 
+		ECSManager(const ECSManager&) = delete;
+		ECSManager& operator=(const ECSManager&) = delete;
+
 		// CreateEntity will initialize and return a new entity with no components.
 		Entity CreateEntity()
 		{
-			uint32_t entityId = 1;
+			Entity e = this->ReserveEntity();
+			this->PublishReserved(true);
+			return e;
+		}
 
-			if (!this->unusedEntityIndices.empty())
-			{
-				entityId = this->unusedEntityIndices.front();
-				this->unusedEntityIndices.pop();
-			}
-			else
+		// ReserveEntity hands out the id of an entity that will be created by the next structural
+		// change (CreateEntity, RemoveEntity, Instantiate, or SpawnBuffer::Commit). It's lock-free and
+		// safe to call from any number of threads at once, as long as no thread is making a
+		// structural change at the same time. Recycled ids are handed out before fresh ones.
+		//
+		// The entity can't be used with the manager until it has been published, see SpawnBuffer
+		// for staging its components in the meantime.
+		Entity ReserveEntity()
+		{
+			// claim a slot at the back of the free list, or a fresh id once it runs out
+			int64_t slot = this->reservableFree.fetch_sub(1, std::memory_order_relaxed) - 1;
+			if (slot >= 0)
 			{
-				entityId = this->entityIndex;
-				entityIndex++;
+				return Entity(this->unusedEntityIndices[static_cast<size_t>(slot)]);
 			}
 
-			Entity e = Entity(entityId);
-			this->entities.insert({ e.UUID, e });
+			return Entity(this->nextReserved.fetch_add(1, std::memory_order_relaxed));
+		}
 
-			EntityCreated entityCreated(e);
-			this->events.Broadcast(entityCreated);
-			return e;
+		// IsAlive checks whether the entity exists, it's false once the entity has been removed.
+		bool IsAlive(Entity entity) const
+		{
+			return this->EntityExists(entity.UUID);
+		}
+
+		// IsEnabled is false once the entity has been turned off with SetEnabled.
+		bool IsEnabled(Entity entity) const
+		{
+			return this->EntityExists(entity.UUID) && !this->disabled.Test(entity.UUID);
 		}
 
+		Status SetEnabled(Entity entity, bool enabled);
+
+		Status SetEnabled(Entity first, Entity last, bool enabled);
+
+		std::vector<Entity> Instantiate(const Prefab& prefab, size_t count);
+
+		std::vector<Entity> MoveEntities(const std::vector<Entity>& moving, ECSManager& target);
+
 		template <typename T>
-		void RegisterComponent();
+		Status RegisterComponent();
 
 		template <typename T>
-		void AddComponent(Entity entity, T component);
+		Status AddComponent(Entity entity, T component);
 
 		template <typename T>
-		void RemoveComponent(Entity entity);
+		Status RemoveComponent(Entity entity);
+
+		template <typename... Ts>
+		Status DestroyAll(DisabledEntities disabledEntities = DisabledEntities::Skip);
+
+		template <typename T>
+		Status Clear();
+
+		template <typename... Ts, typename T>
+		Status AddToAll(T component, DisabledEntities disabledEntities = DisabledEntities::Skip);
 
 		template <typename T>
 		T* GetComponent(Entity entity);
 
+		template <typename T>
+		const T* ReadComponent(Entity entity);
+
+		template <typename T, typename Func>
+		T* Patch(Entity entity, Func func);
+
+		template<typename... Ts>
+		std::vector<Entity> EntitiesWith(DisabledEntities disabledEntities = DisabledEntities::Skip);
+
 		template<typename... Ts>
-		std::vector<Entity> EntitiesWith();
+		std::vector<Entity> EntitiesWith(QueryPlan plan, DisabledEntities disabledEntities = DisabledEntities::Skip);
+
+		template <typename... Ts>
+		QueryPlan PlanQuery();
 
 		template <typename T>
 		bool HasComponent(Entity entity);
 
-		void RemoveEntity(Entity entity)
-		{
-			uint32_t entityId = entity.UUID;
-			size_t originalSize = this->entities.size();
+		template <typename... Ts, typename Func>
+		bool Resume(QueryCursor& cursor, std::chrono::microseconds budget, Func func, DisabledEntities disabledEntities = DisabledEntities::Skip);
+
+		template <typename T>
+		auto GetComponentArray();
+
+		template <typename... Ts>
+		OwningGroup<Ts...>& Group();
+
+		template <typename... Ts>
+		Collector& Collect();
+
+		template <typename T, typename Compare>
+		Status Sort(Compare compare, SortMode mode = SortMode::Full);
 
-			this->entities.erase(entity.UUID);
+		template <typename To, typename From>
+		Status SortAs(SortMode mode = SortMode::Full);
 
-			if (originalSize == this->entities.size())
+		template <typename T>
+		Status SwapBuffers(BufferSwap mode = BufferSwap::Swap);
+
+		Status SetParent(Entity child, Entity parent);
+
+		Entity GetParent(Entity entity);
+
+		std::vector<Entity> GetChildren(Entity entity);
+
+		template <typename Func>
+		void EachInHierarchy(Func func);
+
+		template <typename T>
+		T& SetResource(T value);
+
+		// Resource returns the resource set with SetResource<T>. It's a single indexed load, so it's fine
+		// to call from tight loops. Throws ResourceNotFoundException if the resource was never set.
+		// With BABS_ECS_NO_EXCEPTIONS there's no reference to return instead, so it aborts, check
+		// with HasResource first.
+		template <typename T>
+		T& Resource()
+		{
+			size_t id = TypeIds<ResourceFamily>::Of<T>();
+
+			if (id >= this->resourcePointers.size() || this->resourcePointers[id] == nullptr)
 			{
-				throw EntityNotFoundException(entityId);
+				BABS_ECS_FATAL(ResourceNotFoundException(typeid(T).name()));
 			}
 
-			this->unusedEntityIndices.push(entityId);
+			return *static_cast<T*>(this->resourcePointers[id]);
+		}
+
+		template <typename T>
+		bool HasResource();
+
+		template <typename T>
+		void RemoveResource();
+
+		// Fork returns a copy-on-write copy of the world, see the definition for what's shared.
+		std::unique_ptr<ECSManager> Fork() const;
+
+		// Hash returns an order-independent digest of the whole world, see the definition.
+		uint64_t Hash();
+
+		// RemoveEntity removes the entity and all of its component data. If the entity is part of
+		// the hierarchy, all of its descendants are removed too.
+		Status RemoveEntity(Entity entity)
+		{
+			if (!this->EntityExists(entity.UUID))
+			{
+				BABS_ECS_ERROR(EntityNotFoundException(entity.UUID), Status::EntityNotFound);
+			}
 
-			std::map<std::string, std::vector<Entity>>::iterator it;
-			for (it = this->individualComponentVecs.begin(); it != this->individualComponentVecs.end(); ++it)
+			if (this->ComponentIsRegistered(ComponentId<Relationship>()) && this->HasComponent<Relationship>(entity))
 			{
-				std::string name = it->first;
+				std::vector<uint32_t> descendants = this->GetDescendants(entity.UUID);
+				this->Detach(entity.UUID);
 
-				auto specificVecIt = this->individualComponentVecs[name].begin();
-				while (specificVecIt != this->individualComponentVecs[name].end())
+				// removals fill holes from the back of the container, which breaks the depth order
+				this->hierarchyDirty = true;
+
+				for (uint32_t descendant : descendants)
 				{
-					if (entity.UUID == specificVecIt->UUID)
-					{
-						this->individualComponentVecs[name].erase(specificVecIt);
-						break;
-					}
-					++specificVecIt;
+					this->RemoveSingleEntity(descendant);
 				}
 			}
+
+			this->RemoveSingleEntity(entity.UUID);
+			return Status::Ok;
 		}
 
 	private:
-		std::queue<uint32_t> unusedEntityIndices;
-		uint32_t entityIndex;
-		bitfield::Bitfield bitIndex;
-		std::map<uint32_t, Entity> entities;
+		friend class SpawnBuffer;
 
-		std::map<std::string, BaseContainer*> components;
-		std::map<std::string, bitfield::Bitfield> componentIndex;
+		template <typename... Ts>
+		friend class persistence::Snapshot;
 
-		std::map<std::string, std::vector<Entity>> individualComponentVecs;
+		template <typename... Ts>
+		friend class ipc::Exporter;
 
-		std::vector<std::string> registeredComponents;
+		template <typename... Ts>
+		friend class streaming::Partition;
 
-		template <typename T>
-		std::string GetComponentName();
+		template <typename... Ts>
+		friend class streaming::StagedPartition;
 
-		template <typename T, typename... Ts>
-		std::vector<std::string> GetComponentNames();
+		void RemoveEntities(std::vector<Entity> doomed);
 
-		bool ComponentIsRegistered(std::string componentName)
+		void RemoveSingleEntity(uint32_t entityId)
 		{
-			return std::find(this->registeredComponents.begin(), this->registeredComponents.end(), componentName) != this->registeredComponents.end();
-		}
-	};
+			// reserved ids point into the free list, so they have to be taken out of it first
+			this->PublishReserved(true);
 
-	// RegisterComponent will let ECS know of a new component type it needs to keep track of.
-	//
-	// Until this is called, components cannot be added/retrieved.
-	template<typename T>
-	inline void ECSManager::RegisterComponent()
-	{
-		// Example: "class TestComponent", "struct Health", "struct Identity"
-		// using typeid(T).name() means we don't need to rely on ToString();
-		std::string componentName = this->GetComponentName<T>();
+			// keep the signature around for the removal event
+			Entity removed = this->entities[entityId];
+			this->entities.Write(entityId) = Entity();
 
-		if (components.find(componentName) == components.end())
-		{
-			componentIndex[componentName] = bitIndex;
-			components[componentName] = new ComponentContainer<T>();
+			this->unusedEntityIndices.push_back(entityId);
+			this->reservableFree.store(static_cast<int64_t>(this->unusedEntityIndices.size()), std::memory_order_relaxed);
+			this->RecordChange(entityId, removed.bitfield, 0);
+			this->entityHash -= EntityHash(entityId, 0);
+			this->MarkDisabled(entityId, false);
 
-			// set the next bit index
-			unsigned int lastIndex = bitIndex;
-			bitIndex *= 2;
-			if (bitIndex < lastIndex)
+			// pull the entity out of any group first so the containers stay co-sorted
+			for (auto& group : this->groups)
 			{
-				throw std::out_of_range("Exceeded available flags for the bitfield! (max 32 b/c uint32)");
+				if (group->Contains(entityId))
+				{
+					group->Leave(entityId);
+				}
 			}
 
-			registeredComponents.emplace_back(componentName);
-		}
-	}
+			// only the components in the signature need visiting
+			for (size_t componentId = 0; componentId < this->components.size(); ++componentId)
+			{
+				if (this->components[componentId] == nullptr || !bitfield::Has(removed.bitfield, this->componentIndex[componentId]))
+				{
+					continue;
+				}
 
-	// AddComponent will add the component to the entity. It can be retrieved later with ecs.GetComponent(...)
-	template<typename T>
-	inline void ECSManager::AddComponent(Entity entity, T component)
-	{
-		std::string componentName = this->GetComponentName<T>();
+				this->WritablePool(componentId)->Remove(entityId);
+				this->presence[componentId].Clear(entityId);
+			}
 
-		if (!this->ComponentIsRegistered(componentName))
-		{
-			throw babs_ecs::ComponentNotRegisteredException(componentName);
+			EntityRemoved entityRemoved(removed);
+			this->events.Broadcast(entityRemoved);
 		}
 
-		// get the container for this component and add the component data to this entity
-		ComponentContainer<T>* container = dynamic_cast<ComponentContainer<T>*>(this->components[componentName]);
-		container->data[entity] = component;
-		int componentFlag = componentIndex[componentName];
+		// PublishReserved makes every entity reserved since the last structural change alive, in the
+		// order they were reserved. announce broadcasts EntityCreated for each of them.
+		void PublishReserved(bool announce)
+		{
+			int64_t free = this->reservableFree.load(std::memory_order_relaxed);
+			size_t remaining = free > 0 ? static_cast<size_t>(free) : 0;
+			uint32_t fresh = this->nextReserved.load(std::memory_order_relaxed);
 
-		auto mapIterator = this->entities.find(entity.UUID);
+			if (remaining == this->unusedEntityIndices.size() && fresh == this->entities.Size())
+			{
+				return;
+			}
 
-		if (mapIterator == this->entities.end())
-		{
-			throw std::runtime_error("Failed to find entity to add component to");
-		}
+			// the free list hands out ids from the back
+			for (size_t slot = this->unusedEntityIndices.size(); slot > remaining; --slot)
+			{
+				this->Publish(this->unusedEntityIndices[slot - 1], announce);
+			}
+			this->unusedEntityIndices.resize(remaining);
+			this->reservableFree.store(static_cast<int64_t>(remaining), std::memory_order_relaxed);
 
-		mapIterator->second.bitfield = bitfield::Set(mapIterator->second.bitfield, componentFlag);
-		Entity e = mapIterator->second;
+			while (this->entities.Size() < fresh)
+			{
+				this->entities.Append(Entity());
+				this->Publish(static_cast<uint32_t>(this->entities.Size() - 1), announce);
+			}
+		}
 
-		// make sure this entity is in the component specific list of entities
-		auto iter = this->individualComponentVecs.find(componentName);
-		if (iter != this->individualComponentVecs.end())
+		void Publish(uint32_t uuid, bool announce)
 		{
-			iter->second.push_back(e);
+			Entity e = Entity(uuid);
+			this->entities.Write(uuid) = e;
+			this->entityHash += EntityHash(uuid, 0);
+
+			if (announce)
+			{
+				EntityCreated entityCreated(e);
+				this->events.Broadcast(entityCreated);
+			}
 		}
-		else
+
+		// IsPristine is true for a world that has never had an entity, not even a reserved one.
+		bool IsPristine() const
 		{
-			std::vector<Entity> entityList;
-			entityList.push_back(e);
-			this->individualComponentVecs.insert(std::pair<std::string, std::vector<Entity>>(componentName, entityList));
+			return this->entities.Size() == 1 && this->nextReserved.load(std::memory_order_relaxed) == 1 && this->unusedEntityIndices.empty();
 		}
 
-		std::map<std::string, std::vector<Entity>>::iterator it;
-		for (it = this->individualComponentVecs.begin(); it != this->individualComponentVecs.end(); ++it)
+		// RestoreEntities sets up the entity table of a pristine world in one go: every id below
+		// tableSize is alive without components, except the freeCount ids in freeIds, which become
+		// the free list in that order. The disabledCount ids in disabledIds, which are ascending,
+		// start out disabled. Nothing is broadcast until FinishRestore.
+		void RestoreEntities(uint32_t tableSize, const uint32_t* freeIds, size_t freeCount, const uint32_t* disabledIds, size_t disabledCount)
 		{
-			auto copiedEntity = std::find(it->second.begin(), it->second.end(), e);
-			if (copiedEntity != it->second.end())
+			this->entities.Resize(tableSize);
+			for (uint32_t uuid = 1; uuid < tableSize; ++uuid)
 			{
-				copiedEntity->bitfield = e.bitfield;
+				this->entities.Write(uuid) = Entity(uuid);
 			}
-		}
-
-		// fire the component added event
-		babs_ecs::ComponentAdded componentAdded(entity, component);
-		this->events.Broadcast(componentAdded);
-	}
 
-	// GetComponent will return a pointer to the entities component data. Modifications to the component will persist.
-	template<typename T>
-	inline void ECSManager::RemoveComponent(Entity entity)
-	{
-		std::string componentName = this->GetComponentName<T>();
+			for (size_t i = 0; i < freeCount; ++i)
+			{
+				this->entities.Write(freeIds[i]) = Entity();
+			}
 
-		if (!this->ComponentIsRegistered(componentName))
-		{
-			throw babs_ecs::ComponentNotRegisteredException(componentName);
-		}
+			// the ids are ascending, so each word of the bitmap is written once
+			for (size_t i = 0; i < disabledCount;)
+			{
+				size_t word = disabledIds[i] / 64;
+				uint64_t mask = 0;
+				for (; i < disabledCount && disabledIds[i] / 64 == word; ++i)
+				{
+					mask |= uint64_t(1) << (disabledIds[i] % 64);
+				}
 
-		int componentFlag = componentIndex[componentName];
+				this->UpdateDisabled(word, mask, true);
+			}
 
-		auto mapIterator = this->entities.find(entity.UUID);
+			this->unusedEntityIndices.assign(freeIds, freeIds + freeCount);
+			this->reservableFree.store(static_cast<int64_t>(freeCount), std::memory_order_relaxed);
+			this->nextReserved.store(tableSize, std::memory_order_relaxed);
+		}
 
-		if (mapIterator == this->entities.end())
+		// RestoreComponents adds count components of type T, stored back to back at data, to the
+		// live entities listed in uuids, which must not repeat. Dense pools take the whole block at
+		// once. The signatures and the presence bitmap are updated for the pool as a whole, and
+		// only reported to the hash and collectors by FinishRestore, once they're complete.
+		template <typename T>
+		void RestoreComponents(const uint32_t* uuids, const T* data, size_t count)
 		{
-			throw std::runtime_error("Failed to find entity to add component to");
-		}
+			size_t componentId = ComponentId<T>();
+			bitfield::Bitfield flag = this->componentIndex[componentId];
+			Storage<T>* container = this->GetContainer<T>();
 
-		// first we clear its bitfield
-		mapIterator->second.bitfield = bitfield::Clear(mapIterator->second.bitfield, componentFlag);
+			if constexpr (uses_storage_v<T, dense_storage>)
+			{
+				container->Append(uuids, data, count);
+			}
+			else
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					container->Insert(Entity(uuids[i]), data[i]);
+				}
+			}
 
-		// now we remove it from the component specific list
-		auto componentVector = this->individualComponentVecs.find(componentName);
+			for (size_t i = 0; i < count; ++i)
+			{
+				Entity& e = this->entities.Write(uuids[i]);
+				e.bitfield = bitfield::Set(e.bitfield, flag);
+			}
+			this->presence[componentId].SetMany(uuids, count);
 
-		if (componentVector == this->individualComponentVecs.end())
-		{
-			// Nothing to remove
-			return;
+			if constexpr (std::is_same_v<T, Relationship>)
+			{
+				this->hierarchyDirty = true;
+			}
 		}
 
-		for (std::vector<Entity>::iterator it = componentVector->second.begin(); it != componentVector->second.end(); ++it)
+		// FinishRestore records every restored entity's signature, fills the groups and announces
+		// the entities with one EntitiesCreated event. It's a single pass over the table. The
+		// collectors and groups, which a world that's just been restored rarely has, are only
+		// visited when there are some.
+		void FinishRestore()
 		{
-			if (it->UUID == mapIterator->first)
+			std::vector<Entity> restored;
+			restored.reserve(this->entities.Size() - this->unusedEntityIndices.size());
+			bool replay = !this->collectors.empty() || !this->groups.empty();
+			uint64_t hash = 0;
+
+			for (uint32_t uuid = 1; uuid < this->entities.Size(); ++uuid)
 			{
-				ComponentContainer<T>* container = dynamic_cast<ComponentContainer<T>*>(this->components[componentName]);
-				T componentData = container->data[entity];
+				if (!this->EntityExists(uuid))
+				{
+					continue;
+				}
 
-				componentVector->second.erase(it);
+				const Entity& e = this->entities[uuid];
+				restored.push_back(e);
+				hash += EntityHash(uuid, e.bitfield);
 
-				std::map<std::string, std::vector<Entity>>::iterator mapIt;
-				for (mapIt = this->individualComponentVecs.begin(); mapIt != this->individualComponentVecs.end(); ++mapIt)
+				if (replay)
 				{
-					auto copiedEntity = std::find(mapIt->second.begin(), mapIt->second.end(), mapIterator->second);
-					if (copiedEntity != mapIt->second.end())
+					for (auto& collector : this->collectors)
 					{
-						copiedEntity->bitfield = mapIterator->second.bitfield;
+						collector->Record(uuid, 0, e.bitfield);
 					}
-				}
 
-				// fire the component removed event
-				babs_ecs::ComponentRemoved componentRemoved(entity, componentData);
-				this->events.Broadcast(componentRemoved);
-				break;
+					for (auto& group : this->groups)
+					{
+						if (bitfield::Has(e.bitfield, group->mask))
+						{
+							group->Enter(uuid);
+						}
+					}
+				}
 			}
-		}
-	}
 
-	template<typename T>
-	inline T* ECSManager::GetComponent(Entity entity)
-	{
-		std::string componentName = this->GetComponentName<T>();
+			this->entityHash += hash;
 
-		if (!this->ComponentIsRegistered(componentName))
-		{
-			throw babs_ecs::ComponentNotRegisteredException(componentName);
+			EntitiesCreated entitiesCreated(restored);
+			this->events.Broadcast(entitiesCreated);
 		}
 
-		int componentFlag = componentIndex[componentName];
+		// unused ids are reused most recently freed first, their slots are the most likely to still be cached
+		std::vector<uint32_t> unusedEntityIndices;
 
-		auto mapIterator = this->entities.find(entity.UUID);
+		// ReserveEntity claims ids through these without touching anything else. reservableFree counts
+		// the unclaimed ids at the front of unusedEntityIndices (negative once it's been overdrawn),
+		// and nextReserved is the next fresh id. PublishReserved catches the tables up with them.
+		std::atomic<int64_t> reservableFree{ 0 };
+		std::atomic<uint32_t> nextReserved{ 1 };
+		bitfield::Bitfield bitIndex;
 
-		if (mapIterator == this->entities.end())
+		// entities is indexed by UUID, the slots of removed entities hold a dummy entity (UUID 0)
+		EntityTable entities;
+
+		// the per-component tables are indexed by TypeIds<ComponentFamily>, a component is
+		// registered once it has a container. Containers are shared with forks until either side
+		// writes to them, see WritablePool.
+		std::vector<std::shared_ptr<BaseContainer>> components;
+		std::vector<bitfield::Bitfield> componentIndex;
+
+		// groups own their components' containers, each component can belong to at most one group
+		std::vector<std::unique_ptr<BaseGroup>> groups;
+		std::vector<BaseGroup*> groupOwners;
+
+		// collectors and the world hash are told about every signature change, see RecordChange
+		std::vector<std::unique_ptr<Collector>> collectors;
+
+		// presence has a bit per entity for each component, for intersecting multi-component queries
+		std::vector<PresenceBitmap> presence;
+
+		// disabled has a bit per entity turned off with SetEnabled, which queries mask out a word at
+		// a time. Only live entities ever have their bit set. disabledHash is the sum of DisabledHash
+		// over its words, for Hash.
+		PresenceBitmap disabled;
+		size_t disabledCount = 0;
+		uint64_t disabledHash = 0;
+
+		// resources are indexed by TypeIds<ResourceFamily>, resourcePointers mirrors the holders so
+		// Resource<T>() doesn't have to go through the virtual base
+		std::vector<std::unique_ptr<BaseResource>> resources;
+		std::vector<void*> resourcePointers;
+
+		// set whenever a depth changes, so EachInHierarchy knows to re-sort
+		bool hierarchyDirty = false;
+
+		// entityHash is the sum of EntityHash over every live entity, kept up to date as entities
+		// and signatures change. poolHashes caches each container's Hash until poolChanged says
+		// it's been written to. The flags are atomic, one per pool, since GetComponent sets them and
+		// double-buffered components are written from several threads at once. A deque, because
+		// atomics can't be moved when a vector grows.
+		uint64_t entityHash = 0;
+		std::vector<uint64_t> poolHashes;
+		std::deque<std::atomic<bool>> poolChanged;
+
+		// the first registered component that can't be copied, which stops the world being forked
+		std::string uncopyableComponent;
+
+		Relationship* GetRelationship(uint32_t uuid)
 		{
-			return nullptr;
+			return this->GetContainer<Relationship>()->Get(uuid);
 		}
 
-		if (bitfield::Has(mapIterator->second.bitfield, componentFlag))
+		const Relationship* ReadRelationship(uint32_t uuid)
 		{
-			ComponentContainer<T>* container = dynamic_cast<ComponentContainer<T>*>(this->components[componentName]);
-			return &container->data[entity];
+			return this->ReadContainer<Relationship>()->Get(uuid);
 		}
 
-		return nullptr;
-	}
+		// WritablePool is the way to a container that's about to be written. It gives this world its
+		// own copy of a container it shares with a fork, so the fork doesn't see the change, and
+		// marks its hash as stale. Taking the copy replaces the shared_ptr, which isn't safe to do
+		// from several threads, so the pools that are written in parallel (double-buffered ones)
+		// and the ones owned by a group are never shared, see Fork.
+		BaseContainer* WritablePool(size_t componentId)
+		{
+			std::shared_ptr<BaseContainer>& pool = this->components[componentId];
 
-	template<typename T, typename... Ts>
-	inline std::vector<std::string> ECSManager::GetComponentNames()
-	{
-		std::vector<std::string> names;
+			// only stored when it changes, so threads writing the same pool don't fight over the line
+			std::atomic<bool>& changed = this->poolChanged[componentId];
+			if (!changed.load(std::memory_order_relaxed))
+			{
+				changed.store(true, std::memory_order_relaxed);
+			}
 
-		if constexpr (sizeof...(Ts) == 0)
-		{
-			// this is effectively the "base case" if you were to think of this like recursion
-			names.push_back(typeid(T).name());
+			if (pool.use_count() > 1)
+			{
+				pool = pool->Clone();
+			}
+
+			return pool.get();
 		}
-		else
+
+		void Detach(uint32_t child);
+		void UpdateDepths(uint32_t root);
+		std::vector<uint32_t> GetDescendants(uint32_t root);
+
+		template <typename T>
+		static size_t ComponentId()
 		{
-			// we must still have more component names to retrieve, continue templating
-			names = GetComponentNames<Ts...>();
-			names.push_back(GetComponentNames<T>()[0]);
+			return TypeIds<ComponentFamily>::Of<T>();
 		}
 
-		return names;
-	}
+		template <typename T>
+		std::string GetComponentName();
 
-	// Returns a list of Entity pointers of entities matching the provided list of component types.
-	//
-	// If no component types are provided, all entities will be returned.
-	// 
-	// Typical usage: auto entities = ecs.EntitiesWith<Identity, Health>();
-	template<typename ...Ts>
-	inline std::vector<Entity> ECSManager::EntitiesWith()
-	{
-		// build bitfield flags for this search
-		std::vector<std::string> componentNames;
-		if constexpr (sizeof...(Ts) > 0)
+		template <typename... Ts>
+		std::string UnregisteredComponentName();
+
+		Status RegisterPool(size_t componentId, std::unique_ptr<BaseContainer> pool, std::string uncopyableName);
+
+		template <typename T>
+		Storage<T>* GetContainer();
+
+		template <typename T>
+		const Storage<T>* ReadContainer();
+
+		// LoadComponent copies the component out of either kind of container.
+		template <typename T>
+		static T LoadComponent(Storage<T>* container, uint32_t uuid)
 		{
-			componentNames = this->GetComponentNames<Ts...>();
+			if constexpr (is_soa_v<T>)
+			{
+				return container->Load(container->IndexOf(uuid));
+			}
+			else
+			{
+				return std::move(*container->Get(uuid));
+			}
 		}
 
-		// if no components were provided, we'll return all entities
-		if (componentNames.size() == 0)
+		bool EntityExists(uint32_t uuid) const
+		{
+			return uuid != 0 && uuid < this->entities.Size() && this->entities[uuid].UUID == uuid;
+		}
+
+		void RecordChange(uint32_t uuid, bitfield::Bitfield before, bitfield::Bitfield after)
 		{
-			// Asking for all entities
-			std::vector<Entity> requestedEntities;
-			for (auto e : this->entities)
+			this->entityHash += EntityHash(uuid, after) - EntityHash(uuid, before);
+
+			for (auto& collector : this->collectors)
 			{
-				requestedEntities.push_back(e.second);
+				collector->Record(uuid, before, after);
 			}
-			return requestedEntities;
 		}
 
-		// looks like they asked for 1+ components. first we'll get the current size of
-		// each component specific list
-		std::vector<std::tuple<std::string, int>> componentListSizes;
-		for (auto componentName : componentNames)
+		static uint64_t EntityHash(uint32_t uuid, bitfield::Bitfield signature)
 		{
-			if (!this->ComponentIsRegistered(componentName))
+			return HashMix(HashMix(0, uuid), signature);
+		}
+
+		// UpdateDisabled sets or clears the bits in mask, in one word of the disabled bitmap.
+		void UpdateDisabled(size_t word, uint64_t mask, bool disable)
+		{
+			uint64_t before = this->disabled.Word(word);
+			uint64_t after = disable ? before | mask : before & ~mask;
+
+			if (after == before)
 			{
-				throw babs_ecs::ComponentNotRegisteredException(componentName);
+				return;
 			}
 
-			auto vec = &this->individualComponentVecs[componentName];
-			componentListSizes.push_back(std::make_tuple(componentName, vec->size()));
+			this->disabled.Store(word, after);
+			this->disabledCount = this->disabledCount + PopCount(after) - PopCount(before);
+			this->disabledHash += DisabledHash(word, after) - DisabledHash(word, before);
 		}
 
-		// now we'll build our search bitfield
-		bitfield::Bitfield field = 0;
-		for (auto name : componentNames)
+		void MarkDisabled(uint32_t uuid, bool disable)
 		{
-			field = bitfield::Set(field, this->componentIndex[name]);
+			this->UpdateDisabled(uuid / 64, uint64_t(1) << (uuid % 64), disable);
 		}
 
-		// grab our smallest component list 
-		std::string smallestComponentList = std::get<0>(*std::min_element(begin(componentListSizes), end(componentListSizes), [](auto lhs, auto rhs) {return std::get<1>(lhs) < std::get<1>(rhs); }));
-		auto entitySearchVector = this->individualComponentVecs[smallestComponentList];
+		static uint64_t DisabledHash(size_t word, uint64_t bits)
+		{
+			return bits == 0 ? 0 : HashMix(HashMix(1, word), bits);
+		}
 
-		// using the smallest list as our base, we'll check each entity against the
-		// search bitfield
-		std::vector<Entity> requestedEntities;
-		requestedEntities.reserve(entitySearchVector.size());
-		for (auto e : entitySearchVector) {
-			if (bitfield::Has(e.bitfield, field)) {
-				requestedEntities.emplace_back(e);
-			}
+		static QueryPlan PlanFor(size_t smallestPool, size_t words, size_t componentCount)
+		{
+			return words * componentCount < smallestPool * 4 ? QueryPlan::Bitmaps : QueryPlan::SmallestPool;
 		}
 
-		return requestedEntities;
-	}
+		bool ComponentIsRegistered(size_t componentId) const
+		{
+			return componentId < this->components.size() && this->components[componentId] != nullptr;
+		}
+	};
 
-	// Returns the compiler created string for this component. We don't actually care what the
-	// string is, but generally it seems to match the type name.
+	// RegisterComponent will let ECS know of a new component type it needs to keep track of.
+	//
+	// Until this is called, components cannot be added/retrieved.
 	template<typename T>
-	inline bool ECSManager::HasComponent(Entity entity)
+	inline Status ECSManager::RegisterComponent()
+	{
+		size_t componentId = ComponentId<T>();
+
+		if (this->ComponentIsRegistered(componentId))
+		{
+			return Status::Ok;
+		}
+
+		return this->RegisterPool(componentId, std::make_unique<Storage<T>>(), std::is_copy_constructible_v<T> ? std::string() : this->GetComponentName<T>());
+	}
+
+	// RegisterPool is the type-erased part of RegisterComponent. uncopyableName is the component's
+	// name if it can't be copied, and empty otherwise.
+	inline Status ECSManager::RegisterPool(size_t componentId, std::unique_ptr<BaseContainer> pool, std::string uncopyableName)
 	{
-		return this->GetComponent<T>(entity) != nullptr ? true : false;
+		// the flag doubles every registration, and overflows to 0 once all of them are used
+		if (bitIndex == 0)
+		{
+			BABS_ECS_ERROR(std::out_of_range("Exceeded available flags for the bitfield! (max 32 b/c uint32)"), Status::TooManyComponents);
+		}
+
+		if (componentId >= this->components.size())
+		{
+			this->components.resize(componentId + 1);
+			this->componentIndex.resize(componentId + 1, 0);
+			this->groupOwners.resize(componentId + 1, nullptr);
+			this->presence.resize(componentId + 1);
+			this->poolHashes.resize(componentId + 1, 0);
+			while (this->poolChanged.size() <= componentId)
+			{
+				this->poolChanged.emplace_back(true);
+			}
+		}
+
+		componentIndex[componentId] = bitIndex;
+		components[componentId] = std::move(pool);
+
+		if (this->uncopyableComponent.empty())
+		{
+			this->uncopyableComponent = uncopyableName;
+		}
+
+		// set the next bit index
+		bitIndex *= 2;
+
+		return Status::Ok;
 	}
 
+	// AddComponent will add the component to the entity. It can be retrieved later with ecs.GetComponent(...)
 	template<typename T>
-	inline std::string ECSManager::GetComponentName()
+	inline Status ECSManager::AddComponent(Entity entity, T component)
 	{
-		return typeid(T).name();
+		size_t componentId = ComponentId<T>();
+
+		if (!this->ComponentIsRegistered(componentId))
+		{
+			BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->GetComponentName<T>()), Status::ComponentNotRegistered);
+		}
+
+		if (!this->EntityExists(entity.UUID))
+		{
+			BABS_ECS_ERROR(std::runtime_error("Failed to find entity to add component to"), Status::EntityNotFound);
+		}
+
+		bitfield::Bitfield componentFlag = componentIndex[componentId];
+		Entity& stored = this->entities.Write(entity.UUID);
+
+		// get the container for this component and add the component data to this entity
+		Storage<T>* container = this->GetContainer<T>();
+		container->Insert(entity, component);
+
+		// re-adding a component only overwrites its data, the signature stays the same
+		if (!bitfield::Has(stored.bitfield, componentFlag))
+		{
+			stored.bitfield = bitfield::Set(stored.bitfield, componentFlag);
+			this->RecordChange(entity.UUID, bitfield::Clear(stored.bitfield, componentFlag), stored.bitfield);
+
+			this->presence[componentId].Set(entity.UUID);
+
+			// if this component completed a group's signature, swap the entity into the group
+			BaseGroup* owner = this->groupOwners[componentId];
+			if (owner != nullptr && bitfield::Has(stored.bitfield, owner->mask))
+			{
+				owner->Enter(entity.UUID);
+			}
+		}
+
+		// fire the component added event
+		babs_ecs::ComponentAdded componentAdded(entity, component);
+		this->events.Broadcast(componentAdded);
+		return Status::Ok;
+	}
+
+	// RemoveComponent removes the component and its data from the entity. Removing a component the entity doesn't have does nothing.
+	// Removing Relationship takes the entity out of the hierarchy first, and its children become roots.
+	template<typename T>
+	inline Status ECSManager::RemoveComponent(Entity entity)
+	{
+		size_t componentId = ComponentId<T>();
+
+		if (!this->ComponentIsRegistered(componentId))
+		{
+			BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->GetComponentName<T>()), Status::ComponentNotRegistered);
+		}
+
+		if (!this->EntityExists(entity.UUID))
+		{
+			BABS_ECS_ERROR(std::runtime_error("Failed to find entity to add component to"), Status::EntityNotFound);
+		}
+
+		bitfield::Bitfield componentFlag = componentIndex[componentId];
+		Entity& stored = this->entities.Write(entity.UUID);
+
+		if (!bitfield::Has(stored.bitfield, componentFlag))
+		{
+			// Nothing to remove
+			return Status::Ok;
+		}
+
+		// the parent and siblings link to the entity, and its children to it, so unlink all of them
+		if constexpr (std::is_same_v<T, Relationship>)
+		{
+			this->Detach(entity.UUID);
+			for (const Entity& child : this->GetChildren(entity))
+			{
+				this->Detach(child.UUID);
+				this->UpdateDepths(child.UUID);
+			}
+		}
+
+		// first we clear its bitfield
+		stored.bitfield = bitfield::Clear(stored.bitfield, componentFlag);
+		this->RecordChange(entity.UUID, bitfield::Set(stored.bitfield, componentFlag), stored.bitfield);
+
+		// the entity has to leave its group before the data is pulled out of the container
+		BaseGroup* owner = this->groupOwners[componentId];
+		if (owner != nullptr && owner->Contains(entity.UUID))
+		{
+			owner->Leave(entity.UUID);
+		}
+
+		Storage<T>* container = this->GetContainer<T>();
+		T componentData = this->LoadComponent<T>(container, entity.UUID);
+		container->Remove(entity.UUID);
+		this->presence[componentId].Clear(entity.UUID);
+
+		// fire the component removed event
+		babs_ecs::ComponentRemoved componentRemoved(entity, componentData);
+		this->events.Broadcast(componentRemoved);
+		return Status::Ok;
+	}
+
+	// DestroyAll removes every entity that has all of Ts, like calling RemoveEntity on each match
+	// (descendants in the hierarchy go too), for frame-end cleanup such as DestroyAll<Dead>().
+	//
+	// The matches are found with one query, and each pool and group is visited once for all of
+	// them. A single EntitiesRemoved event is broadcast instead of an EntityRemoved per entity.
+	// Like any query, disabled matches are skipped unless disabledEntities says to include them.
+	template<typename... Ts>
+	inline Status ECSManager::DestroyAll(DisabledEntities disabledEntities)
+	{
+		static_assert(sizeof...(Ts) > 0, "DestroyAll needs at least one component to match");
+
+		if (!(this->ComponentIsRegistered(ComponentId<Ts>()) && ...))
+		{
+			BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->UnregisteredComponentName<Ts...>()), Status::ComponentNotRegistered);
+		}
+
+		std::vector<Entity> doomed = this->EntitiesWith<Ts...>(disabledEntities);
+		if (doomed.empty())
+		{
+			return Status::Ok;
+		}
+
+		// matches in the hierarchy take their descendants with them
+		if (this->ComponentIsRegistered(ComponentId<Relationship>()))
+		{
+			std::vector<bool> listed(this->entities.Size(), false);
+			for (const Entity& e : doomed)
+			{
+				listed[e.UUID] = true;
+			}
+
+			size_t matches = doomed.size();
+			for (size_t i = 0; i < matches; ++i)
+			{
+				uint32_t uuid = doomed[i].UUID;
+				if (!this->ReadContainer<Relationship>()->Contains(uuid))
+				{
+					continue;
+				}
+
+				for (uint32_t descendant : this->GetDescendants(uuid))
+				{
+					if (!listed[descendant])
+					{
+						listed[descendant] = true;
+						doomed.push_back(this->entities[descendant]);
+					}
+				}
+
+				this->Detach(uuid);
+				this->hierarchyDirty = true;
+			}
+		}
+
+		this->RemoveEntities(std::move(doomed));
+		return Status::Ok;
+	}
+
+	// RemoveEntities removes every entity in doomed, which must be alive, out of the hierarchy and
+	// listed once with their current signatures. Each pool and group is visited once for all of
+	// them, and a single EntitiesRemoved event is broadcast.
+	inline void ECSManager::RemoveEntities(std::vector<Entity> doomed)
+	{
+		// reserved ids point into the free list, so they have to be taken out of it first
+		this->PublishReserved(true);
+
+		bitfield::Bitfield touched = 0;
+		for (const Entity& e : doomed)
+		{
+			this->entities.Write(e.UUID) = Entity();
+			this->unusedEntityIndices.push_back(e.UUID);
+			this->RecordChange(e.UUID, e.bitfield, 0);
+			this->entityHash -= EntityHash(e.UUID, 0);
+			this->MarkDisabled(e.UUID, false);
+			touched |= e.bitfield;
+		}
+		this->reservableFree.store(static_cast<int64_t>(this->unusedEntityIndices.size()), std::memory_order_relaxed);
+
+		// pull the entities out of their groups first so the containers stay co-sorted
+		for (auto& group : this->groups)
+		{
+			for (const Entity& e : doomed)
+			{
+				if (group->Contains(e.UUID))
+				{
+					group->Leave(e.UUID);
+				}
+			}
+		}
+
+		for (size_t componentId = 0; componentId < this->components.size(); ++componentId)
+		{
+			if (this->components[componentId] == nullptr)
+			{
+				continue;
+			}
+
+			bitfield::Bitfield flag = this->componentIndex[componentId];
+			if (!bitfield::Has(touched, flag))
+			{
+				continue;
+			}
+
+			BaseContainer* pool = this->WritablePool(componentId);
+			PresenceBitmap& present = this->presence[componentId];
+			for (const Entity& e : doomed)
+			{
+				if (bitfield::Has(e.bitfield, flag))
+				{
+					pool->Remove(e.UUID);
+					present.Clear(e.UUID);
+				}
+			}
+		}
+
+		EntitiesRemoved entitiesRemoved(std::move(doomed));
+		this->events.Broadcast(entitiesRemoved);
+	}
+
+	// Clear removes component T from every entity that has it, like calling RemoveComponent on
+	// each of them. The pool is emptied in one pass, and a single ComponentsRemoved event is
+	// broadcast instead of a ComponentRemoved per entity.
+	template<typename T>
+	inline Status ECSManager::Clear()
+	{
+		static_assert(!std::is_same_v<T, Relationship>, "The hierarchy is changed through SetParent and RemoveComponent, not Clear");
+
+		size_t componentId = ComponentId<T>();
+
+		if (!this->ComponentIsRegistered(componentId))
+		{
+			BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->GetComponentName<T>()), Status::ComponentNotRegistered);
+		}
+
+		// an empty pool doesn't need a copy of its own after a fork
+		if (this->ReadContainer<T>()->Size() == 0)
+		{
+			return Status::Ok;
+		}
+
+		bitfield::Bitfield componentFlag = this->componentIndex[componentId];
+		Storage<T>* container = this->GetContainer<T>();
+
+		// leaving a group reorders the pool, so take the list first
+		std::vector<Entity> cleared;
+		cleared.reserve(container->Size());
+		for (size_t i = 0; i < container->Size(); ++i)
+		{
+			cleared.push_back(this->entities[container->EntityAt(i).UUID]);
+		}
+
+		BaseGroup* owner = this->groupOwners[componentId];
+		if (owner != nullptr)
+		{
+			for (const Entity& e : cleared)
+			{
+				if (owner->Contains(e.UUID))
+				{
+					owner->Leave(e.UUID);
+				}
+			}
+		}
+
+		PresenceBitmap& present = this->presence[componentId];
+		for (Entity& e : cleared)
+		{
+			Entity& stored = this->entities.Write(e.UUID);
+			stored.bitfield = bitfield::Clear(stored.bitfield, componentFlag);
+			this->RecordChange(e.UUID, e.bitfield, stored.bitfield);
+			present.Clear(e.UUID);
+			e.bitfield = stored.bitfield;
+		}
+
+		container->Clear();
+
+		babs_ecs::ComponentsRemoved<T> componentsRemoved(std::move(cleared));
+		this->events.Broadcast(componentsRemoved);
+		return Status::Ok;
+	}
+
+	// AddToAll gives every entity that has all of Ts a copy of component, like calling
+	// AddComponent on each of them, so entities that already have a T get theirs overwritten.
+	// With no Ts, every entity gets one: AddToAll(Visible{}).
+	//
+	// The pool grows once for all of the new entries, and a single ComponentsAdded event is
+	// broadcast instead of a ComponentAdded per entity. Disabled matches are skipped unless
+	// disabledEntities says to include them.
+	template<typename... Ts, typename T>
+	inline Status ECSManager::AddToAll(T component, DisabledEntities disabledEntities)
+	{
+		static_assert(!std::is_same_v<T, Relationship>, "The hierarchy is changed through SetParent, not AddToAll");
+
+		size_t componentId = ComponentId<T>();
+
+		if (!this->ComponentIsRegistered(componentId) || !(this->ComponentIsRegistered(ComponentId<Ts>()) && ...))
+		{
+			BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->UnregisteredComponentName<T, Ts...>()), Status::ComponentNotRegistered);
+		}
+
+		std::vector<Entity> matches = this->EntitiesWith<Ts...>(disabledEntities);
+		if (matches.empty())
+		{
+			return Status::Ok;
+		}
+
+		bitfield::Bitfield componentFlag = this->componentIndex[componentId];
+		Storage<T>* container = this->GetContainer<T>();
+
+		std::vector<Entity> added;
+		added.reserve(matches.size());
+		for (const Entity& e : matches)
+		{
+			if (bitfield::Has(e.bitfield, componentFlag))
+			{
+				container->Insert(e, component);
+			}
+			else
+			{
+				added.push_back(e);
+			}
+		}
+		container->InsertBulk(added, component);
+
+		PresenceBitmap& present = this->presence[componentId];
+		BaseGroup* owner = this->groupOwners[componentId];
+		for (const Entity& e : added)
+		{
+			Entity& stored = this->entities.Write(e.UUID);
+			stored.bitfield = bitfield::Set(stored.bitfield, componentFlag);
+			this->RecordChange(e.UUID, e.bitfield, stored.bitfield);
+			present.Set(e.UUID);
+
+			// if this component completed a group's signature, swap the entity into the group
+			if (owner != nullptr && bitfield::Has(stored.bitfield, owner->mask))
+			{
+				owner->Enter(e.UUID);
+			}
+		}
+
+		for (Entity& e : matches)
+		{
+			e.bitfield = this->entities[e.UUID].bitfield;
+		}
+
+		babs_ecs::ComponentsAdded<T> componentsAdded(std::move(matches), component);
+		this->events.Broadcast(componentsAdded);
+		return Status::Ok;
+	}
+
+	// GetComponent will return a pointer to the entities component data. Modifications to the component will persist.
+	//
+	// Components with a soa_layout aren't stored as T, so they can't be pointed to. Use
+	// GetComponentArray for those, and AddComponent to overwrite a single entity's data.
+	//
+	// After a Fork the pointer has to be this world's own, so a hit copies the pool shared with the
+	// fork (only the component's page for paged and stable storage). A miss copies nothing, and
+	// ReadComponent never does.
+	template<typename T>
+	inline T* ECSManager::GetComponent(Entity entity)
+	{
+		static_assert(!is_soa_v<T>, "SoA components have no T to point to, use GetComponentArray instead");
+
+		size_t componentId = ComponentId<T>();
+
+		if (!this->ComponentIsRegistered(componentId))
+		{
+			BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->GetComponentName<T>()), nullptr);
+		}
+
+		// the container only knows entities that have the component, so this is the whole check
+		if (!this->ReadContainer<T>()->Contains(entity.UUID))
+		{
+			return nullptr;
+		}
+
+		return this->GetContainer<T>()->Get(entity.UUID);
+	}
+
+	// ReadComponent returns a read-only pointer to the entity's component as systems should see it
+	// this frame, or nullptr if it has none. For double-buffered components that's the snapshot made
+	// by the last SwapBuffers, while GetComponent points at the value being written for the next
+	// frame. For every other component both return the same data.
+	template<typename T>
+	inline const T* ECSManager::ReadComponent(Entity entity)
+	{
+		static_assert(!is_soa_v<T>, "SoA components have no T to point to, use GetComponentArray instead");
+
+		if (!this->ComponentIsRegistered(ComponentId<T>()))
+		{
+			BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->GetComponentName<T>()), nullptr);
+		}
+
+		if constexpr (is_double_buffered_v<T>)
+		{
+			return this->ReadContainer<T>()->Read(entity.UUID);
+		}
+		else
+		{
+			// reading doesn't need a container of our own, unlike GetComponent after a fork
+			return this->ReadContainer<T>()->Get(entity.UUID);
+		}
+	}
+
+	// Patch is the mutable access path that other systems can observe. It calls func(component) on the
+	// entity's component data and then broadcasts ComponentUpdated<T>, so anything built on top of
+	// the component (like a spatial index) sees the change. Writes through GetComponent are silent.
+	//
+	// Returns nullptr, without calling func, if the entity doesn't have the component.
+	//
+	// Typical usage: ecs.Patch<Position>(entity, [](Position& p) { p.x += 1.0f; });
+	template<typename T, typename Func>
+	inline T* ECSManager::Patch(Entity entity, Func func)
+	{
+		T* component = this->GetComponent<T>(entity);
+
+		if (component == nullptr)
+		{
+			return nullptr;
+		}
+
+		func(*component);
+
+		babs_ecs::ComponentUpdated<T> componentUpdated(entity, *component);
+		this->events.Broadcast(componentUpdated);
+		return component;
+	}
+
+	// Returns a list of Entity pointers of entities matching the provided list of component types.
+	//
+	// If no component types are provided, all entities will be returned. A single component type is
+	// answered straight from its pool, in the pool's order (see Sort). Several component types are
+	// answered as PlanQuery decides: either by checking every entity in the smallest pool, in that
+	// pool's order, or by intersecting presence bitmaps, in UUID order.
+	//
+	// Entities turned off with SetEnabled are left out, unless disabledEntities is Include.
+	//
+	// Typical usage: auto entities = ecs.EntitiesWith<Identity, Health>();
+	template<typename ...Ts>
+	inline std::vector<Entity> ECSManager::EntitiesWith(DisabledEntities disabledEntities)
+	{
+		return this->EntitiesWith<Ts...>(this->PlanQuery<Ts...>(), disabledEntities);
+	}
+
+	// EntitiesWith with a plan skips PlanQuery and finds several component types the given way, for
+	// comparing plans or when the caller knows the data better. Fewer than two types ignore it.
+	template<typename ...Ts>
+	inline std::vector<Entity> ECSManager::EntitiesWith(QueryPlan plan, DisabledEntities disabledEntities)
+	{
+		std::vector<Entity> requestedEntities;
+
+		// with nothing disabled there's nothing to mask out, which keeps the usual case as it was
+		bool skipDisabled = disabledEntities == DisabledEntities::Skip && this->disabledCount > 0;
+
+		// if no components were provided, we'll return all entities
+		if constexpr (sizeof...(Ts) == 0)
+		{
+			// the table is walked in UUID order, so the disabled bitmap is read a word at a time
+			uint64_t disabledWord = 0;
+			for (uint32_t uuid = 1; uuid < this->entities.Size(); ++uuid)
+			{
+				if (skipDisabled && (uuid % 64 == 0 || uuid == 1))
+				{
+					disabledWord = this->disabled.Word(uuid / 64);
+				}
+
+				if (this->entities[uuid].UUID == uuid && (disabledWord >> (uuid % 64) & 1) == 0)
+				{
+					requestedEntities.push_back(this->entities[uuid]);
+				}
+			}
+			return requestedEntities;
+		}
+		else
+		{
+			if (!(this->ComponentIsRegistered(ComponentId<Ts>()) && ...))
+			{
+				BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->UnregisteredComponentName<Ts...>()), requestedEntities);
+			}
+
+			// grab our smallest pool
+			std::array<BaseContainer*, sizeof...(Ts)> pools = { this->components[ComponentId<Ts>()].get()... };
+			BaseContainer* smallest = *std::min_element(pools.begin(), pools.end(), [](BaseContainer* lhs, BaseContainer* rhs) {
+				return lhs->Size() < rhs->Size();
+			});
+			size_t smallestSize = smallest->Size();
+			requestedEntities.reserve(smallestSize);
+
+			if constexpr (sizeof...(Ts) > 1)
+			{
+				if (plan == QueryPlan::Bitmaps)
+				{
+					const PresenceBitmap* const bitmaps[] = { &this->presence[ComponentId<Ts>()]... };
+					Intersect(bitmaps, [this, &requestedEntities](uint32_t uuid) {
+						requestedEntities.push_back(this->entities[uuid]);
+					}, skipDisabled ? &this->disabled : nullptr);
+					return requestedEntities;
+				}
+			}
+
+			// now we'll build our search bitfield
+			bitfield::Bitfield field = (this->componentIndex[ComponentId<Ts>()] | ...);
+			const Entity* entitySearchList = smallest->Entities();
+
+			// using the smallest pool as our base, we'll check each entity against the search
+			// bitfield. A single component needs no check, the pool holds exactly the matches.
+			if (!skipDisabled)
+			{
+				for (size_t i = 0; i < smallestSize; ++i) {
+					const Entity& current = this->entities[entitySearchList[i].UUID];
+					if (sizeof...(Ts) == 1 || bitfield::Has(current.bitfield, field)) {
+						requestedEntities.emplace_back(current);
+					}
+				}
+			}
+			else
+			{
+				// the pool's order is kept, but one word of the disabled bitmap covers 64 UUIDs and
+				// pools filled in bulk or sorted by UUID hold runs of them, so the word is only
+				// read again once the run moves on
+				size_t cachedWord = std::numeric_limits<size_t>::max();
+				uint64_t disabledWord = 0;
+				for (size_t i = 0; i < smallestSize; ++i) {
+					const Entity& current = this->entities[entitySearchList[i].UUID];
+					if (current.UUID / 64 != cachedWord) {
+						cachedWord = current.UUID / 64;
+						disabledWord = this->disabled.Word(cachedWord);
+					}
+
+					if ((sizeof...(Ts) == 1 || bitfield::Has(current.bitfield, field)) && (disabledWord >> (current.UUID % 64) & 1) == 0) {
+						requestedEntities.emplace_back(current);
+					}
+				}
+			}
+
+			return requestedEntities;
+		}
+	}
+
+	// PlanQuery picks how EntitiesWith<Ts...> finds its matches.
+	//
+	// Checking the smallest pool costs a dependent load into the entity table per pooled entity,
+	// while intersecting bitmaps streams one word per 64 entities per component (four at once with
+	// AVX2). Bitmaps win once the smallest pool outnumbers the words to stream by a few times,
+	// which happens for joins of common components that rarely occur together.
+	template<typename ...Ts>
+	inline QueryPlan ECSManager::PlanQuery()
+	{
+		if constexpr (sizeof...(Ts) < 2)
+		{
+			return QueryPlan::SmallestPool;
+		}
+		else
+		{
+			if (!(this->ComponentIsRegistered(ComponentId<Ts>()) && ...))
+			{
+				BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->UnregisteredComponentName<Ts...>()), QueryPlan::SmallestPool);
+			}
+
+			size_t smallest = std::min({ this->components[ComponentId<Ts>()]->Size()... });
+			size_t words = std::min({ this->presence[ComponentId<Ts>()].WordCount()... });
+
+			return PlanFor(smallest, words, sizeof...(Ts));
+		}
+	}
+
+	// Resume calls func(entity) for the entities matching Ts, starting where the cursor stopped last
+	// time, until the budget runs out. It returns true once the sweep has reached the last entity,
+	// and the next call starts a new sweep from the beginning.
+	//
+	// The clock is checked after every call to func, and every 1024 entities skipped because they
+	// don't match. A call therefore always visits the next matching entity, unless the budget runs out
+	// while skipping, so even a zero budget makes progress. func may add and remove entities and
+	// components. Disabled entities are skipped unless disabledEntities is Include.
+	//
+	// Typical usage, once per frame:
+	//   if (ecs.Resume<Agent>(replanCursor, std::chrono::microseconds(500), replan)) { ... }
+	template<typename ...Ts, typename Func>
+	inline bool ECSManager::Resume(QueryCursor& cursor, std::chrono::microseconds budget, Func func, DisabledEntities disabledEntities)
+	{
+		bitfield::Bitfield field = 0;
+
+		if constexpr (sizeof...(Ts) > 0)
+		{
+			if (!(this->ComponentIsRegistered(ComponentId<Ts>()) && ...))
+			{
+				BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->UnregisteredComponentName<Ts...>()), false);
+			}
+
+			field = (this->componentIndex[ComponentId<Ts>()] | ...);
+		}
+
+		const auto deadline = std::chrono::steady_clock::now() + budget;
+		size_t skipped = 0;
+
+		// func can grow the entity table, so the size is read on every step
+		while (cursor.position < this->entities.Size())
+		{
+			uint32_t uuid = cursor.position++;
+			Entity e = this->entities[uuid];
+
+			// func can disable entities, so this is checked on every step too
+			if (e.UUID == uuid && bitfield::Has(e.bitfield, field) && !(disabledEntities == DisabledEntities::Skip && this->disabled.Test(uuid)))
+			{
+				func(e);
+				cursor.visited++;
+
+				if (std::chrono::steady_clock::now() >= deadline)
+				{
+					return false;
+				}
+			}
+			else if (++skipped % 1024 == 0 && std::chrono::steady_clock::now() >= deadline)
+			{
+				return false;
+			}
+		}
+
+		cursor.position = 1;
+		cursor.sweeps++;
+		cursor.visited = 0;
+		return true;
+	}
+
+	// SetEnabled turns an entity off (or back on) without touching its components. Disabled
+	// entities keep their components and their place in every pool, but queries (EntitiesWith,
+	// Resume, DestroyAll and AddToAll) skip them unless asked to include them. It's a single bit
+	// flip, so it's much cheaper than removing components or adding a tag.
+	//
+	// Groups, component arrays and the spatial and field indexes still see disabled entities.
+	inline Status ECSManager::SetEnabled(Entity entity, bool enabled)
+	{
+		if (!this->EntityExists(entity.UUID))
+		{
+			BABS_ECS_ERROR(EntityNotFoundException(entity.UUID), Status::EntityNotFound);
+		}
+
+		this->MarkDisabled(entity.UUID, !enabled);
+		return Status::Ok;
+	}
+
+	// SetEnabled(first, last, enabled) turns every live entity with a UUID from first to last,
+	// inclusive, on or off. The bitmap is written a word (64 entities) at a time, so it suits
+	// entities created together, such as the ones returned by Instantiate. Ids in the range that
+	// aren't alive are left alone.
+	inline Status ECSManager::SetEnabled(Entity first, Entity last, bool enabled)
+	{
+		if (last.UUID >= this->entities.Size())
+		{
+			BABS_ECS_ERROR(EntityNotFoundException(last.UUID), Status::EntityNotFound);
+		}
+
+		for (uint32_t uuid = std::max(first.UUID, 1u); uuid <= last.UUID;)
+		{
+			size_t word = uuid / 64;
+			uint32_t end = std::min(static_cast<uint32_t>(word * 64 + 63), last.UUID);
+
+			uint64_t live = 0;
+			for (; uuid <= end; ++uuid)
+			{
+				live |= uint64_t(this->entities[uuid].UUID == uuid) << (uuid % 64);
+			}
+
+			this->UpdateDisabled(word, live, !enabled);
+		}
+
+		return Status::Ok;
+	}
+
+	template<typename T>
+	inline bool ECSManager::HasComponent(Entity entity)
+	{
+		size_t componentId = ComponentId<T>();
+
+		if (!this->ComponentIsRegistered(componentId))
+		{
+			BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->GetComponentName<T>()), false);
+		}
+
+		return this->ReadContainer<T>()->Contains(entity.UUID);
+	}
+
+	// GetComponentArray returns the packed pool for T, for handing to SIMD or auto-vectorised kernels.
+	//
+	// For regular components this is a ComponentArray<T>: a T* and an Entity* that run in parallel,
+	// aligned to BABS_ECS_ALIGNMENT and padded so full-width loads past the end stay in bounds. For
+	// components with a soa_layout it's a FieldArrays<T>, with one aligned array per member.
+	//
+	// The arrays are in container order, which is the same order Sort leaves them in. Any insertion,
+	// removal or reordering of T invalidates them.
+	//
+	// Typical usage:
+	//   auto positions = ecs.GetComponentArray<Position>();
+	//   for (size_t i = 0; i < positions.size; ++i) positions.data[i].x += 1.0f;
+	template<typename T>
+	inline auto ECSManager::GetComponentArray()
+	{
+		static_assert(uses_storage_v<T, dense_storage> || is_soa_v<T> || is_double_buffered_v<T>, "Only dense, SoA and double-buffered components are stored as arrays");
+
+		// only used to report errors when exceptions are off
+		using Array [[maybe_unused]] = decltype(std::declval<Storage<T>&>().Array());
+
+		if (!this->ComponentIsRegistered(ComponentId<T>()))
+		{
+			BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->GetComponentName<T>()), Array{});
+		}
+
+		return this->GetContainer<T>()->Array();
+	}
+
+	// Returns the compiler created string for this component. We don't actually care what the
+	// string is, but generally it seems to match the type name. It's only used for error messages.
+	template<typename T>
+	inline std::string ECSManager::GetComponentName()
+	{
+		return typeid(T).name();
+	}
+
+	// UnregisteredComponentName returns the name of the first of Ts that isn't registered.
+	template<typename ...Ts>
+	inline std::string ECSManager::UnregisteredComponentName()
+	{
+		std::string name;
+		((name.empty() && !this->ComponentIsRegistered(ComponentId<Ts>()) ? (void)(name = this->GetComponentName<Ts>()) : (void)0), ...);
+		return name;
+	}
+
+	// GetContainer doesn't need a dynamic_cast, containers are indexed by the component's type id so
+	// the one stored there is always a Storage<T>. The container is about to be written, so if it's
+	// shared with a fork this world gets its own copy first.
+	template<typename T>
+	inline Storage<T>* ECSManager::GetContainer()
+	{
+		return static_cast<Storage<T>*>(this->WritablePool(ComponentId<T>()));
+	}
+
+	// ReadContainer is GetContainer for reads, it never copies a shared container or any of its
+	// pages, so it only hands out const access.
+	template<typename T>
+	inline const Storage<T>* ECSManager::ReadContainer()
+	{
+		return static_cast<const Storage<T>*>(this->components[ComponentId<T>()].get());
+	}
+
+	// Group returns the owning group for the given component types, creating it on first use.
+	//
+	// An owning group keeps its components' containers sorted so that every entity with all of
+	// Ts sits in the same leading range of each container. AddComponent/RemoveComponent/RemoveEntity
+	// keep that range up to date with O(1) swaps, so iterating the group never has to check
+	// signatures. Each component type can be owned by at most one group, and asking for the same
+	// group again must list the types in the same order.
+	//
+	// Typical usage: auto& movers = ecs.Group<Transform, Velocity>();
+	template<typename ...Ts>
+	inline OwningGroup<Ts...>& ECSManager::Group()
+	{
+		static_assert(sizeof...(Ts) > 1, "A group needs at least two component types");
+		static_assert((uses_storage_v<Ts, dense_storage> && ...), "Only components with dense_storage can be owned by a group");
+
+		if (!(this->ComponentIsRegistered(ComponentId<Ts>()) && ...))
+		{
+			BABS_ECS_FATAL(babs_ecs::ComponentNotRegisteredException(this->UnregisteredComponentName<Ts...>()));
+		}
+
+		std::array<size_t, sizeof...(Ts)> componentIds = { ComponentId<Ts>()... };
+		std::vector<BaseContainer*> pools = { this->GetContainer<Ts>()... };
+
+		// reuse the existing group if it's the exact same one
+		BaseGroup* existing = this->groupOwners[componentIds.front()];
+		if (existing != nullptr)
+		{
+			if (existing->pools != pools)
+			{
+				BABS_ECS_FATAL(babs_ecs::ComponentAlreadyGroupedException(this->GetComponentName<std::tuple_element_t<0, std::tuple<Ts...>>>()));
+			}
+			return *static_cast<OwningGroup<Ts...>*>(existing);
+		}
+
+		for (size_t i = 0; i < componentIds.size(); ++i)
+		{
+			if (this->groupOwners[componentIds[i]] != nullptr)
+			{
+				BABS_ECS_FATAL(babs_ecs::ComponentAlreadyGroupedException(std::array<std::string, sizeof...(Ts)>{ this->GetComponentName<Ts>()... }[i]));
+			}
+		}
+
+		bitfield::Bitfield mask = (this->componentIndex[ComponentId<Ts>()] | ...);
+		auto group = std::make_unique<OwningGroup<Ts...>>(mask, this->GetContainer<Ts>()...);
+		OwningGroup<Ts...>* created = group.get();
+
+		for (size_t componentId : componentIds)
+		{
+			this->groupOwners[componentId] = created;
+		}
+		this->groups.push_back(std::move(group));
+
+		// pull in every entity that already matches
+		for (Entity e : this->EntitiesWith<Ts...>())
+		{
+			created->Enter(e.UUID);
+		}
+
+		return *created;
+	}
+
+	// Collect returns the collector for entities that start or stop having all of Ts, creating it on
+	// first use. Entities that already match when it's created start out in Entered(). Asking for
+	// the same set of components again returns the same collector, in any order.
+	//
+	// Collecting costs a signature check per collector on every AddComponent, RemoveComponent and
+	// RemoveEntity, instead of an event broadcast per change to each interested system.
+	//
+	// Typical usage: auto& spawned = ecs.Collect<Transform, Collider>();
+	template<typename ...Ts>
+	inline Collector& ECSManager::Collect()
+	{
+		static_assert(sizeof...(Ts) > 0, "A collector needs at least one component type");
+
+		if (!(this->ComponentIsRegistered(ComponentId<Ts>()) && ...))
+		{
+			BABS_ECS_FATAL(babs_ecs::ComponentNotRegisteredException(this->UnregisteredComponentName<Ts...>()));
+		}
+
+		bitfield::Bitfield mask = (this->componentIndex[ComponentId<Ts>()] | ...);
+
+		for (auto& collector : this->collectors)
+		{
+			if (collector->mask == mask)
+			{
+				return *collector;
+			}
+		}
+
+		this->collectors.push_back(std::make_unique<Collector>(mask));
+		Collector& created = *this->collectors.back();
+
+		for (Entity e : this->EntitiesWith<Ts...>())
+		{
+			created.Record(e.UUID, 0, e.bitfield);
+		}
+
+		return created;
+	}
+
+	// Sort physically reorders the component data for T, and the order EntitiesWith visits it in, so that compare(lhs, rhs) holds for neighbouring components. Sorting by something like the
+	// Morton code of a position, or by material, keeps neighbouring data close together in memory.
+	//
+	// Use SortMode::Insertion when the data is nearly sorted already, for example when re-sorting
+	// every frame. If T is owned by a group, the group's entities stay at the front and the other
+	// containers of the group are reordered to match.
+	//
+	// Typical usage: ecs.Sort<Position>([](const Position& lhs, const Position& rhs) { return lhs.x < rhs.x; });
+	template<typename T, typename Compare>
+	inline Status ECSManager::Sort(Compare compare, SortMode mode)
+	{
+		size_t componentId = ComponentId<T>();
+
+		if (!this->ComponentIsRegistered(componentId))
+		{
+			BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->GetComponentName<T>()), Status::ComponentNotRegistered);
+		}
+
+		Storage<T>* container = this->GetContainer<T>();
+
+		BaseGroup* group = this->groupOwners[componentId];
+		if (group == nullptr)
+		{
+			container->Sort(0, container->Size(), compare, mode);
+			return Status::Ok;
+		}
+
+		container->Sort(0, group->size, compare, mode);
+		container->Sort(group->size, container->Size(), compare, mode);
+		group->Respect(container);
+		return Status::Ok;
+	}
+
+	// SortAs reorders the component data for To to follow the current order of From. Entities that
+	// have both components come first, in From's order, followed by the rest in their existing order.
+	//
+	// Typical usage: ecs.Sort<Position>(byMortonCode); ecs.SortAs<Velocity, Position>();
+	template<typename To, typename From>
+	inline Status ECSManager::SortAs(SortMode mode)
+	{
+		size_t toId = ComponentId<To>();
+
+		if (!this->ComponentIsRegistered(toId) || !this->ComponentIsRegistered(ComponentId<From>()))
+		{
+			BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->UnregisteredComponentName<To, From>()), Status::ComponentNotRegistered);
+		}
+
+		Storage<To>* container = this->GetContainer<To>();
+		const Storage<From>* source = this->ReadContainer<From>();
+
+		auto key = [source](uint32_t uuid) {
+			return source->Contains(uuid) ? source->IndexOf(uuid) : std::numeric_limits<size_t>::max();
+		};
+
+		BaseGroup* group = this->groupOwners[toId];
+		if (group == nullptr)
+		{
+			container->SortByKey(0, container->Size(), key, mode);
+			return Status::Ok;
+		}
+
+		container->SortByKey(0, group->size, key, mode);
+		container->SortByKey(group->size, container->Size(), key, mode);
+		group->Respect(container);
+		return Status::Ok;
+	}
+
+	// SwapBuffers ends the frame for a double-buffered component: everything written through
+	// GetComponent, Patch or GetComponentArray().next becomes the snapshot that ReadComponent and
+	// GetComponentArray().current return. The swap itself is O(1).
+	//
+	// After a plain swap the write buffer holds the values from two frames ago, so every entity
+	// has to be written each frame. Pass BufferSwap::CopyForward when systems only write some of them.
+	//
+	// Typical usage:
+	//   // in parallel: read neighbours with ReadComponent<Velocity>, write GetComponent<Velocity>(self)
+	//   ecs.SwapBuffers<Velocity>();
+	template<typename T>
+	inline Status ECSManager::SwapBuffers(BufferSwap mode)
+	{
+		static_assert(is_double_buffered_v<T>, "SwapBuffers needs a double_buffered component");
+
+		if (!this->ComponentIsRegistered(ComponentId<T>()))
+		{
+			BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(this->GetComponentName<T>()), Status::ComponentNotRegistered);
+		}
+
+		this->GetContainer<T>()->SwapBuffers(mode);
+		return Status::Ok;
+	}
+
+	// Instantiate creates count entities that each get a copy of every component in the prefab.
+	//
+	// This is much cheaper than calling CreateEntity and AddComponent in a loop: storage is grown
+	// once per component, trivially copyable components are copied with memcpy, every signature is
+	// set up front, and a single EntitiesCreated event is broadcast instead of an EntityCreated and
+	// ComponentAdded event per entity and component.
+	inline std::vector<Entity> ECSManager::Instantiate(const Prefab& prefab, size_t count)
+	{
+		bitfield::Bitfield signature = 0;
+		for (auto& component : prefab.Components())
+		{
+			if (!this->ComponentIsRegistered(component->componentId))
+			{
+				BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(component->componentName), std::vector<Entity>());
+			}
+
+			signature = bitfield::Set(signature, this->componentIndex[component->componentId]);
+		}
+
+		std::vector<Entity> created;
+		created.reserve(count);
+
+		// anything reserved earlier is created individually, the batch is announced as a whole
+		this->PublishReserved(true);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			created.push_back(this->ReserveEntity());
+		}
+		this->PublishReserved(false);
+
+		for (Entity& e : created)
+		{
+			e.bitfield = signature;
+			this->entities.Write(e.UUID) = e;
+			this->RecordChange(e.UUID, 0, signature);
+		}
+
+		for (auto& component : prefab.Components())
+		{
+			component->InstantiateInto(this->WritablePool(component->componentId), created);
+
+			PresenceBitmap& present = this->presence[component->componentId];
+			for (const Entity& e : created)
+			{
+				present.Set(e.UUID);
+			}
+		}
+
+		for (auto& group : this->groups)
+		{
+			if (bitfield::Has(signature, group->mask))
+			{
+				for (const Entity& e : created)
+				{
+					group->Enter(e.UUID);
+				}
+			}
+		}
+
+		EntitiesCreated entitiesCreated(created);
+		this->events.Broadcast(entitiesCreated);
+		return created;
+	}
+
+	// MoveEntities transfers entities and all of their components to another world, for example
+	// when an entity crosses the border between two zones simulated by separate managers. It
+	// returns the entities' handles in the target world, in the same order as `moving`. The old
+	// handles are dead afterwards and may be reused by this world.
+	//
+	// Components are moved pool to pool, one pass per component type, rather than entity by
+	// entity. Component ids are shared by every manager in the process, so a type this world has
+	// registered but the target hasn't is registered there on the fly, with the same storage.
+	// The target broadcasts a single EntitiesCreated event and this world a single EntitiesRemoved
+	// event. Disabled entities stay disabled.
+	//
+	// Entities in a hierarchy can't be moved, since their parent and children would be left
+	// pointing into the wrong world, and each entity may only be listed once. Both worlds are
+	// modified, so neither may be in use by another thread during the call.
+	inline std::vector<Entity> ECSManager::MoveEntities(const std::vector<Entity>& moving, ECSManager& target)
+	{
+		if (&target == this)
+		{
+			BABS_ECS_ERROR(std::invalid_argument("Entities can't be moved to the world they're in"), std::vector<Entity>());
+		}
+
+		std::vector<uint32_t> from;
+		from.reserve(moving.size());
+
+		bitfield::Bitfield used = 0;
+		for (const Entity& e : moving)
+		{
+			if (!this->EntityExists(e.UUID))
+			{
+				BABS_ECS_ERROR(EntityNotFoundException(e.UUID), std::vector<Entity>());
+			}
+
+			from.push_back(e.UUID);
+			used |= this->entities[e.UUID].bitfield;
+		}
+
+		std::vector<uint32_t> sorted = from;
+		std::sort(sorted.begin(), sorted.end());
+		if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+		{
+			BABS_ECS_ERROR(std::invalid_argument("An entity can only be listed once per move"), std::vector<Entity>());
+		}
+
+		if (this->ComponentIsRegistered(ComponentId<Relationship>()))
+		{
+			const ComponentContainer<Relationship>* relationships = this->ReadContainer<Relationship>();
+			for (uint32_t uuid : from)
+			{
+				if (relationships->Contains(uuid))
+				{
+					BABS_ECS_ERROR(std::invalid_argument("Entities in a hierarchy can't be moved to another world"), std::vector<Entity>());
+				}
+			}
+		}
+
+		// the components the moved entities use, and the flag each one has in both worlds
+		struct Moved
+		{
+			size_t componentId;
+			bitfield::Bitfield sourceFlag;
+			bitfield::Bitfield targetFlag;
+		};
+
+		std::vector<Moved> pools;
+		for (size_t componentId = 0; componentId < this->components.size(); ++componentId)
+		{
+			if (this->components[componentId] == nullptr || !bitfield::Has(used, this->componentIndex[componentId]))
+			{
+				continue;
+			}
+
+			if (!target.ComponentIsRegistered(componentId))
+			{
+				std::unique_ptr<BaseContainer> pool = this->components[componentId]->CreateEmpty();
+				std::string uncopyableName = pool->IsCopyable() ? std::string() : typeid(*pool).name();
+
+				if (target.RegisterPool(componentId, std::move(pool), uncopyableName) != Status::Ok)
+				{
+					return std::vector<Entity>();
+				}
+			}
+
+			pools.push_back(Moved{ componentId, this->componentIndex[componentId], target.componentIndex[componentId] });
+		}
+
+		std::vector<Entity> moved;
+		moved.reserve(from.size());
+
+		// like Instantiate, anything reserved earlier in the target is created individually
+		target.PublishReserved(true);
+		for (size_t i = 0; i < from.size(); ++i)
+		{
+			moved.push_back(target.ReserveEntity());
+		}
+		target.PublishReserved(false);
+
+		for (size_t i = 0; i < from.size(); ++i)
+		{
+			bitfield::Bitfield before = this->entities[from[i]].bitfield;
+			bitfield::Bitfield signature = 0;
+			for (const Moved& pool : pools)
+			{
+				if (bitfield::Has(before, pool.sourceFlag))
+				{
+					signature = bitfield::Set(signature, pool.targetFlag);
+				}
+			}
+
+			moved[i].bitfield = signature;
+			target.entities.Write(moved[i].UUID) = moved[i];
+			target.RecordChange(moved[i].UUID, 0, signature);
+
+			// disabled entities arrive disabled
+			if (this->disabled.Test(from[i]))
+			{
+				target.MarkDisabled(moved[i].UUID, true);
+			}
+		}
+
+		for (const Moved& pool : pools)
+		{
+			this->WritablePool(pool.componentId)->MoveInto(*target.WritablePool(pool.componentId), from, moved);
+
+			PresenceBitmap& present = target.presence[pool.componentId];
+			for (const Entity& e : moved)
+			{
+				if (bitfield::Has(e.bitfield, pool.targetFlag))
+				{
+					present.Set(e.UUID);
+				}
+			}
+		}
+
+		for (auto& group : target.groups)
+		{
+			for (const Entity& e : moved)
+			{
+				if (bitfield::Has(e.bitfield, group->mask))
+				{
+					group->Enter(e.UUID);
+				}
+			}
+		}
+
+		EntitiesCreated entitiesCreated(moved);
+		target.events.Broadcast(entitiesCreated);
+
+		std::vector<Entity> leaving;
+		leaving.reserve(from.size());
+		for (uint32_t uuid : from)
+		{
+			leaving.push_back(this->entities[uuid]);
+		}
+		this->RemoveEntities(std::move(leaving));
+
+		return moved;
+	}
+
+	// SetParent attaches child to parent in the entity hierarchy, detaching it from its previous
+	// parent first. Passing a dummy entity (Entity()) as the parent turns child into a root again.
+	//
+	// Both entities get a Relationship component if they don't have one yet. Attaching an entity
+	// to itself or to one of its own descendants throws std::invalid_argument.
+	inline Status ECSManager::SetParent(Entity child, Entity parent)
+	{
+		if (!this->EntityExists(child.UUID))
+		{
+			BABS_ECS_ERROR(EntityNotFoundException(child.UUID), Status::EntityNotFound);
+		}
+
+		if (parent.UUID != 0 && !this->EntityExists(parent.UUID))
+		{
+			BABS_ECS_ERROR(EntityNotFoundException(parent.UUID), Status::EntityNotFound);
+		}
+
+		Status registered = this->RegisterComponent<Relationship>();
+		if (registered != Status::Ok)
+		{
+			return registered;
+		}
+
+		if (!this->HasComponent<Relationship>(child))
+		{
+			this->AddComponent(child, Relationship());
+		}
+
+		if (parent.UUID != 0 && !this->HasComponent<Relationship>(parent))
+		{
+			this->AddComponent(parent, Relationship());
+		}
+
+		// walk up from the new parent to make sure we aren't creating a cycle
+		for (uint32_t ancestor = parent.UUID; ancestor != 0; ancestor = this->GetRelationship(ancestor)->parent)
+		{
+			if (ancestor == child.UUID)
+			{
+				BABS_ECS_ERROR(std::invalid_argument("An entity can't be parented to itself or one of its descendants"), Status::InvalidParent);
+			}
+		}
+
+		this->Detach(child.UUID);
+
+		if (parent.UUID != 0)
+		{
+			Relationship* childRelationship = this->GetRelationship(child.UUID);
+			Relationship* parentRelationship = this->GetRelationship(parent.UUID);
+
+			childRelationship->parent = parent.UUID;
+			childRelationship->nextSibling = parentRelationship->firstChild;
+
+			if (parentRelationship->firstChild != 0)
+			{
+				this->GetRelationship(parentRelationship->firstChild)->prevSibling = child.UUID;
+			}
+
+			parentRelationship->firstChild = child.UUID;
+			parentRelationship->children++;
+		}
+
+		this->UpdateDepths(child.UUID);
+		return Status::Ok;
+	}
+
+	// GetParent returns the entity's parent, or a dummy entity (UUID 0) if it's a root or isn't part
+	// of the hierarchy.
+	inline Entity ECSManager::GetParent(Entity entity)
+	{
+		if (!this->ComponentIsRegistered(ComponentId<Relationship>()))
+		{
+			return Entity();
+		}
+
+		const Relationship* relationship = this->ReadRelationship(entity.UUID);
+		return relationship != nullptr ? Entity(relationship->parent) : Entity();
+	}
+
+	// GetChildren returns the direct children of the entity, most recently attached first.
+	inline std::vector<Entity> ECSManager::GetChildren(Entity entity)
+	{
+		std::vector<Entity> children;
+
+		if (!this->ComponentIsRegistered(ComponentId<Relationship>()))
+		{
+			return children;
+		}
+
+		const Relationship* relationship = this->ReadRelationship(entity.UUID);
+		if (relationship == nullptr)
+		{
+			return children;
+		}
+
+		children.reserve(relationship->children);
+		for (uint32_t child = relationship->firstChild; child != 0; child = this->ReadRelationship(child)->nextSibling)
+		{
+			children.emplace_back(child);
+		}
+
+		return children;
+	}
+
+	// EachInHierarchy calls func(entity, parent) for every entity in the hierarchy, with every parent
+	// visited before its children. parent is a dummy entity (UUID 0) for roots.
+	//
+	// The Relationship container is kept sorted by depth, so this is a single linear pass over packed
+	// data. Re-sorting after SetParent calls uses an insertion sort, which is cheap when only a few
+	// entities changed depth since the last pass. Following up with SortAs<Transform, Relationship>()
+	// puts transforms in the same order, which makes propagating world transforms a cache friendly sweep.
+	//
+	// Typical usage:
+	//   ecs.EachInHierarchy([&](babs_ecs::Entity e, babs_ecs::Entity parent) {
+	//       if (parent.UUID != 0) world(e) = world(parent) * local(e);
+	//   });
+	template<typename Func>
+	inline void ECSManager::EachInHierarchy(Func func)
+	{
+		if (!this->ComponentIsRegistered(ComponentId<Relationship>()))
+		{
+			return;
+		}
+
+		if (this->hierarchyDirty)
+		{
+			this->Sort<Relationship>([](const Relationship& lhs, const Relationship& rhs) {
+				return lhs.depth < rhs.depth;
+			}, SortMode::Insertion);
+			this->hierarchyDirty = false;
+		}
+
+		const ComponentContainer<Relationship>* container = this->ReadContainer<Relationship>();
+		for (size_t i = 0; i < container->Size(); ++i)
+		{
+			func(container->entities[i], Entity(container->data[i].parent));
+		}
+	}
+
+	// Detach unlinks the entity from its parent's list of children, its own children stay attached.
+	inline void ECSManager::Detach(uint32_t child)
+	{
+		Relationship* relationship = this->GetRelationship(child);
+		if (relationship == nullptr || relationship->parent == 0)
+		{
+			return;
+		}
+
+		Relationship* parent = this->GetRelationship(relationship->parent);
+
+		if (relationship->prevSibling != 0)
+		{
+			this->GetRelationship(relationship->prevSibling)->nextSibling = relationship->nextSibling;
+		}
+		else
+		{
+			parent->firstChild = relationship->nextSibling;
+		}
+
+		if (relationship->nextSibling != 0)
+		{
+			this->GetRelationship(relationship->nextSibling)->prevSibling = relationship->prevSibling;
+		}
+
+		parent->children--;
+		relationship->parent = 0;
+		relationship->nextSibling = 0;
+		relationship->prevSibling = 0;
+	}
+
+	// UpdateDepths recomputes the depth of root (from its parent) and of everything below it.
+	inline void ECSManager::UpdateDepths(uint32_t root)
+	{
+		Relationship* relationship = this->GetRelationship(root);
+		relationship->depth = relationship->parent != 0 ? this->GetRelationship(relationship->parent)->depth + 1 : 0;
+
+		for (uint32_t descendant : this->GetDescendants(root))
+		{
+			Relationship* current = this->GetRelationship(descendant);
+			current->depth = this->GetRelationship(current->parent)->depth + 1;
+		}
+
+		this->hierarchyDirty = true;
+	}
+
+	// GetDescendants returns every entity below root, parents before their children.
+	inline std::vector<uint32_t> ECSManager::GetDescendants(uint32_t root)
+	{
+		std::vector<uint32_t> descendants;
+
+		for (uint32_t child = this->ReadRelationship(root)->firstChild; child != 0; child = this->ReadRelationship(child)->nextSibling)
+		{
+			descendants.push_back(child);
+		}
+
+		// descendants doubles as the queue for a breadth first walk
+		for (size_t i = 0; i < descendants.size(); ++i)
+		{
+			for (uint32_t child = this->ReadRelationship(descendants[i])->firstChild; child != 0; child = this->ReadRelationship(child)->nextSibling)
+			{
+				descendants.push_back(child);
+			}
+		}
+
+		return descendants;
+	}
+
+	// SetResource stores a single, global instance of T on the manager, replacing any previous one.
+	// Resources live outside the entity tables, so they don't show up in EntitiesWith() and don't
+	// need registering. Use them for things like time, input and physics settings.
+	//
+	// Typical usage: ecs.SetResource(Time{ 0.016f }); ecs.Resource<Time>().delta;
+	template<typename T>
+	inline T& ECSManager::SetResource(T value)
+	{
+		size_t id = TypeIds<ResourceFamily>::Of<T>();
+
+		if (id >= this->resources.size())
+		{
+			this->resources.resize(id + 1);
+			this->resourcePointers.resize(id + 1, nullptr);
+		}
+
+		auto holder = std::make_unique<ResourceHolder<T>>(std::move(value));
+		this->resourcePointers[id] = &holder->value;
+		this->resources[id] = std::move(holder);
+
+		return *static_cast<T*>(this->resourcePointers[id]);
+	}
+
+	template<typename T>
+	inline bool ECSManager::HasResource()
+	{
+		size_t id = TypeIds<ResourceFamily>::Of<T>();
+		return id < this->resourcePointers.size() && this->resourcePointers[id] != nullptr;
+	}
+
+	template<typename T>
+	inline void ECSManager::RemoveResource()
+	{
+		size_t id = TypeIds<ResourceFamily>::Of<T>();
+
+		if (id < this->resources.size())
+		{
+			this->resources[id].reset();
+			this->resourcePointers[id] = nullptr;
+		}
+	}
+
+	// Fork returns a copy of the world for speculative simulation, like rollback or AI lookahead.
+	//
+	// Component containers aren't copied up front: the fork shares them with this world, and
+	// whichever world first writes to a shared container (adding, removing, GetComponent, Patch,
+	// sorting, ...) gets a copy of that one container. For paged and stable storage that copy
+	// still shares the components themselves, a page is only copied once it's written. Reads
+	// (ReadComponent, HasComponent, EntitiesWith) never copy. The entity table and the presence
+	// and disabled bitmaps share their pages the same way (see PageRefCount), so forking copies a
+	// directory of about one pointer per thousand entities rather than the entities themselves,
+	// and each tick in the fork pays only for the containers and pages it writes. Discarding a
+	// fork just drops its references. Containers owned by a group are the exception and are
+	// copied straight away.
+	//
+	// The fork starts with no event subscribers, groups or collectors. Resources are copied, except
+	// ones that can't be copied, which the fork doesn't have. Pointers and component arrays taken
+	// before the fork may be invalidated by either world's next write, since the writer moves to a
+	// copy. Every registered component has to be copy constructible.
+	//
+	// Threading: the first write to a shared pool swaps the pool for a copy, so it has to happen
+	// on one thread. Double-buffered pools, which GetComponent may write from several threads at
+	// once, are copied by Fork itself, like the pools owned by a group, so that rule only matters
+	// for the other components.
+	//
+	// Typical usage:
+	//   auto lookahead = ecs.Fork();
+	//   for (int tick = 0; tick < 8; ++tick) Simulate(*lookahead);
+	//   float score = Evaluate(*lookahead);
+	inline std::unique_ptr<ECSManager> ECSManager::Fork() const
+	{
+		if (!this->uncopyableComponent.empty())
+		{
+			BABS_ECS_ERROR(babs_ecs::ComponentNotCopyableException(this->uncopyableComponent), nullptr);
+		}
+
+		auto fork = std::make_unique<ECSManager>();
+
+		fork->unusedEntityIndices = this->unusedEntityIndices;
+		fork->reservableFree.store(this->reservableFree.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		fork->nextReserved.store(this->nextReserved.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		fork->bitIndex = this->bitIndex;
+		fork->entities = this->entities;
+
+		fork->components = this->components;
+		for (size_t componentId = 0; componentId < this->components.size(); ++componentId)
+		{
+			// groups move entities around their containers on every change, and double-buffered
+			// containers are written from several threads, so those are copied now
+			const std::shared_ptr<BaseContainer>& pool = this->components[componentId];
+			if (pool != nullptr && (this->groupOwners[componentId] != nullptr || pool->IsDoubleBuffered()))
+			{
+				fork->components[componentId] = pool->Clone();
+			}
+		}
+
+		fork->componentIndex = this->componentIndex;
+		fork->groupOwners.assign(this->groupOwners.size(), nullptr);
+		fork->presence = this->presence;
+		fork->disabled = this->disabled;
+		fork->disabledCount = this->disabledCount;
+		fork->disabledHash = this->disabledHash;
+		fork->hierarchyDirty = this->hierarchyDirty;
+		fork->entityHash = this->entityHash;
+		fork->poolHashes = this->poolHashes;
+		for (const std::atomic<bool>& changed : this->poolChanged)
+		{
+			fork->poolChanged.emplace_back(changed.load(std::memory_order_relaxed));
+		}
+
+		fork->resources.resize(this->resources.size());
+		fork->resourcePointers.resize(this->resourcePointers.size(), nullptr);
+		for (size_t id = 0; id < this->resources.size(); ++id)
+		{
+			if (this->resources[id] != nullptr && (fork->resources[id] = this->resources[id]->Clone()) != nullptr)
+			{
+				fork->resourcePointers[id] = fork->resources[id]->Value();
+			}
+		}
+
+		return fork;
+	}
+
+	// Hash returns a digest of the whole world, for comparing simulation state between machines
+	// (lockstep desync checks, replays). It covers which entities exist, their signatures, which of
+	// them are disabled and the contents of every component container, and doesn't depend on the
+	// order things were added in: two worlds that hold the same entities with the same components
+	// hash the same.
+	//
+	// Components are hashed with component_hash, see Hash.hpp. A world holding a component that
+	// component_hash can't see into (not trivially copyable, not specialized, and not opted out
+	// with presence_only_hash) throws ComponentNotHashableException, or returns 0 with exceptions
+	// off, rather than leave its value out.
+	//
+	// Containers are only rehashed after something that could change them (AddComponent,
+	// GetComponent, Patch, GetComponentArray, sorting, ...), so hashing every tick costs about as
+	// much as the containers written that tick. Writes through a pointer or array obtained before
+	// the previous Hash call aren't seen, get them again each tick. The exception is containers
+	// owned by a group: OwningGroup::Each and Data write them without asking the manager, so
+	// they're rehashed on every call.
+	//
+	// Both sides have to register components in the same order, since signatures depend on it.
+	inline uint64_t ECSManager::Hash()
+	{
+		uint64_t digest = HashAvalanche(this->entityHash) + this->disabledHash;
+
+		for (size_t componentId = 0; componentId < this->components.size(); ++componentId)
+		{
+			if (!this->ComponentIsRegistered(componentId))
+			{
+				continue;
+			}
+
+			if (this->poolChanged[componentId].load(std::memory_order_relaxed) || this->groupOwners[componentId] != nullptr)
+			{
+				// an empty pool hashes the same whatever its values would be
+				BaseContainer* pool = this->components[componentId].get();
+				if (!pool->IsHashable() && pool->Size() > 0)
+				{
+					BABS_ECS_ERROR(babs_ecs::ComponentNotHashableException(typeid(*pool).name()), 0);
+				}
+
+				this->poolHashes[componentId] = this->components[componentId]->Hash();
+				this->poolChanged[componentId].store(false, std::memory_order_relaxed);
+			}
+
+			// keyed by signature bit rather than type id, which depends on the order of first use
+			digest += HashMix(this->poolHashes[componentId], this->componentIndex[componentId]);
+		}
+
+		return digest;
 	}
 }
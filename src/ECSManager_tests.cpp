@@ -1,6 +1,8 @@
 #include "doctest.h"
 
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "ECSManager.hpp"
 #include "Exceptions.hpp"
@@ -15,6 +17,22 @@ struct AI
 	std::string difficulty;
 };
 
+// seven bytes of padding after set
+struct Flagged
+{
+	bool set;
+	double weight;
+};
+
+template <>
+struct babs_ecs::component_hash<AI>
+{
+	uint64_t operator()(const AI& ai, uint64_t seed) const
+	{
+		return babs_ecs::HashBytes(ai.difficulty.data(), ai.difficulty.size(), seed);
+	}
+};
+
 struct Health
 {
 	int max;
@@ -326,4 +344,1109 @@ TEST_SUITE("Manager deleting entities")
 
 		REQUIRE(ident == nullptr);
 	}
-}
\ No newline at end of file
+}
+
+struct Depth
+{
+	int value;
+};
+
+static bool ByDepth(const Depth& lhs, const Depth& rhs)
+{
+	return lhs.value < rhs.value;
+}
+
+TEST_SUITE("Manager Sorting")
+{
+	TEST_CASE("Sort reorders iteration and keeps lookups working")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Depth>();
+
+		std::vector<babs_ecs::Entity> entities;
+		int values[] = { 5, 3, 9, 1, 7 };
+		for (int value : values)
+		{
+			babs_ecs::Entity e = ecs.CreateEntity();
+			ecs.AddComponent(e, Depth{ value });
+			entities.push_back(e);
+		}
+
+		ecs.Sort<Depth>(ByDepth);
+
+		int last = 0;
+		for (auto e : ecs.EntitiesWith<Depth>())
+		{
+			REQUIRE(ecs.GetComponent<Depth>(e)->value > last);
+			last = ecs.GetComponent<Depth>(e)->value;
+		}
+
+		for (size_t i = 0; i < entities.size(); ++i)
+		{
+			REQUIRE(ecs.GetComponent<Depth>(entities[i])->value == values[i]);
+		}
+	}
+
+	TEST_CASE("Insertion sort fixes up nearly sorted data")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Depth>();
+
+		std::vector<babs_ecs::Entity> entities;
+		for (int i = 0; i < 50; ++i)
+		{
+			babs_ecs::Entity e = ecs.CreateEntity();
+			ecs.AddComponent(e, Depth{ i * 10 });
+			entities.push_back(e);
+		}
+
+		// a couple of entities moved since the last frame
+		ecs.GetComponent<Depth>(entities[3])->value = 255;
+		ecs.GetComponent<Depth>(entities[40])->value = 15;
+
+		ecs.Sort<Depth>(ByDepth, babs_ecs::SortMode::Insertion);
+
+		auto sorted = ecs.EntitiesWith<Depth>();
+		REQUIRE(sorted.size() == 50);
+		for (size_t i = 1; i < sorted.size(); ++i)
+		{
+			REQUIRE(ecs.GetComponent<Depth>(sorted[i - 1])->value <= ecs.GetComponent<Depth>(sorted[i])->value);
+		}
+		REQUIRE(sorted[2] == entities[40]);
+	}
+
+	TEST_CASE("SortAs applies one component's order to another")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Depth>();
+		ecs.RegisterComponent<Health>();
+
+		std::vector<babs_ecs::Entity> entities;
+		int values[] = { 4, 2, 3, 1 };
+		for (int value : values)
+		{
+			babs_ecs::Entity e = ecs.CreateEntity();
+			ecs.AddComponent(e, Health{ value, value });
+			entities.push_back(e);
+		}
+
+		// only some of the entities have a depth
+		ecs.AddComponent(entities[0], Depth{ 4 });
+		ecs.AddComponent(entities[2], Depth{ 3 });
+		ecs.AddComponent(entities[3], Depth{ 1 });
+
+		ecs.Sort<Depth>(ByDepth);
+		ecs.SortAs<Health, Depth>();
+
+		auto order = ecs.EntitiesWith<Health>();
+		REQUIRE(order.size() == 4);
+		REQUIRE(order[0] == entities[3]);
+		REQUIRE(order[1] == entities[2]);
+		REQUIRE(order[2] == entities[0]);
+		REQUIRE(order[3] == entities[1]);
+
+		REQUIRE(ecs.GetComponent<Health>(entities[1])->max == 2);
+	}
+
+	TEST_CASE("Sorting a grouped component keeps the group intact")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Depth>();
+		ecs.RegisterComponent<Health>();
+
+		auto& group = ecs.Group<Depth, Health>();
+
+		for (int i = 0; i < 10; ++i)
+		{
+			babs_ecs::Entity e = ecs.CreateEntity();
+			ecs.AddComponent(e, Depth{ 10 - i });
+
+			if (i % 3 != 0)
+			{
+				ecs.AddComponent(e, Health{ 10 - i, 0 });
+			}
+		}
+
+		ecs.Sort<Depth>(ByDepth);
+
+		REQUIRE(group.Size() == 6);
+
+		int last = 0;
+		group.Each([&](babs_ecs::Entity, Depth& depth, Health& health) {
+			REQUIRE(depth.value == health.max);
+			REQUIRE(depth.value > last);
+			last = depth.value;
+		});
+	}
+
+	TEST_CASE("Sort with unregistered component throws")
+	{
+		babs_ecs::ECSManager ecs;
+
+		CHECK_THROWS_AS(ecs.Sort<Depth>(ByDepth), const babs_ecs::ComponentNotRegisteredException);
+	}
+}
+
+TEST_SUITE("Manager change notifications")
+{
+	TEST_CASE("Patch modifies the component and broadcasts ComponentUpdated")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Health>();
+
+		babs_ecs::Entity e = ecs.CreateEntity();
+		ecs.AddComponent(e, Health{ 10, 10 });
+
+		int updates = 0;
+		ecs.events.Subscribe<babs_ecs::ComponentUpdated<Health>>([&](const babs_ecs::ComponentUpdated<Health>& event) {
+			REQUIRE(event.entity == e);
+			REQUIRE(event.component.current == 3);
+			updates++;
+		});
+
+		Health* patched = ecs.Patch<Health>(e, [](Health& h) { h.current = 3; });
+
+		REQUIRE(updates == 1);
+		REQUIRE(patched == ecs.GetComponent<Health>(e));
+		REQUIRE(ecs.GetComponent<Health>(e)->current == 3);
+
+		// nothing to patch
+		babs_ecs::Entity empty = ecs.CreateEntity();
+		REQUIRE(ecs.Patch<Health>(empty, [](Health& h) { h.current = 0; }) == nullptr);
+		REQUIRE(updates == 1);
+	}
+
+	TEST_CASE("RemoveEntity broadcasts EntityRemoved with the old signature")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Health>();
+
+		babs_ecs::Entity e = ecs.CreateEntity();
+		ecs.AddComponent(e, Health{ 10, 10 });
+
+		bool removed = false;
+		ecs.events.Subscribe<babs_ecs::EntityRemoved>([&](const babs_ecs::EntityRemoved& event) {
+			REQUIRE(event.entity == e);
+			REQUIRE(event.entity.bitfield != 0);
+			removed = true;
+		});
+
+		ecs.RemoveEntity(e);
+		REQUIRE(removed);
+	}
+}
+
+namespace
+{
+	struct Body
+	{
+		float x;
+		float velocity;
+	};
+}
+
+namespace babs_ecs
+{
+	template <>
+	struct soa_layout<Body>
+	{
+		using fields = soa_fields<&Body::x, &Body::velocity>;
+	};
+}
+
+TEST_SUITE("Manager component arrays")
+{
+	TEST_CASE("GetComponentArray exposes the packed pool")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Health>();
+
+		babs_ecs::Entity first = ecs.CreateEntity();
+		babs_ecs::Entity second = ecs.CreateEntity();
+		ecs.AddComponent(first, Health{ 10, 1 });
+		ecs.AddComponent(second, Health{ 10, 2 });
+
+		auto health = ecs.GetComponentArray<Health>();
+		REQUIRE(health.size == 2);
+		REQUIRE(health.entities[0] == first);
+
+		for (size_t i = 0; i < health.size; ++i)
+		{
+			health.data[i].current += 5;
+		}
+
+		REQUIRE(ecs.GetComponent<Health>(first)->current == 6);
+		REQUIRE(ecs.GetComponent<Health>(second)->current == 7);
+	}
+
+	TEST_CASE("SoA components are stored one array per member")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Body>();
+
+		Body removed{ 0.0f, 0.0f };
+		ecs.events.Subscribe<babs_ecs::ComponentRemoved<Body>>([&](const babs_ecs::ComponentRemoved<Body>& e) {
+			removed = e.component;
+		});
+
+		std::vector<babs_ecs::Entity> bodies;
+		for (int i = 0; i < 3; ++i)
+		{
+			bodies.push_back(ecs.CreateEntity());
+			ecs.AddComponent(bodies.back(), Body{ static_cast<float>(i), 1.0f });
+		}
+
+		auto arrays = ecs.GetComponentArray<Body>();
+		float* x = arrays.Field<&Body::x>();
+		const float* velocity = arrays.Field<&Body::velocity>();
+		for (size_t i = 0; i < arrays.PaddedSize<&Body::x>(); ++i)
+		{
+			x[i] += velocity[i];
+		}
+
+		REQUIRE(arrays.Size() == 3);
+		REQUIRE(x[2] == 3.0f);
+		REQUIRE(ecs.HasComponent<Body>(bodies[1]));
+		REQUIRE(ecs.EntitiesWith<Body>().size() == 3);
+
+		ecs.RemoveComponent<Body>(bodies[1]);
+		REQUIRE(removed.x == 2.0f);
+		REQUIRE_FALSE(ecs.HasComponent<Body>(bodies[1]));
+
+		ecs.Sort<Body>([](const Body& lhs, const Body& rhs) { return lhs.x > rhs.x; });
+		arrays = ecs.GetComponentArray<Body>();
+		REQUIRE(arrays.Entities()[0] == bodies[2]);
+		REQUIRE(arrays.Field<&Body::x>()[1] == 1.0f);
+	}
+}
+
+namespace
+{
+	struct Boid
+	{
+		float heading;
+	};
+
+	struct Wing
+	{
+		float lift;
+	};
+}
+
+namespace babs_ecs
+{
+	template <>
+	struct double_buffered<Boid> : std::true_type {};
+
+	template <>
+	struct double_buffered<Wing> : std::true_type {};
+
+	template <>
+	struct component_hash<Boid> : hash_members<&Boid::heading> {};
+
+	template <>
+	struct component_hash<Wing> : hash_members<&Wing::lift> {};
+}
+
+TEST_SUITE("Manager double buffering")
+{
+	TEST_CASE("Systems read the snapshot and write the next frame")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Boid>();
+
+		babs_ecs::Entity left = ecs.CreateEntity();
+		babs_ecs::Entity right = ecs.CreateEntity();
+		ecs.AddComponent(left, Boid{ 0.0f });
+		ecs.AddComponent(right, Boid{ 1.0f });
+
+		// each boid steers towards its neighbour's heading from this frame
+		auto steer = [&](babs_ecs::Entity self, babs_ecs::Entity neighbour) {
+			float own = ecs.ReadComponent<Boid>(self)->heading;
+			ecs.GetComponent<Boid>(self)->heading = (own + ecs.ReadComponent<Boid>(neighbour)->heading) / 2.0f;
+		};
+
+		steer(left, right);
+		steer(right, left);
+
+		// the order of the two writes didn't matter
+		REQUIRE(ecs.GetComponent<Boid>(left)->heading == 0.5f);
+		REQUIRE(ecs.GetComponent<Boid>(right)->heading == 0.5f);
+		REQUIRE(ecs.ReadComponent<Boid>(left)->heading == 0.0f);
+
+		REQUIRE(ecs.SwapBuffers<Boid>() == babs_ecs::Status::Ok);
+		REQUIRE(ecs.ReadComponent<Boid>(left)->heading == 0.5f);
+		REQUIRE(ecs.ReadComponent<Boid>(right)->heading == 0.5f);
+
+		auto boids = ecs.GetComponentArray<Boid>();
+		REQUIRE(boids.size == 2);
+		REQUIRE(boids.current[0].heading == 0.5f);
+	}
+
+	TEST_CASE("Several threads can write double-buffered components at once")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Boid>();
+		ecs.RegisterComponent<Wing>();
+
+		std::vector<babs_ecs::Entity> boids;
+		for (int i = 0; i < 4000; ++i)
+		{
+			boids.push_back(ecs.CreateEntity());
+			ecs.AddComponent(boids.back(), Boid{ static_cast<float>(i) });
+			ecs.AddComponent(boids.back(), Wing{ 0.0f });
+		}
+		uint64_t before = ecs.Hash();
+
+		// each thread writes its own slice of both pools, reading its neighbours from the snapshot
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < 4; ++t)
+		{
+			threads.emplace_back([&, t]() {
+				for (size_t i = t * 1000; i < (t + 1) * 1000; ++i)
+				{
+					float next = ecs.ReadComponent<Boid>(boids[(i + 1) % boids.size()])->heading;
+					ecs.GetComponent<Boid>(boids[i])->heading = next;
+					ecs.GetComponent<Wing>(boids[i])->lift = next * 2.0f;
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		REQUIRE(ecs.SwapBuffers<Boid>() == babs_ecs::Status::Ok);
+		REQUIRE(ecs.SwapBuffers<Wing>() == babs_ecs::Status::Ok);
+		REQUIRE(ecs.ReadComponent<Boid>(boids[0])->heading == 1.0f);
+		REQUIRE(ecs.ReadComponent<Boid>(boids[3999])->heading == 0.0f);
+		REQUIRE(ecs.ReadComponent<Wing>(boids[2000])->lift == 4002.0f);
+		REQUIRE(ecs.Hash() != before);
+	}
+
+	TEST_CASE("Forked worlds can write double-buffered components from several threads")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Boid>();
+
+		std::vector<babs_ecs::Entity> boids;
+		for (int i = 0; i < 4000; ++i)
+		{
+			boids.push_back(ecs.CreateEntity());
+			ecs.AddComponent(boids.back(), Boid{ 1.0f });
+		}
+
+		// the fork gets its own double-buffered pool up front, so no thread has to copy it
+		auto fork = ecs.Fork();
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < 4; ++t)
+		{
+			threads.emplace_back([&, t]() {
+				for (size_t i = t * 1000; i < (t + 1) * 1000; ++i)
+				{
+					fork->GetComponent<Boid>(boids[i])->heading = 2.0f;
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		REQUIRE(fork->SwapBuffers<Boid>() == babs_ecs::Status::Ok);
+		for (const babs_ecs::Entity& boid : boids)
+		{
+			REQUIRE(fork->ReadComponent<Boid>(boid)->heading == 2.0f);
+			REQUIRE(ecs.GetComponent<Boid>(boid)->heading == 1.0f);
+		}
+	}
+
+	TEST_CASE("ReadComponent on a regular component reads the live data")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Health>();
+
+		babs_ecs::Entity e = ecs.CreateEntity();
+		ecs.AddComponent(e, Health{ 10, 5 });
+		ecs.GetComponent<Health>(e)->current = 6;
+
+		REQUIRE(ecs.ReadComponent<Health>(e)->current == 6);
+		REQUIRE(ecs.ReadComponent<Health>(ecs.CreateEntity()) == nullptr);
+	}
+}
+
+TEST_SUITE("Manager query planning")
+{
+	struct Armed {};
+	struct Shielded {};
+	struct Flying {};
+
+	TEST_CASE("Both query plans find the same entities")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Armed>();
+		ecs.RegisterComponent<Shielded>();
+		ecs.RegisterComponent<Flying>();
+
+		std::vector<babs_ecs::Entity> expected;
+		for (int i = 0; i < 3000; ++i)
+		{
+			babs_ecs::Entity e = ecs.CreateEntity();
+			if (i % 2 == 0) ecs.AddComponent(e, Armed{});
+			if (i % 3 == 0) ecs.AddComponent(e, Shielded{});
+			if (i % 5 == 0) ecs.AddComponent(e, Flying{});
+			if (i % 30 == 0) expected.push_back(e);
+		}
+
+		// common components that are rarely together are intersected as bitmaps
+		REQUIRE(ecs.PlanQuery<Armed, Shielded, Flying>() == babs_ecs::QueryPlan::Bitmaps);
+		auto found = ecs.EntitiesWith<Armed, Shielded, Flying>();
+		REQUIRE(found.size() == expected.size());
+		for (size_t i = 0; i < found.size(); ++i)
+		{
+			REQUIRE(found[i].UUID == expected[i].UUID);
+			REQUIRE(found[i].bitfield == ecs.EntitiesWith<Armed, Shielded, Flying>()[i].bitfield);
+		}
+
+		// the plan can also be forced, the pools were filled in UUID order so the order matches too
+		auto viaPool = ecs.EntitiesWith<Armed, Shielded, Flying>(babs_ecs::QueryPlan::SmallestPool);
+		REQUIRE(viaPool.size() == found.size());
+		for (size_t i = 0; i < viaPool.size(); ++i)
+		{
+			REQUIRE(viaPool[i].UUID == found[i].UUID);
+		}
+
+		// removals clear the bitmaps, both component by component and whole entities
+		ecs.RemoveComponent<Flying>(expected[1]);
+		ecs.RemoveEntity(expected[2]);
+		REQUIRE(ecs.EntitiesWith<Armed, Shielded, Flying>().size() == expected.size() - 2);
+
+		// a rare component drives the query from its pool instead
+		for (uint32_t uuid = 1; uuid <= 2900; ++uuid)
+		{
+			if (ecs.IsAlive(babs_ecs::Entity(uuid)))
+			{
+				ecs.RemoveComponent<Flying>(babs_ecs::Entity(uuid));
+			}
+		}
+		REQUIRE(ecs.PlanQuery<Armed, Shielded, Flying>() == babs_ecs::QueryPlan::SmallestPool);
+		REQUIRE(ecs.EntitiesWith<Armed, Shielded, Flying>().size() == 3);
+		REQUIRE(ecs.PlanQuery<Armed>() == babs_ecs::QueryPlan::SmallestPool);
+	}
+}
+
+namespace
+{
+	struct Script
+	{
+		int state;
+	};
+
+	struct Frozen {};
+
+	struct Quest
+	{
+		int stage;
+	};
+}
+
+namespace babs_ecs
+{
+	template <>
+	struct component_traits<Script>
+	{
+		using storage = stable_storage;
+	};
+
+	template <>
+	struct component_traits<Frozen>
+	{
+		using storage = tag_storage;
+	};
+
+	template <>
+	struct component_traits<Quest>
+	{
+		using storage = map_storage;
+	};
+}
+
+TEST_SUITE("Manager storage policies")
+{
+	TEST_CASE("component_traits picks the container for each component")
+	{
+		static_assert(std::is_same_v<babs_ecs::Storage<Health>, babs_ecs::ComponentContainer<Health>>);
+		static_assert(std::is_same_v<babs_ecs::Storage<Script>, babs_ecs::PagedContainer<Script, true>>);
+		static_assert(std::is_same_v<babs_ecs::Storage<Frozen>, babs_ecs::TagContainer<Frozen>>);
+		static_assert(std::is_same_v<babs_ecs::Storage<Quest>, babs_ecs::MapContainer<Quest>>);
+		static_assert(std::is_same_v<babs_ecs::Storage<Boid>, babs_ecs::DoubleBufferedContainer<Boid>>);
+
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Script>();
+		ecs.RegisterComponent<Frozen>();
+		ecs.RegisterComponent<Quest>();
+
+		std::vector<babs_ecs::Entity> entities;
+		for (int i = 0; i < 100; ++i)
+		{
+			babs_ecs::Entity e = ecs.CreateEntity();
+			ecs.AddComponent(e, Script{ i });
+			if (i % 10 == 0) ecs.AddComponent(e, Frozen{});
+			if (i == 50) ecs.AddComponent(e, Quest{ 3 });
+			entities.push_back(e);
+		}
+
+		// a cached script pointer outlives other entities coming and going
+		Script* cached = ecs.GetComponent<Script>(entities[99]);
+		ecs.RemoveEntity(entities[0]);
+		ecs.RemoveComponent<Script>(entities[1]);
+		ecs.AddComponent(ecs.CreateEntity(), Script{ -1 });
+		REQUIRE(ecs.GetComponent<Script>(entities[99]) == cached);
+		REQUIRE(cached->state == 99);
+
+		REQUIRE(ecs.EntitiesWith<Script, Frozen>().size() == 9);
+		REQUIRE(ecs.HasComponent<Frozen>(entities[10]));
+
+		auto questers = ecs.EntitiesWith<Quest, Script>();
+		REQUIRE(questers.size() == 1);
+		REQUIRE(ecs.GetComponent<Quest>(questers[0])->stage == 3);
+
+		REQUIRE(ecs.RemoveComponent<Quest>(entities[50]) == babs_ecs::Status::Ok);
+		REQUIRE(ecs.GetComponent<Quest>(entities[50]) == nullptr);
+	}
+}
+
+TEST_SUITE("Manager forking")
+{
+	TEST_CASE("A fork shares containers until one side writes")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Health>();
+		ecs.RegisterComponent<AI>();
+		ecs.SetResource(Health{ 1, 1 });
+
+		babs_ecs::Entity hero = ecs.CreateEntity();
+		babs_ecs::Entity villain = ecs.CreateEntity();
+		ecs.AddComponent(hero, Health{ 10, 10 });
+		ecs.AddComponent(villain, Health{ 10, 5 });
+
+		const Health* original = ecs.ReadComponent<Health>(hero);
+		auto fork = ecs.Fork();
+
+		// nothing is copied for reads
+		REQUIRE(fork->ReadComponent<Health>(hero) == original);
+		REQUIRE(fork->EntitiesWith<Health>().size() == 2);
+
+		fork->GetComponent<Health>(hero)->current = 3;
+		fork->RemoveEntity(villain);
+		REQUIRE_FALSE(fork->IsAlive(villain));
+		fork->AddComponent(fork->CreateEntity(), AI{});
+		fork->Resource<Health>().current = 0;
+
+		REQUIRE(fork->ReadComponent<Health>(hero) != original);
+		REQUIRE(fork->ReadComponent<Health>(hero)->current == 3);
+
+		// the parent didn't see any of it
+		REQUIRE(ecs.ReadComponent<Health>(hero) == original);
+		REQUIRE(original->current == 10);
+		REQUIRE(ecs.IsAlive(villain));
+		REQUIRE(ecs.EntitiesWith<AI>().empty());
+		REQUIRE(ecs.Resource<Health>().current == 1);
+
+		// and writing to the parent doesn't reach the fork either
+		ecs.GetComponent<Health>(villain)->current = 1;
+		REQUIRE(fork->EntitiesWith<Health>().size() == 1);
+		REQUIRE(fork->CreateEntity().UUID == ecs.CreateEntity().UUID);
+	}
+
+	TEST_CASE("Grouped containers are copied straight away")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Health>();
+		ecs.RegisterComponent<AI>();
+		auto& group = ecs.Group<Health, AI>();
+
+		babs_ecs::Entity e = ecs.CreateEntity();
+		ecs.AddComponent(e, Health{ 5, 5 });
+		ecs.AddComponent(e, AI{});
+
+		auto fork = ecs.Fork();
+		REQUIRE(fork->ReadComponent<Health>(e) != ecs.ReadComponent<Health>(e));
+
+		// the parent's group keeps working on its own containers
+		ecs.RemoveComponent<AI>(e);
+		REQUIRE(group.Size() == 0);
+		REQUIRE(fork->HasComponent<AI>(e));
+		REQUIRE(fork->Group<Health, AI>().Size() == 1);
+	}
+
+	TEST_CASE("A fork copies a paged pool a page at a time, and only for hits")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Script>();
+
+		std::vector<babs_ecs::Entity> scripted;
+		for (int i = 0; i < 5000; ++i)
+		{
+			scripted.push_back(ecs.CreateEntity());
+			ecs.AddComponent(scripted.back(), Script{ i });
+		}
+		babs_ecs::Entity loner = ecs.CreateEntity();
+
+		auto fork = ecs.Fork();
+
+		// asking for a component the entity doesn't have copies nothing
+		REQUIRE(fork->GetComponent<Script>(loner) == nullptr);
+		REQUIRE(fork->ReadComponent<Script>(scripted[0]) == ecs.ReadComponent<Script>(scripted[0]));
+
+		// a hit copies the page holding the component, the rest stay shared
+		fork->GetComponent<Script>(scripted[0])->state = -1;
+		REQUIRE(fork->ReadComponent<Script>(scripted[0]) != ecs.ReadComponent<Script>(scripted[0]));
+		REQUIRE(fork->ReadComponent<Script>(scripted[4999]) == ecs.ReadComponent<Script>(scripted[4999]));
+		REQUIRE(ecs.ReadComponent<Script>(scripted[0])->state == 0);
+
+		// removing from the original copies the other page before destroying anything in it
+		ecs.RemoveComponent<Script>(scripted[4999]);
+		REQUIRE(fork->ReadComponent<Script>(scripted[4999])->state == 4999);
+
+		fork.reset();
+		REQUIRE(ecs.EntitiesWith<Script>().size() == 4999);
+		REQUIRE(ecs.ReadComponent<Script>(scripted[4998])->state == 4998);
+	}
+}
+
+TEST_SUITE("Manager hashing")
+{
+	TEST_CASE("Worlds with the same state hash the same, whatever order it was built in")
+	{
+		babs_ecs::ECSManager first;
+		babs_ecs::ECSManager second;
+		for (babs_ecs::ECSManager* ecs : { &first, &second })
+		{
+			ecs->RegisterComponent<Health>();
+			ecs->RegisterComponent<Depth>();
+			for (int i = 0; i < 4; ++i)
+			{
+				ecs->CreateEntity();
+			}
+		}
+
+		for (uint32_t uuid = 1; uuid <= 4; ++uuid)
+		{
+			first.AddComponent(babs_ecs::Entity(uuid), Health{ 10, int(uuid) });
+			second.AddComponent(babs_ecs::Entity(5 - uuid), Health{ 10, int(5 - uuid) });
+		}
+		first.AddComponent(babs_ecs::Entity(2), Depth{ 1 });
+		second.AddComponent(babs_ecs::Entity(2), Depth{ 1 });
+
+		REQUIRE(first.Hash() == second.Hash());
+
+		// the cached hash of a container is refreshed after it's written to
+		first.GetComponent<Health>(babs_ecs::Entity(3))->current = 0;
+		REQUIRE(first.Hash() != second.Hash());
+		second.Patch<Health>(babs_ecs::Entity(3), [](Health& health) { health.current = 0; });
+		REQUIRE(first.Hash() == second.Hash());
+
+		// signatures and the entity set count too
+		uint64_t before = first.Hash();
+		first.RemoveComponent<Depth>(babs_ecs::Entity(2));
+		REQUIRE(first.Hash() != before);
+		first.AddComponent(babs_ecs::Entity(2), Depth{ 1 });
+		REQUIRE(first.Hash() == before);
+
+		babs_ecs::Entity extra = first.CreateEntity();
+		REQUIRE(first.Hash() != before);
+		first.RemoveEntity(extra);
+		REQUIRE(first.Hash() == before);
+	}
+
+	TEST_CASE("Components the hash can't see into have to opt out explicitly")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Identity>();
+		ecs.RegisterComponent<AI>();
+
+		// an empty pool hashes the same whatever its values would be
+		babs_ecs::Entity e = ecs.CreateEntity();
+		CHECK_NOTHROW(ecs.Hash());
+
+		ecs.AddComponent(e, Identity{ "a" });
+		CHECK_THROWS_AS(ecs.Hash(), const babs_ecs::ComponentNotHashableException&);
+		ecs.RemoveComponent<Identity>(e);
+
+		// neither do components with padding, whose bytes could differ between equal values
+		babs_ecs::Entity padded = ecs.CreateEntity();
+		ecs.RegisterComponent<Flagged>();
+		ecs.AddComponent(padded, Flagged{ true, 1.0 });
+		CHECK_THROWS_AS(ecs.Hash(), const babs_ecs::ComponentNotHashableException&);
+		ecs.RemoveEntity(padded);
+
+		// a specialized component_hash sees the value
+		ecs.AddComponent(e, AI{ "easy" });
+		uint64_t easy = ecs.Hash();
+		ecs.GetComponent<AI>(e)->difficulty = "hard";
+		REQUIRE(ecs.Hash() != easy);
+	}
+
+	TEST_CASE("Writes through a group change the hash")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Health>();
+		ecs.RegisterComponent<Depth>();
+
+		babs_ecs::Entity e = ecs.CreateEntity();
+		ecs.AddComponent(e, Health{ 10, 10 });
+		ecs.AddComponent(e, Depth{ 1 });
+
+		auto& group = ecs.Group<Health, Depth>();
+		uint64_t before = ecs.Hash();
+
+		group.Each([](babs_ecs::Entity, Health& health, Depth&) { health.current -= 1; });
+		uint64_t damaged = ecs.Hash();
+		REQUIRE(damaged != before);
+
+		group.Data<Health>()[0].current += 1;
+		REQUIRE(ecs.Hash() == before);
+	}
+}
+
+TEST_SUITE("Manager migration")
+{
+	TEST_CASE("MoveEntities carries every component over to the other world")
+	{
+		babs_ecs::ECSManager zone;
+		zone.RegisterComponent<Health>();
+		zone.RegisterComponent<Identity>();
+		zone.RegisterComponent<Boid>();
+		zone.RegisterComponent<Frozen>();
+		zone.RegisterComponent<Body>();
+
+		// registered in a different order, and without Frozen or Body
+		babs_ecs::ECSManager neighbour;
+		neighbour.RegisterComponent<Boid>();
+		neighbour.RegisterComponent<Health>();
+		neighbour.RegisterComponent<Identity>();
+		babs_ecs::Entity local = neighbour.CreateEntity();
+		neighbour.AddComponent(local, Health{ 1, 1 });
+
+		std::vector<babs_ecs::Entity> travellers;
+		for (int i = 0; i < 4; ++i)
+		{
+			babs_ecs::Entity e = zone.CreateEntity();
+			zone.AddComponent(e, Health{ 10, i });
+			zone.AddComponent(e, Identity{ "traveller " + std::to_string(i) });
+			if (i % 2 == 0) zone.AddComponent(e, Frozen{});
+			travellers.push_back(e);
+		}
+		zone.AddComponent(travellers[1], Boid{ 1.0f });
+		zone.GetComponent<Boid>(travellers[1])->heading = 2.0f;
+		zone.AddComponent(travellers[3], Body{ 3.0f, 0.5f });
+		babs_ecs::Entity stay = travellers[2];
+		travellers.erase(travellers.begin() + 2);
+
+		size_t announced = 0;
+		neighbour.events.Subscribe<babs_ecs::EntitiesCreated>([&](const babs_ecs::EntitiesCreated& e) {
+			announced += e.entities.size();
+		});
+		size_t departed = 0;
+		size_t removedOneByOne = 0;
+		zone.events.Subscribe<babs_ecs::EntitiesRemoved>([&](const babs_ecs::EntitiesRemoved& e) {
+			departed += e.entities.size();
+		});
+		zone.events.Subscribe<babs_ecs::EntityRemoved>([&](const babs_ecs::EntityRemoved&) { ++removedOneByOne; });
+
+		// a fork of the source keeps its own copy of the moved components
+		auto before = zone.Fork();
+
+		std::vector<babs_ecs::Entity> arrived = zone.MoveEntities(travellers, neighbour);
+		REQUIRE(arrived.size() == 3);
+		REQUIRE(announced == 3);
+		REQUIRE(departed == 3);
+		REQUIRE(removedOneByOne == 0);
+
+		for (size_t i = 0; i < arrived.size(); ++i)
+		{
+			REQUIRE_FALSE(zone.IsAlive(travellers[i]));
+			REQUIRE(neighbour.IsAlive(arrived[i]));
+		}
+
+		REQUIRE(neighbour.GetComponent<Identity>(arrived[0])->name == "traveller 0");
+		REQUIRE(neighbour.GetComponent<Health>(arrived[2])->current == 3);
+		REQUIRE(neighbour.HasComponent<Frozen>(arrived[0]));
+		REQUIRE_FALSE(neighbour.HasComponent<Frozen>(arrived[1]));
+		REQUIRE(neighbour.ReadComponent<Boid>(arrived[1])->heading == 1.0f);
+		REQUIRE(neighbour.GetComponent<Boid>(arrived[1])->heading == 2.0f);
+		REQUIRE(neighbour.HasComponent<Body>(arrived[2]));
+		REQUIRE(neighbour.GetComponentArray<Body>().Field<&Body::x>()[0] == 3.0f);
+		REQUIRE(neighbour.EntitiesWith<Health, Identity>().size() == 3);
+		REQUIRE(neighbour.EntitiesWith<Health>().size() == 4);
+		REQUIRE(neighbour.GetComponent<Health>(local)->current == 1);
+
+		REQUIRE(zone.EntitiesWith<Health>().size() == 1);
+		REQUIRE(zone.GetComponent<Identity>(stay)->name == "traveller 2");
+		REQUIRE(before->GetComponent<Identity>(travellers[0])->name == "traveller 0");
+
+		// and they can go back again
+		std::vector<babs_ecs::Entity> returned = neighbour.MoveEntities(arrived, zone);
+		REQUIRE(zone.EntitiesWith<Health, Identity>().size() == 4);
+		REQUIRE(zone.HasComponent<Body>(returned[2]));
+		REQUIRE(zone.GetComponentArray<Body>().Field<&Body::velocity>()[0] == 0.5f);
+		REQUIRE(neighbour.EntitiesWith<Health>().size() == 1);
+	}
+
+	TEST_CASE("MoveEntities refuses entities it can't move")
+	{
+		babs_ecs::ECSManager zone;
+		babs_ecs::ECSManager neighbour;
+		zone.RegisterComponent<Health>();
+
+		babs_ecs::Entity parent = zone.CreateEntity();
+		babs_ecs::Entity child = zone.CreateEntity();
+		babs_ecs::Entity loner = zone.CreateEntity();
+		zone.SetParent(child, parent);
+
+		CHECK_THROWS_AS(zone.MoveEntities({ loner, child }, neighbour), const std::invalid_argument);
+		CHECK_THROWS_AS(zone.MoveEntities({ loner, loner }, neighbour), const std::invalid_argument);
+		CHECK_THROWS_AS(zone.MoveEntities({ loner }, zone), const std::invalid_argument);
+		CHECK_THROWS_AS(zone.MoveEntities({ babs_ecs::Entity(42) }, neighbour), const babs_ecs::EntityNotFoundException);
+
+		// nothing was moved by the failed calls
+		REQUIRE(zone.IsAlive(loner));
+		REQUIRE(zone.IsAlive(child));
+		REQUIRE(zone.MoveEntities({ loner }, neighbour).size() == 1);
+	}
+}
+
+TEST_SUITE("Manager bulk operations")
+{
+	TEST_CASE("Bulk operations leave the same world as doing it one entity at a time")
+	{
+		babs_ecs::ECSManager bulk;
+		babs_ecs::ECSManager single;
+		std::vector<babs_ecs::Entity> entities;
+		for (babs_ecs::ECSManager* ecs : { &bulk, &single })
+		{
+			ecs->RegisterComponent<Health>();
+			ecs->RegisterComponent<Depth>();
+			ecs->RegisterComponent<AI>();
+
+			entities.clear();
+			for (int i = 0; i < 20; ++i)
+			{
+				babs_ecs::Entity e = ecs->CreateEntity();
+				ecs->AddComponent(e, Health{ 10, i });
+				if (i % 2 == 0) ecs->AddComponent(e, Depth{ i });
+				if (i % 5 == 0) ecs->AddComponent(e, AI{ "easy" });
+				entities.push_back(e);
+			}
+		}
+
+		size_t removed = 0;
+		size_t removedOneByOne = 0;
+		size_t cleared = 0;
+		size_t added = 0;
+		bulk.events.Subscribe<babs_ecs::EntityRemoved>([&](const babs_ecs::EntityRemoved&) { ++removedOneByOne; });
+		bulk.events.Subscribe<babs_ecs::EntitiesRemoved>([&](const babs_ecs::EntitiesRemoved& e) { removed += e.entities.size(); });
+		bulk.events.Subscribe<babs_ecs::ComponentsRemoved<Depth>>([&](const babs_ecs::ComponentsRemoved<Depth>& e) { cleared += e.entities.size(); });
+		bulk.events.Subscribe<babs_ecs::ComponentsAdded<AI>>([&](const babs_ecs::ComponentsAdded<AI>& e) {
+			added += e.entities.size();
+			REQUIRE(e.component.difficulty == "hard");
+		});
+
+		// destroy everything with both Depth and AI: entities 0 and 10
+		REQUIRE(bulk.DestroyAll<Depth, AI>() == babs_ecs::Status::Ok);
+		single.RemoveEntity(entities[0]);
+		single.RemoveEntity(entities[10]);
+		REQUIRE(removed == 2);
+		REQUIRE(removedOneByOne == 0);
+		REQUIRE_FALSE(bulk.IsAlive(entities[10]));
+
+		REQUIRE(bulk.AddToAll<Depth>(AI{ "hard" }) == babs_ecs::Status::Ok);
+		for (const babs_ecs::Entity& e : single.EntitiesWith<Depth>())
+		{
+			single.AddComponent(e, AI{ "hard" });
+		}
+		REQUIRE(added == 8);
+		REQUIRE(bulk.EntitiesWith<AI, Depth>().size() == 8);
+
+		REQUIRE(bulk.Clear<Depth>() == babs_ecs::Status::Ok);
+		for (const babs_ecs::Entity& e : single.EntitiesWith<Depth>())
+		{
+			single.RemoveComponent<Depth>(e);
+		}
+		REQUIRE(cleared == 8);
+		REQUIRE(bulk.EntitiesWith<Depth>().empty());
+		REQUIRE_FALSE(bulk.HasComponent<Depth>(entities[2]));
+
+		REQUIRE(bulk.Hash() == single.Hash());
+
+		// the freed ids are reused as usual
+		REQUIRE(bulk.CreateEntity() == single.CreateEntity());
+	}
+
+	TEST_CASE("DestroyAll takes descendants along and keeps groups intact")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Health>();
+		ecs.RegisterComponent<AI>();
+		auto& group = ecs.Group<Health, AI>();
+
+		babs_ecs::Entity parent = ecs.CreateEntity();
+		babs_ecs::Entity child = ecs.CreateEntity();
+		babs_ecs::Entity bystander = ecs.CreateEntity();
+		for (babs_ecs::Entity e : { parent, child, bystander })
+		{
+			ecs.AddComponent(e, Health{ 1, 1 });
+		}
+		ecs.AddComponent(child, AI{});
+		ecs.AddComponent(bystander, AI{});
+		ecs.SetParent(child, parent);
+		ecs.RemoveComponent<Health>(parent);
+		ecs.AddComponent(parent, AI{});
+
+		// the grandchild has no AI, but goes with its ancestors
+		babs_ecs::Entity grandchild = ecs.CreateEntity();
+		ecs.SetParent(grandchild, child);
+
+		REQUIRE(ecs.DestroyAll<AI>() == babs_ecs::Status::Ok);
+		REQUIRE(ecs.EntitiesWith<>().empty());
+		REQUIRE(group.Size() == 0);
+
+		babs_ecs::Entity e = ecs.CreateEntity();
+		ecs.AddToAll(Health{ 2, 2 });
+		ecs.AddToAll(AI{});
+		REQUIRE(group.Size() == 1);
+		ecs.Clear<AI>();
+		REQUIRE(group.Size() == 0);
+		REQUIRE(ecs.GetComponent<Health>(e)->current == 2);
+	}
+}
+
+TEST_SUITE("Manager enabled state")
+{
+	struct Bullet {};
+	struct Moving {};
+
+	TEST_CASE("Queries skip disabled entities with every plan")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Bullet>();
+		ecs.RegisterComponent<Moving>();
+
+		std::vector<babs_ecs::Entity> bullets;
+		for (int i = 0; i < 3000; ++i)
+		{
+			bullets.push_back(ecs.CreateEntity());
+			ecs.AddComponent(bullets.back(), Bullet{});
+			if (i % 2 == 0) ecs.AddComponent(bullets.back(), Moving{});
+		}
+
+		// turn off the first 1000, then one more by itself
+		REQUIRE(ecs.SetEnabled(bullets[0], bullets[999], false) == babs_ecs::Status::Ok);
+		REQUIRE(ecs.SetEnabled(bullets[2000], false) == babs_ecs::Status::Ok);
+		REQUIRE_FALSE(ecs.IsEnabled(bullets[500]));
+		REQUIRE(ecs.IsEnabled(bullets[1000]));
+
+		REQUIRE(ecs.EntitiesWith<>().size() == 1999);
+		REQUIRE(ecs.EntitiesWith<Bullet>().size() == 1999);
+		REQUIRE(ecs.PlanQuery<Bullet, Moving>() == babs_ecs::QueryPlan::Bitmaps);
+		REQUIRE(ecs.EntitiesWith<Bullet, Moving>().size() == 999);
+		REQUIRE(ecs.EntitiesWith<Bullet, Moving>().front() == bullets[1000]);
+
+		// asking for them still finds them, and their components were never touched
+		REQUIRE(ecs.EntitiesWith<Bullet>(babs_ecs::DisabledEntities::Include).size() == 3000);
+		REQUIRE(ecs.GetComponentArray<Bullet>().size == 3000);
+		REQUIRE(ecs.HasComponent<Moving>(bullets[0]));
+
+		// a rare component drives the query from its pool, which masks the same way
+		for (int i = 0; i < 2990; i += 2)
+		{
+			ecs.RemoveComponent<Moving>(bullets[i]);
+		}
+		REQUIRE(ecs.PlanQuery<Bullet, Moving>() == babs_ecs::QueryPlan::SmallestPool);
+		REQUIRE(ecs.EntitiesWith<Bullet, Moving>().size() == 5);
+		ecs.SetEnabled(bullets[2990], false);
+		REQUIRE(ecs.EntitiesWith<Bullet, Moving>().size() == 4);
+		REQUIRE(ecs.EntitiesWith<Moving>().size() == 4);
+
+		babs_ecs::QueryCursor cursor;
+		size_t visited = 0;
+		REQUIRE(ecs.Resume<Bullet>(cursor, std::chrono::seconds(10), [&](babs_ecs::Entity) { visited++; }));
+		REQUIRE(visited == 1998);
+
+		// bulk operations follow the queries
+		ecs.DestroyAll<Bullet>();
+		REQUIRE(ecs.EntitiesWith<>(babs_ecs::DisabledEntities::Include).size() == 1002);
+		ecs.SetEnabled(bullets[0], bullets.back(), true);
+		REQUIRE(ecs.EntitiesWith<Bullet>().size() == 1002);
+	}
+
+	TEST_CASE("A pool out of UUID order masks disabled entities just the same")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Bullet>();
+
+		std::vector<babs_ecs::Entity> bullets;
+		for (int i = 0; i < 200; ++i)
+		{
+			bullets.push_back(ecs.CreateEntity());
+			ecs.AddComponent(bullets.back(), Bullet{});
+		}
+		REQUIRE(ecs.SetEnabled(bullets[64], bullets[127], false) == babs_ecs::Status::Ok);
+
+		// every removal moves the pool's last entity into the hole at the front
+		for (int i = 0; i < 10; ++i)
+		{
+			ecs.RemoveComponent<Bullet>(bullets[i]);
+		}
+		REQUIRE(ecs.GetComponentArray<Bullet>().entities[0] == bullets[199]);
+
+		std::vector<babs_ecs::Entity> enabled = ecs.EntitiesWith<Bullet>();
+		REQUIRE(enabled.size() == 126);
+		for (babs_ecs::Entity e : enabled)
+		{
+			REQUIRE(ecs.IsEnabled(e));
+		}
+		REQUIRE(ecs.EntitiesWith<>().size() == 136);
+	}
+
+	TEST_CASE("The enabled state survives forks and moves, and is part of the hash")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Bullet>();
+
+		std::vector<babs_ecs::Entity> bullets;
+		for (int i = 0; i < 10; ++i)
+		{
+			bullets.push_back(ecs.CreateEntity());
+			ecs.AddComponent(bullets.back(), Bullet{});
+		}
+		ecs.RemoveEntity(bullets[5]);
+
+		uint64_t enabledHash = ecs.Hash();
+		REQUIRE(ecs.SetEnabled(bullets[3], bullets[7], false) == babs_ecs::Status::Ok);
+		REQUIRE(ecs.Hash() != enabledHash);
+		REQUIRE(ecs.EntitiesWith<Bullet>().size() == 5);
+
+		std::unique_ptr<babs_ecs::ECSManager> fork = ecs.Fork();
+		REQUIRE(fork->Hash() == ecs.Hash());
+		fork->SetEnabled(bullets[0], bullets[9], true);
+		REQUIRE(fork->Hash() == enabledHash);
+		REQUIRE_FALSE(ecs.IsEnabled(bullets[4]));
+
+		// the removed id wasn't disabled, and a reused id starts out enabled
+		REQUIRE_FALSE(ecs.IsEnabled(bullets[5]));
+		ecs.RemoveEntity(bullets[4]);
+		REQUIRE(ecs.CreateEntity().UUID == bullets[4].UUID);
+		REQUIRE(ecs.IsEnabled(bullets[4]));
+
+		babs_ecs::ECSManager other;
+		std::vector<babs_ecs::Entity> moved = ecs.MoveEntities({ bullets[3], bullets[8] }, other);
+		REQUIRE_FALSE(other.IsEnabled(moved[0]));
+		REQUIRE(other.IsEnabled(moved[1]));
+		REQUIRE(other.EntitiesWith<Bullet>().size() == 1);
+
+		CHECK_THROWS_AS(ecs.SetEnabled(bullets[3], false), const babs_ecs::EntityNotFoundException&);
+		CHECK_THROWS_AS(ecs.SetEnabled(bullets[0], babs_ecs::Entity(100), false), const babs_ecs::EntityNotFoundException&);
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Entity.hpp"
+#include "SharedPages.hpp"
+
+namespace babs_ecs
+{
+	// EntityTable is ECSManager's table of entities indexed by UUID. It's split into pages of
+	// PageSize entities, and copies share the page directory and the pages until they write to them
+	// (see PageDirectory), so forking a world doesn't copy its entities.
+	//
+	// Reads go through operator[], writes through Write, which copies the page first if it's still
+	// shared. Every page up to Size() is allocated.
+	class EntityTable
+	{
+	public:
+		static constexpr uint32_t PageBits = 10;
+		static constexpr uint32_t PageSize = uint32_t(1) << PageBits;
+
+		// operator[] returns the entity stored for uuid, which must be below Size().
+		const Entity& operator[](uint32_t uuid) const
+		{
+			return this->pages[uuid >> PageBits]->entities[uuid & (PageSize - 1)];
+		}
+
+		// Write returns the entity stored for uuid, which must be below Size(), for writing.
+		Entity& Write(uint32_t uuid)
+		{
+			return this->pages.Writable(uuid >> PageBits)->entities[uuid & (PageSize - 1)];
+		}
+
+		size_t Size() const
+		{
+			return this->count;
+		}
+
+		// Append adds an entity at the end of the table, at UUID Size() - 1.
+		void Append(Entity entity)
+		{
+			if (this->count == this->pages.Size() * PageSize)
+			{
+				this->pages.Edit().push_back(new Page);
+			}
+
+			++this->count;
+			this->Write(static_cast<uint32_t>(this->count - 1)) = entity;
+		}
+
+		// Resize grows or shrinks the table to size entities, new ones are default entities (UUID 0).
+		void Resize(size_t size)
+		{
+			while (this->count < size)
+			{
+				this->Append(Entity());
+			}
+
+			this->count = size;
+			while (this->pages.Size() * PageSize >= this->count + PageSize)
+			{
+				std::vector<Page*>& all = this->pages.Edit();
+				ReleasePage(all.back());
+				all.pop_back();
+			}
+		}
+
+		// CopyTo copies the whole table to destination, which has room for Size() entities.
+		void CopyTo(Entity* destination) const
+		{
+			for (size_t page = 0; page < this->pages.Size(); ++page)
+			{
+				size_t first = page * PageSize;
+				size_t entities = this->count - first < PageSize ? this->count - first : PageSize;
+				std::memcpy(static_cast<void*>(destination + first), this->pages[page]->entities, entities * sizeof(Entity));
+			}
+		}
+
+	private:
+		struct Page
+		{
+			Entity entities[PageSize];
+			PageRefCount refs;
+
+			// every page up to the end of the table is allocated, there's no shared empty page
+			static Page* Empty()
+			{
+				return nullptr;
+			}
+		};
+
+		PageDirectory<Page> pages;
+		size_t count = 0;
+	};
+}
@@ -0,0 +1,54 @@
+#include "doctest.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "EntityTable.hpp"
+
+TEST_SUITE("Entity Table")
+{
+	TEST_CASE("Entities are stored by UUID across pages")
+	{
+		babs_ecs::EntityTable table;
+		table.Append(babs_ecs::Entity());
+		table.Resize(3000);
+		REQUIRE(table.Size() == 3000);
+		REQUIRE(table[2999].UUID == 0);
+
+		table.Write(2500) = babs_ecs::Entity(2500);
+		table.Write(2500).bitfield = 4;
+		REQUIRE(table[2500].UUID == 2500);
+		REQUIRE(table[2500].bitfield == 4);
+
+		std::vector<babs_ecs::Entity> flat(table.Size());
+		table.CopyTo(flat.data());
+		REQUIRE(flat[2500].UUID == 2500);
+
+		// shrinking and growing again brings back default entities
+		table.Resize(10);
+		table.Resize(2600);
+		REQUIRE(table[2500].UUID == 0);
+	}
+
+	TEST_CASE("Copies share the table until one of them writes")
+	{
+		babs_ecs::EntityTable table;
+		for (uint32_t uuid = 0; uuid < 2000; ++uuid)
+		{
+			table.Append(babs_ecs::Entity(uuid));
+		}
+
+		babs_ecs::EntityTable copy = table;
+		REQUIRE(&copy[5] == &table[5]);
+
+		// only the written page is copied
+		copy.Write(5).bitfield = 1;
+		REQUIRE(&copy[5] != &table[5]);
+		REQUIRE(&copy[1500] == &table[1500]);
+		REQUIRE(table[5].bitfield == 0);
+
+		table.Append(babs_ecs::Entity(2000));
+		REQUIRE(copy.Size() == 2000);
+		REQUIRE(table[2000].UUID == 2000);
+	}
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include "Entity.hpp"
 
 namespace babs_ecs
@@ -10,6 +13,32 @@ namespace babs_ecs
 		EntityCreated(Entity entity) : entity(entity) {}
 	};
 
+	// EntitiesCreated announces a batch of entities at once, in place of the per-entity
+	// EntityCreated and ComponentAdded events. The entities already carry their signatures. It's
+	// broadcast by ECSManager::Instantiate, by the target world of ECSManager::MoveEntities, and by
+	// a world filled from a file by persistence::Snapshot::Restore.
+	struct EntitiesCreated
+	{
+		std::vector<Entity> entities;
+		EntitiesCreated(std::vector<Entity> entities) : entities(std::move(entities)) {}
+	};
+
+	// EntityRemoved carries the entity as it was just before removal, including its signature
+	struct EntityRemoved
+	{
+		Entity entity;
+		EntityRemoved(Entity entity) : entity(entity) {}
+	};
+
+	// EntitiesRemoved is broadcast once by ECSManager::DestroyAll and MoveEntities for every entity
+	// they removed, in place of the per-entity EntityRemoved events. The entities carry their old
+	// signatures.
+	struct EntitiesRemoved
+	{
+		std::vector<Entity> entities;
+		EntitiesRemoved(std::vector<Entity> entities) : entities(std::move(entities)) {}
+	};
+
 	template <typename T>
 	struct ComponentAdded
 	{
@@ -19,6 +48,17 @@ namespace babs_ecs
 		ComponentAdded(Entity entity, T component) : entity(entity), component(component) {}
 	};
 
+	// ComponentsAdded is broadcast once by ECSManager::AddToAll, in place of a ComponentAdded per
+	// entity. Every entity in the list was given the same component.
+	template <typename T>
+	struct ComponentsAdded
+	{
+		std::vector<Entity> entities;
+		T component;
+
+		ComponentsAdded(std::vector<Entity> entities, T component) : entities(std::move(entities)), component(component) {}
+	};
+
 	template <typename T>
 	struct ComponentRemoved
 	{
@@ -27,4 +67,23 @@ namespace babs_ecs
 
 		ComponentRemoved(Entity entity, T component) : entity(entity), component(component) {}
 	};
+
+	// ComponentsRemoved is broadcast once by ECSManager::Clear, in place of a ComponentRemoved per
+	// entity. It only lists the entities, the removed data is already gone.
+	template <typename T>
+	struct ComponentsRemoved
+	{
+		std::vector<Entity> entities;
+
+		ComponentsRemoved(std::vector<Entity> entities) : entities(std::move(entities)) {}
+	};
+
+	template <typename T>
+	struct ComponentUpdated
+	{
+		Entity entity;
+		T component;
+
+		ComponentUpdated(Entity entity, T component) : entity(entity), component(component) {}
+	};
 }
@@ -1,34 +1,204 @@
 #pragma once
 
-#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
 #include <string>
-#include <sstream>
 #include <exception>
 
+// Exceptions are turned off automatically when compiling with -fno-exceptions (or /EHs-c- on MSVC),
+// and can be turned off by hand by defining BABS_ECS_NO_EXCEPTIONS.
+//
+// With exceptions off, errors that would throw assert in debug builds and are reported through the
+// return value instead: a Status, nullptr or an empty list. Errors in functions that return a
+// reference (Group, Resource) can't be reported that way, and abort.
+#if !defined(BABS_ECS_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(__EXCEPTIONS) && !defined(_CPPUNWIND)
+#define BABS_ECS_NO_EXCEPTIONS
+#endif
+
+#ifdef BABS_ECS_NO_EXCEPTIONS
+#define BABS_ECS_ERROR(exception, result) do { assert(!"babs_ecs: " #exception); return result; } while (0)
+#define BABS_ECS_FATAL(exception) do { assert(!"babs_ecs: " #exception); std::abort(); } while (0)
+#else
+#define BABS_ECS_ERROR(exception, result) throw exception
+#define BABS_ECS_FATAL(exception) throw exception
+#endif
+
 namespace babs_ecs
 {
+    // Status is returned by operations that can fail. With exceptions enabled the failure is thrown
+    // instead, so those builds only ever see Status::Ok.
+    enum class Status
+    {
+        Ok,
+        EntityNotFound,
+        ComponentNotRegistered,
+        TooManyComponents,
+        InvalidParent,
+        PartitionFailed,
+        SnapshotFailed,
+        ExportFailed,
+        DuplicateKey
+    };
+
+
     struct EntityNotFoundException : public std::exception
     {
     public:
-        EntityNotFoundException(uint32_t id) : entityId(id)
+        EntityNotFoundException(uint32_t id) : entityId(id), message(std::to_string(id) + " was not found.") {}
+
+        const char* what() const noexcept override
         {
-            std::cerr << this->entityId<< " was not found." << std::endl;
+            return this->message.c_str();
         }
 
     private:
         uint32_t entityId;
+        std::string message;
     };
 
 
     struct ComponentNotRegisteredException : public std::exception
     {
     public:
-        ComponentNotRegisteredException(std::string componentName) : componentNotRegistered(componentName) 
+        ComponentNotRegisteredException(std::string componentName) : componentNotRegistered(componentName), message(componentName + " must be registered before being used.") {}
+
+        const char* what() const noexcept override
         {
-            std::cerr << this->componentNotRegistered << " must be registered before being used." << std::endl;
+            return this->message.c_str();
         }
 
     private:
         std::string componentNotRegistered;
+        std::string message;
+    };
+
+
+    struct ComponentAlreadyGroupedException : public std::exception
+    {
+    public:
+        ComponentAlreadyGroupedException(std::string componentName) : componentAlreadyGrouped(componentName), message(componentName + " is already owned by a different group.") {}
+
+        const char* what() const noexcept override
+        {
+            return this->message.c_str();
+        }
+
+    private:
+        std::string componentAlreadyGrouped;
+        std::string message;
+    };
+
+
+    struct ResourceNotFoundException : public std::exception
+    {
+    public:
+        ResourceNotFoundException(std::string resourceName) : resourceNotFound(resourceName), message(resourceName + " must be set with SetResource before being used.") {}
+
+        const char* what() const noexcept override
+        {
+            return this->message.c_str();
+        }
+
+    private:
+        std::string resourceNotFound;
+        std::string message;
+    };
+
+
+    struct ComponentNotCopyableException : public std::exception
+    {
+    public:
+        ComponentNotCopyableException(std::string componentName) : componentNotCopyable(componentName), message(componentName + " can't be copied, so worlds that use it can't be forked.") {}
+
+        const char* what() const noexcept override
+        {
+            return this->message.c_str();
+        }
+
+    private:
+        std::string componentNotCopyable;
+        std::string message;
+    };
+
+
+    struct ComponentNotHashableException : public std::exception
+    {
+    public:
+        ComponentNotHashableException(std::string componentName) : componentNotHashable(componentName), message(componentName + " has no component_hash, so worlds that hold it can't be hashed.") {}
+
+        const char* what() const noexcept override
+        {
+            return this->message.c_str();
+        }
+
+    private:
+        std::string componentNotHashable;
+        std::string message;
+    };
+
+
+    struct DuplicateKeyException : public std::exception
+    {
+    public:
+        DuplicateKeyException(uint32_t id, uint32_t holderId) : entityId(id), holderId(holderId), message(std::to_string(id) + " has the same key as " + std::to_string(holderId) + " in a unique index.") {}
+
+        const char* what() const noexcept override
+        {
+            return this->message.c_str();
+        }
+
+    private:
+        uint32_t entityId;
+        uint32_t holderId;
+        std::string message;
+    };
+
+
+    struct PartitionException : public std::exception
+    {
+    public:
+        PartitionException(std::string path, std::string reason) : path(path), message(path + ": " + reason) {}
+
+        const char* what() const noexcept override
+        {
+            return this->message.c_str();
+        }
+
+    private:
+        std::string path;
+        std::string message;
+    };
+
+
+    struct SnapshotException : public std::exception
+    {
+    public:
+        SnapshotException(std::string path, std::string reason) : path(path), message(path + ": " + reason) {}
+
+        const char* what() const noexcept override
+        {
+            return this->message.c_str();
+        }
+
+    private:
+        std::string path;
+        std::string message;
+    };
+
+
+    struct ExportException : public std::exception
+    {
+    public:
+        ExportException(std::string segment, std::string reason) : segment(segment), message(segment + ": " + reason) {}
+
+        const char* what() const noexcept override
+        {
+            return this->message.c_str();
+        }
+
+    private:
+        std::string segment;
+        std::string message;
     };
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "doctest.h"
+
+#include <memory>
+#include <string>
+
+#include "ECSManager.hpp"
+#include "Exceptions.hpp"
+#include "SpawnBuffer.hpp"
+#include "World.hpp"
+#include "indexes/FieldIndex.hpp"
+
+namespace
+{
+	struct Health
+	{
+		int current;
+	};
+
+	struct AI
+	{
+		int state;
+	};
+
+	struct Handle
+	{
+		std::unique_ptr<int> resource;
+	};
+
+	struct Name
+	{
+		std::string value;
+	};
+}
+
+TEST_SUITE("Errors")
+{
+#ifndef BABS_ECS_NO_EXCEPTIONS
+	TEST_CASE("Exceptions describe the error through what()")
+	{
+		babs_ecs::EntityNotFoundException notFound(42);
+		REQUIRE(std::string(notFound.what()) == "42 was not found.");
+
+		babs_ecs::ComponentNotRegisteredException notRegistered("Health");
+		REQUIRE(std::string(notRegistered.what()) == "Health must be registered before being used.");
+
+		babs_ecs::ComponentAlreadyGroupedException grouped("Health");
+		REQUIRE(std::string(grouped.what()) == "Health is already owned by a different group.");
+
+		babs_ecs::ResourceNotFoundException resource("Time");
+		REQUIRE(std::string(resource.what()) == "Time must be set with SetResource before being used.");
+
+		babs_ecs::ComponentNotCopyableException notCopyable("Handle");
+		REQUIRE(std::string(notCopyable.what()) == "Handle can't be copied, so worlds that use it can't be forked.");
+
+		babs_ecs::ComponentNotHashableException notHashable("Name");
+		REQUIRE(std::string(notHashable.what()) == "Name has no component_hash, so worlds that hold it can't be hashed.");
+
+		babs_ecs::DuplicateKeyException duplicate(7, 3);
+		REQUIRE(std::string(duplicate.what()) == "7 has the same key as 3 in a unique index.");
+	}
+
+	TEST_CASE("Worlds with components that can't be copied can't be forked")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Handle>();
+
+		CHECK_THROWS_AS(ecs.Fork(), const babs_ecs::ComponentNotCopyableException&);
+	}
+
+	TEST_CASE("Successful operations return Status::Ok")
+	{
+		babs_ecs::ECSManager ecs;
+		babs_ecs::Entity e = ecs.CreateEntity();
+
+		REQUIRE(ecs.RegisterComponent<Health>() == babs_ecs::Status::Ok);
+		REQUIRE(ecs.AddComponent(e, Health{ 10 }) == babs_ecs::Status::Ok);
+		REQUIRE(ecs.RemoveComponent<Health>(e) == babs_ecs::Status::Ok);
+		REQUIRE(ecs.RemoveEntity(e) == babs_ecs::Status::Ok);
+
+		CHECK_THROWS_AS(ecs.RemoveEntity(e), const babs_ecs::EntityNotFoundException&);
+	}
+#else
+	// these run in the tests-noexcept build, which also defines NDEBUG so the debug asserts stay quiet
+	TEST_CASE("Errors are returned instead of thrown")
+	{
+		babs_ecs::ECSManager ecs;
+		babs_ecs::Entity e = ecs.CreateEntity();
+
+		REQUIRE(ecs.AddComponent(e, Health{ 10 }) == babs_ecs::Status::ComponentNotRegistered);
+		REQUIRE(ecs.RemoveComponent<Health>(e) == babs_ecs::Status::ComponentNotRegistered);
+		REQUIRE(ecs.GetComponent<Health>(e) == nullptr);
+		REQUIRE(ecs.EntitiesWith<Health>().empty());
+
+		REQUIRE(ecs.RegisterComponent<Health>() == babs_ecs::Status::Ok);
+		REQUIRE(ecs.AddComponent(babs_ecs::Entity(42), Health{ 10 }) == babs_ecs::Status::EntityNotFound);
+		REQUIRE(ecs.RemoveEntity(babs_ecs::Entity(42)) == babs_ecs::Status::EntityNotFound);
+		REQUIRE(ecs.SetParent(e, e) == babs_ecs::Status::InvalidParent);
+
+		REQUIRE(ecs.AddComponent(e, Health{ 10 }) == babs_ecs::Status::Ok);
+		REQUIRE(ecs.GetComponent<Health>(e)->current == 10);
+		REQUIRE(ecs.RemoveEntity(e) == babs_ecs::Status::Ok);
+		REQUIRE(ecs.RemoveEntity(e) == babs_ecs::Status::EntityNotFound);
+
+		REQUIRE(ecs.Fork() != nullptr);
+		ecs.RegisterComponent<Handle>();
+		REQUIRE(ecs.Fork() == nullptr);
+	}
+
+	TEST_CASE("A spawn buffer returns the first error and commits the rest")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<AI>();
+
+		babs_ecs::SpawnBuffer spawner(ecs);
+		babs_ecs::Entity first = spawner.Create();
+		babs_ecs::Entity second = spawner.Create();
+		spawner.Add(first, Health{ 10 });
+		spawner.Add(second, AI{ 2 });
+
+		REQUIRE(spawner.Commit() == babs_ecs::Status::ComponentNotRegistered);
+		REQUIRE(ecs.IsAlive(first));
+		REQUIRE(ecs.GetComponent<AI>(second)->state == 2);
+
+		// nothing failed is left staged for the next commit
+		REQUIRE(spawner.Commit() == babs_ecs::Status::Ok);
+	}
+
+	TEST_CASE("A unique index returns duplicate keys instead of throwing")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Name>();
+
+		indexes::UnorderedIndex<&Name::value, indexes::Keys::Unique> byName(ecs);
+
+		babs_ecs::Entity first = ecs.CreateEntity();
+		babs_ecs::Entity second = ecs.CreateEntity();
+		REQUIRE(ecs.AddComponent(first, Name{ "babs" }) == babs_ecs::Status::Ok);
+		REQUIRE(ecs.AddComponent(second, Name{ "babs" }) == babs_ecs::Status::Ok);
+
+		REQUIRE(byName.Find("babs").UUID == first.UUID);
+		REQUIRE(byName.Size() == 1);
+		REQUIRE(byName.Update(second, Name{ "babs" }) == babs_ecs::Status::DuplicateKey);
+	}
+
+	TEST_CASE("World errors are returned instead of thrown")
+	{
+		babs_ecs::World<Health, AI> world;
+
+		REQUIRE(world.AddComponent(babs_ecs::Entity(42), AI{ 1 }) == babs_ecs::Status::EntityNotFound);
+		REQUIRE(world.RemoveComponent<AI>(babs_ecs::Entity(42)) == babs_ecs::Status::EntityNotFound);
+		REQUIRE(world.RemoveEntity(babs_ecs::Entity(42)) == babs_ecs::Status::EntityNotFound);
+	}
+#endif
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+#include "bitfield/bitfield.hpp"
+#include "ComponentContainer.hpp"
+#include "Entity.hpp"
+
+namespace babs_ecs
+{
+	// BaseGroup holds the bookkeeping shared by every owning group. The first `size` slots of
+	// each owned container belong to entities that have all of the group's components, and the
+	// slot order is identical across containers.
+	class BaseGroup
+	{
+	public:
+		BaseGroup(bitfield::Bitfield mask, std::vector<BaseContainer*> pools) : mask(mask), pools(pools), size(0) {}
+		virtual ~BaseGroup() {};
+
+		// Contains checks whether the entity currently sits in the group's leading range.
+		bool Contains(uint32_t uuid) const
+		{
+			BaseContainer* pool = this->pools.front();
+			return pool->Contains(uuid) && pool->IndexOf(uuid) < this->size;
+		}
+
+		// Enter swaps the entity to the end of the leading range in every owned container.
+		// The caller is responsible for checking the entity has all the components first.
+		void Enter(uint32_t uuid)
+		{
+			for (BaseContainer* pool : this->pools)
+			{
+				pool->Swap(pool->IndexOf(uuid), this->size);
+			}
+			this->size++;
+		}
+
+		// Leave swaps the entity just past the leading range in every owned container, so it can
+		// be removed from any of them without disturbing the group.
+		void Leave(uint32_t uuid)
+		{
+			this->size--;
+			for (BaseContainer* pool : this->pools)
+			{
+				pool->Swap(pool->IndexOf(uuid), this->size);
+			}
+		}
+
+		// Respect rearranges the leading range of every other owned container to match `source`,
+		// which is used after one of the group's containers has been sorted.
+		void Respect(BaseContainer* source)
+		{
+			std::vector<uint32_t> order;
+			order.reserve(this->size);
+			for (size_t i = 0; i < this->size; ++i)
+			{
+				order.push_back(source->EntityAt(i).UUID);
+			}
+
+			for (BaseContainer* pool : this->pools)
+			{
+				if (pool != source)
+				{
+					pool->Arrange(0, order);
+				}
+			}
+		}
+
+		bitfield::Bitfield mask;
+		std::vector<BaseContainer*> pools;
+		size_t size;
+	};
+
+	// OwningGroup is created by ECSManager::Group and keeps its containers co-sorted so entities with
+	// all of Ts are found at the same index in every container. Iterating it is a linear walk
+	// over aligned arrays with no lookups or signature checks.
+	//
+	// Typical usage:
+	//   auto& movers = ecs.Group<Transform, Velocity>();
+	//   movers.Each([](babs_ecs::Entity e, Transform& t, Velocity& v) { t.x += v.x; });
+	template <typename... Ts>
+	class OwningGroup : public BaseGroup
+	{
+	public:
+		OwningGroup(bitfield::Bitfield mask, ComponentContainer<Ts>*... containers)
+			: BaseGroup(mask, { containers... }), containers(containers...) {}
+
+		size_t Size() const
+		{
+			return this->size;
+		}
+
+		// Entities returns the packed entity array for the group, valid for [0, Size()).
+		const Entity* Entities() const
+		{
+			return std::get<0>(this->containers)->entities.data();
+		}
+
+		// Data returns the packed component array for T, valid for [0, Size()).
+		template <typename T>
+		T* Data()
+		{
+			return std::get<ComponentContainer<T>*>(this->containers)->data.data();
+		}
+
+		// Each calls func(entity, components...) for every entity in the group. Adding or removing
+		// any of the group's components while iterating is not supported.
+		template <typename Func>
+		void Each(Func func)
+		{
+			const Entity* entities = this->Entities();
+			std::tuple<Ts*...> arrays(this->Data<Ts>()...);
+
+			for (size_t i = 0; i < this->size; ++i)
+			{
+				func(entities[i], std::get<Ts*>(arrays)[i]...);
+			}
+		}
+
+	private:
+		std::tuple<ComponentContainer<Ts>*...> containers;
+	};
+}
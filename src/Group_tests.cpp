@@ -0,0 +1,164 @@
+#include "doctest.h"
+
+#include "ECSManager.hpp"
+#include "Exceptions.hpp"
+
+namespace
+{
+	struct Transform
+	{
+		int x;
+	};
+
+	struct Velocity
+	{
+		int dx;
+	};
+
+	struct Render
+	{
+		int mesh;
+	};
+}
+
+// every entity in the leading range of both containers must be the same, and have both components
+static void RequireCoSorted(babs_ecs::OwningGroup<Transform, Velocity>& group)
+{
+	auto entities = group.Entities();
+	for (size_t i = 0; i < group.Size(); ++i)
+	{
+		REQUIRE(group.Data<Transform>()[i].x == static_cast<int>(entities[i].UUID));
+		REQUIRE(group.Data<Velocity>()[i].dx == static_cast<int>(entities[i].UUID));
+	}
+}
+
+TEST_SUITE("Owning Groups")
+{
+	TEST_CASE("Group picks up entities that already match")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Transform>();
+		ecs.RegisterComponent<Velocity>();
+
+		for (int i = 0; i < 10; ++i)
+		{
+			babs_ecs::Entity e = ecs.CreateEntity();
+			ecs.AddComponent(e, Transform{ static_cast<int>(e.UUID) });
+
+			if (i % 2 == 0)
+			{
+				ecs.AddComponent(e, Velocity{ static_cast<int>(e.UUID) });
+			}
+		}
+
+		auto& group = ecs.Group<Transform, Velocity>();
+
+		REQUIRE(group.Size() == 5);
+		REQUIRE(group.Size() == ecs.EntitiesWith<Transform, Velocity>().size());
+		RequireCoSorted(group);
+	}
+
+	TEST_CASE("AddComponent and RemoveComponent keep the group up to date")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Transform>();
+		ecs.RegisterComponent<Velocity>();
+
+		auto& group = ecs.Group<Transform, Velocity>();
+		REQUIRE(group.Size() == 0);
+
+		std::vector<babs_ecs::Entity> entities;
+		for (int i = 0; i < 8; ++i)
+		{
+			babs_ecs::Entity e = ecs.CreateEntity();
+			entities.push_back(e);
+			ecs.AddComponent(e, Velocity{ static_cast<int>(e.UUID) });
+		}
+
+		// only entities with a Transform as well join the group
+		for (int i = 0; i < 8; i += 2)
+		{
+			ecs.AddComponent(entities[i], Transform{ static_cast<int>(entities[i].UUID) });
+		}
+		REQUIRE(group.Size() == 4);
+		RequireCoSorted(group);
+
+		// overwriting a component doesn't change membership
+		ecs.AddComponent(entities[0], Transform{ static_cast<int>(entities[0].UUID) });
+		REQUIRE(group.Size() == 4);
+
+		ecs.RemoveComponent<Velocity>(entities[2]);
+		REQUIRE(group.Size() == 3);
+		RequireCoSorted(group);
+
+		ecs.RemoveEntity(entities[4]);
+		REQUIRE(group.Size() == 2);
+		RequireCoSorted(group);
+
+		// data outside of the group must be untouched
+		REQUIRE(ecs.GetComponent<Transform>(entities[2])->x == static_cast<int>(entities[2].UUID));
+		REQUIRE(ecs.GetComponent<Velocity>(entities[1])->dx == static_cast<int>(entities[1].UUID));
+		REQUIRE(ecs.GetComponent<Velocity>(entities[4]) == nullptr);
+	}
+
+	TEST_CASE("Each walks the group in lockstep")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Transform>();
+		ecs.RegisterComponent<Velocity>();
+
+		auto& group = ecs.Group<Transform, Velocity>();
+
+		for (int i = 0; i < 5; ++i)
+		{
+			babs_ecs::Entity e = ecs.CreateEntity();
+			ecs.AddComponent(e, Transform{ 0 });
+			ecs.AddComponent(e, Velocity{ i });
+		}
+
+		int visited = 0;
+		group.Each([&](babs_ecs::Entity, Transform& t, Velocity& v) {
+			t.x += v.dx;
+			visited++;
+		});
+
+		REQUIRE(visited == 5);
+		for (auto e : ecs.EntitiesWith<Transform, Velocity>())
+		{
+			REQUIRE(ecs.GetComponent<Transform>(e)->x == ecs.GetComponent<Velocity>(e)->dx);
+		}
+	}
+
+	TEST_CASE("Group returns the same group on repeated calls")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Transform>();
+		ecs.RegisterComponent<Velocity>();
+
+		auto& first = ecs.Group<Transform, Velocity>();
+		auto& second = ecs.Group<Transform, Velocity>();
+
+		REQUIRE(&first == &second);
+	}
+
+	TEST_CASE("A component can only be owned by one group")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Transform>();
+		ecs.RegisterComponent<Velocity>();
+		ecs.RegisterComponent<Render>();
+
+		ecs.Group<Transform, Velocity>();
+
+		CHECK_THROWS_AS((ecs.Group<Transform, Render>()), const babs_ecs::ComponentAlreadyGroupedException);
+		CHECK_THROWS_AS((ecs.Group<Render, Velocity>()), const babs_ecs::ComponentAlreadyGroupedException);
+	}
+
+	TEST_CASE("Group with unregistered component throws")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Transform>();
+
+		CHECK_THROWS_AS((ecs.Group<Transform, Velocity>()), const babs_ecs::ComponentNotRegisteredException);
+	}
+}
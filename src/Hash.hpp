@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace babs_ecs
+{
+	// HashAvalanche scrambles every input bit into every output bit (the xxh3 finalizer).
+	inline uint64_t HashAvalanche(uint64_t h)
+	{
+		h ^= h >> 37;
+		h *= 0x165667919E3779F9ull;
+		h ^= h >> 32;
+		return h;
+	}
+
+	// HashMix folds value into seed.
+	inline uint64_t HashMix(uint64_t seed, uint64_t value)
+	{
+		return HashAvalanche((seed ^ value) * 0x9E3779B185EBCA87ull + 0xC2B2AE3D27D4EB4Full);
+	}
+
+	// HashRound folds one 64 bit word into h (an xxh64 round).
+	inline uint64_t HashRound(uint64_t h, uint64_t word)
+	{
+		h ^= word * 0xC2B2AE3D27D4EB4Full;
+		h = (h << 31) | (h >> 33);
+		return h * 0x9E3779B185EBCA87ull + 0x27D4EB2F165667C5ull;
+	}
+
+	// HashBytes is a fast non-cryptographic hash of size bytes, consuming them eight at a time. It
+	// isn't stable across releases or platforms with a different byte order, so only compare
+	// hashes made by the same build.
+	inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		uint64_t h = seed ^ (size * 0x9E3779B185EBCA87ull);
+
+		for (; size >= 8; size -= 8, bytes += 8)
+		{
+			uint64_t word;
+			std::memcpy(&word, bytes, 8);
+			h = HashRound(h, word);
+		}
+
+		if (size > 0)
+		{
+			uint64_t word = 0;
+			std::memcpy(&word, bytes, size);
+			h = HashRound(h, word);
+		}
+
+		return HashAvalanche(h);
+	}
+
+	// is_bytewise_hashable_v tells whether equal values of T always have equal bytes, so T can be
+	// hashed byte for byte. That rules out padding, whose bytes are indeterminate: two lockstep peers
+	// holding equal values could hash differently and report a desync that isn't there. Floating
+	// point values (and arrays of them) have no padding, so they count too, with the caveats below.
+	template <typename T>
+	constexpr bool is_bytewise_hashable_v = std::is_trivially_copyable_v<T> &&
+		(std::has_unique_object_representations_v<T> || std::is_floating_point_v<std::remove_all_extents_t<T>>);
+
+	// default_component_hash marks the unspecialized component_hash, see has_component_hash_v.
+	struct default_component_hash {};
+
+	// component_hash hashes one component for ECSManager::Hash. Components without padding (see
+	// is_bytewise_hashable_v) are hashed byte for byte. Components stored as SoA (see Layout.hpp)
+	// are hashed member by member instead, so padding between their members doesn't matter. Byte
+	// for byte means -0.0f and 0.0f, or NaNs with different bits, hash differently; specialize this
+	// if they should count as equal. A specialization is used whatever the component's storage.
+	//
+	// Other components, including structs that mix member sizes (a float and a double, or an int
+	// and a bool), have to specialize it, or ECSManager::Hash reports an error as soon as one of
+	// them is in the world. hash_members covers the common case:
+	//
+	//   template <> struct babs_ecs::component_hash<Body>
+	//       : babs_ecs::hash_members<&Body::mass, &Body::sleeping> {};
+	//
+	//   template <> struct babs_ecs::component_hash<Identity>
+	//   {
+	//       uint64_t operator()(const Identity& identity, uint64_t seed) const
+	//       {
+	//           return babs_ecs::HashBytes(identity.name.data(), identity.name.size(), seed);
+	//       }
+	//   };
+	//
+	// Components that don't affect the simulation can opt out with presence_only_hash instead.
+	template <typename T>
+	struct component_hash : default_component_hash
+	{
+		uint64_t operator()(const T& component, uint64_t seed) const
+		{
+			if constexpr (is_bytewise_hashable_v<T> && !std::is_empty_v<T>)
+			{
+				return HashBytes(&component, sizeof(T), seed);
+			}
+			else
+			{
+				// empty components, and the ones ECSManager::Hash refuses to hash
+				return HashAvalanche(seed);
+			}
+		}
+	};
+
+	// presence_only_hash leaves a component's value out of the world hash on purpose, so only which
+	// entities have it counts. Use it for components that never affect the simulation, such as
+	// debug names:
+	//
+	//   template <> struct babs_ecs::component_hash<DebugName> : babs_ecs::presence_only_hash {};
+	struct presence_only_hash
+	{
+		template <typename T>
+		uint64_t operator()(const T&, uint64_t seed) const
+		{
+			return HashAvalanche(seed);
+		}
+	};
+
+	// has_component_hash_v tells whether component_hash was specialized for T.
+	template <typename T>
+	constexpr bool has_component_hash_v = !std::is_base_of_v<default_component_hash, component_hash<T>>;
+
+	// is_hashable_component_v tells whether component_hash covers T's value, or T opted out of that.
+	template <typename T>
+	constexpr bool is_hashable_component_v = has_component_hash_v<T> || is_bytewise_hashable_v<T> || std::is_empty_v<T>;
+
+	// hash_members hashes the listed members one after the other with their own component_hash,
+	// skipping any padding between them. Every member has to be hashable itself.
+	template <auto... Members>
+	struct hash_members
+	{
+		template <typename T>
+		uint64_t operator()(const T& component, uint64_t seed) const
+		{
+			static_assert((is_hashable_component_v<std::decay_t<decltype(component.*Members)>> && ...), "hash_members needs a component_hash for every member");
+
+			((seed = component_hash<std::decay_t<decltype(component.*Members)>>()(component.*Members, seed)), ...);
+			return seed;
+		}
+	};
+
+	// HashComponent is the contribution of one entity's component to its pool's hash. Pools add
+	// these up, so a pool's hash doesn't depend on the order of its slots.
+	template <typename T>
+	inline uint64_t HashComponent(uint32_t uuid, const T& component)
+	{
+		return component_hash<T>()(component, HashMix(0, uuid));
+	}
+}
@@ -0,0 +1,111 @@
+#include "doctest.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "Hash.hpp"
+
+namespace
+{
+	struct Position
+	{
+		float x;
+		float y;
+	};
+
+	struct Name
+	{
+		std::string value;
+	};
+
+	struct DebugName
+	{
+		std::string value;
+	};
+
+	// three bytes of padding after alive
+	struct Padded
+	{
+		bool alive;
+		int32_t hitpoints;
+	};
+
+	struct PaddedByMembers
+	{
+		bool alive;
+		int32_t hitpoints;
+	};
+}
+
+template <>
+struct babs_ecs::component_hash<Position> : babs_ecs::hash_members<&Position::x, &Position::y> {};
+
+template <>
+struct babs_ecs::component_hash<DebugName> : babs_ecs::presence_only_hash {};
+
+template <>
+struct babs_ecs::component_hash<PaddedByMembers> : babs_ecs::hash_members<&PaddedByMembers::alive, &PaddedByMembers::hitpoints> {};
+
+TEST_SUITE("Hashing")
+{
+	TEST_CASE("HashBytes depends on every byte, the length and the seed")
+	{
+		const char text[] = "lockstep simulation";
+		uint64_t whole = babs_ecs::HashBytes(text, sizeof(text), 0);
+
+		REQUIRE(whole == babs_ecs::HashBytes(text, sizeof(text), 0));
+		REQUIRE(whole != babs_ecs::HashBytes(text, sizeof(text), 1));
+		REQUIRE(whole != babs_ecs::HashBytes(text, sizeof(text) - 1, 0));
+
+		char changed[sizeof(text)];
+		std::memcpy(changed, text, sizeof(text));
+		changed[17] ^= 1;
+		REQUIRE(whole != babs_ecs::HashBytes(changed, sizeof(changed), 0));
+
+		// a short tail is zero padded, but the length still tells it apart
+		const char zeros[9] = {};
+		REQUIRE(babs_ecs::HashBytes(zeros, 8, 0) != babs_ecs::HashBytes(zeros, 9, 0));
+	}
+
+	TEST_CASE("Components hash by value and entity")
+	{
+		REQUIRE(babs_ecs::HashComponent(1, Position{ 1.0f, 2.0f }) == babs_ecs::HashComponent(1, Position{ 1.0f, 2.0f }));
+		REQUIRE(babs_ecs::HashComponent(1, Position{ 1.0f, 2.0f }) != babs_ecs::HashComponent(2, Position{ 1.0f, 2.0f }));
+		REQUIRE(babs_ecs::HashComponent(1, Position{ 1.0f, 2.0f }) != babs_ecs::HashComponent(1, Position{ 2.0f, 1.0f }));
+
+		// components that aren't trivially copyable need a component_hash, or an explicit opt-out
+		REQUIRE(babs_ecs::is_hashable_component_v<Position>);
+		REQUIRE_FALSE(babs_ecs::is_hashable_component_v<Name>);
+		REQUIRE(babs_ecs::is_hashable_component_v<DebugName>);
+
+		// padding is indeterminate, so padded structs aren't hashed byte for byte
+		REQUIRE(babs_ecs::is_bytewise_hashable_v<float[3]>);
+		REQUIRE_FALSE(babs_ecs::is_bytewise_hashable_v<Padded>);
+		REQUIRE_FALSE(babs_ecs::is_hashable_component_v<Padded>);
+		REQUIRE(babs_ecs::is_hashable_component_v<PaddedByMembers>);
+
+		// opting out leaves the value out on purpose, only the entity counts
+		REQUIRE(babs_ecs::HashComponent(1, DebugName{ "a" }) == babs_ecs::HashComponent(1, DebugName{ "b" }));
+		REQUIRE(babs_ecs::HashComponent(1, DebugName{ "a" }) != babs_ecs::HashComponent(2, DebugName{ "a" }));
+	}
+
+	TEST_CASE("hash_members skips padding and still sees every member")
+	{
+		// equal values, different padding bytes
+		PaddedByMembers first;
+		PaddedByMembers second;
+		std::memset(&first, 0x00, sizeof(first));
+		std::memset(&second, 0xAB, sizeof(second));
+		first.alive = second.alive = true;
+		first.hitpoints = second.hitpoints = 40;
+
+		REQUIRE(babs_ecs::HashComponent(1, first) == babs_ecs::HashComponent(1, second));
+
+		second.hitpoints = 41;
+		REQUIRE(babs_ecs::HashComponent(1, first) != babs_ecs::HashComponent(1, second));
+		second.hitpoints = 40;
+		second.alive = false;
+		REQUIRE(babs_ecs::HashComponent(1, first) != babs_ecs::HashComponent(1, second));
+	}
+}
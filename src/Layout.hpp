@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// BABS_ECS_ALIGNMENT is the byte alignment of every packed component array. The default suits
+// cache lines and AVX-512; define it as 32 before including the ECS to only cover AVX2.
+#ifndef BABS_ECS_ALIGNMENT
+#define BABS_ECS_ALIGNMENT 64
+#endif
+
+namespace babs_ecs
+{
+	static_assert((BABS_ECS_ALIGNMENT & (BABS_ECS_ALIGNMENT - 1)) == 0, "BABS_ECS_ALIGNMENT must be a power of two");
+
+	// AlignedAllocator hands out memory aligned to Alignment bytes, with the size rounded up to a
+	// whole number of Alignment blocks. Kernels can therefore always load full SIMD registers, even
+	// past the last element, without reading outside the allocation.
+	template <typename T, size_t Alignment = BABS_ECS_ALIGNMENT>
+	class AlignedAllocator
+	{
+	public:
+		using value_type = T;
+
+		static constexpr size_t alignment = Alignment < alignof(T) ? alignof(T) : Alignment;
+
+		template <typename U>
+		struct rebind
+		{
+			using other = AlignedAllocator<U, Alignment>;
+		};
+
+		AlignedAllocator() noexcept {}
+
+		template <typename U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+		// Padded rounds a size in bytes up to the next multiple of the alignment.
+		static constexpr size_t Padded(size_t bytes)
+		{
+			return (bytes + alignment - 1) / alignment * alignment;
+		}
+
+		T* allocate(size_t count)
+		{
+			return static_cast<T*>(::operator new(Padded(count * sizeof(T)), std::align_val_t(alignment)));
+		}
+
+		void deallocate(T* memory, size_t) noexcept
+		{
+			::operator delete(memory, std::align_val_t(alignment));
+		}
+
+		template <typename U>
+		bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept
+		{
+			return true;
+		}
+
+		template <typename U>
+		bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept
+		{
+			return false;
+		}
+	};
+
+	// AlignedVector is the storage used for packed component data.
+	template <typename T>
+	using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+	// PaddedCount is how many T fit in the padded allocation behind count elements. Elements in
+	// [count, PaddedCount(count)) can be read and written, but hold no component data.
+	template <typename T>
+	constexpr size_t PaddedCount(size_t count)
+	{
+		return AlignedAllocator<T>::Padded(count * sizeof(T)) / sizeof(T);
+	}
+
+	// soa_fields lists the members of a component that get their own array in the SoA layout.
+	template <auto... Members>
+	struct soa_fields {};
+
+	// soa_layout opts a component into the structure-of-arrays layout. Specialize it with the
+	// component's members, in any order:
+	//
+	//   template <> struct babs_ecs::soa_layout<Particle>
+	//   {
+	//       using fields = babs_ecs::soa_fields<&Particle::x, &Particle::y, &Particle::z>;
+	//   };
+	//
+	// Every member must be listed, since the component is rebuilt from these arrays when it's
+	// needed as a whole (events, sorting).
+	template <typename T>
+	struct soa_layout {};
+
+	template <typename T, typename = void>
+	struct has_soa_layout : std::false_type {};
+
+	template <typename T>
+	struct has_soa_layout<T, std::void_t<typename soa_layout<T>::fields>> : std::true_type {};
+
+	// double_buffered opts a component into double-buffered storage, where systems read the
+	// snapshot of the current frame and write the next one (see ECSManager::SwapBuffers):
+	//
+	//   template <> struct babs_ecs::double_buffered<Velocity> : std::true_type {};
+	template <typename T>
+	struct double_buffered : std::false_type {};
+
+	// Storage policies pick the container a component is kept in:
+	//
+	//   dense_storage            packed array of T, the default. Fastest to iterate, and the only
+	//                            policy groups can own. Pointers move on insertion and removal.
+	//   paged_storage            packed like dense, but in fixed-size pages, so growing the pool
+	//                            never copies existing components.
+	//   stable_storage           paged, and components never move once added: pointers stay valid
+	//                            until the component is removed, whatever happens to the rest of
+	//                            the pool.
+	//   tag_storage              no data at all, for empty components that only mark entities.
+	//   map_storage              a hash map keyed by entity, for components only a handful of
+	//                            entities ever have, so the pool doesn't keep a slot per UUID.
+	//   soa_storage              one array per member, see soa_layout.
+	//   double_buffered_storage  separate read and write buffers, see double_buffered.
+	struct dense_storage {};
+	struct paged_storage {};
+	struct stable_storage {};
+	struct tag_storage {};
+	struct map_storage {};
+	struct soa_storage {};
+	struct double_buffered_storage {};
+
+	// component_traits is the customisation point for per-component settings. Specialize it to pick
+	// a storage policy:
+	//
+	//   template <> struct babs_ecs::component_traits<Script>
+	//   {
+	//       using storage = babs_ecs::stable_storage;
+	//   };
+	//
+	// By default components with a soa_layout use soa_storage, double_buffered ones use
+	// double_buffered_storage, and everything else is dense.
+	template <typename T>
+	struct component_traits
+	{
+		static_assert(!(has_soa_layout<T>::value && double_buffered<T>::value), "A component can't be both SoA and double-buffered");
+
+		using storage = std::conditional_t<has_soa_layout<T>::value, soa_storage,
+			std::conditional_t<double_buffered<T>::value, double_buffered_storage, dense_storage>>;
+	};
+
+	template <typename T>
+	using storage_policy_t = typename component_traits<T>::storage;
+
+	template <typename T, typename Policy>
+	constexpr bool uses_storage_v = std::is_same_v<storage_policy_t<T>, Policy>;
+
+	template <typename T>
+	constexpr bool is_soa_v = uses_storage_v<T, soa_storage>;
+
+	template <typename T>
+	constexpr bool is_double_buffered_v = uses_storage_v<T, double_buffered_storage>;
+
+	// member_pointer splits a pointer to member into the class and the member's type.
+	template <typename>
+	struct member_pointer;
+
+	template <typename Owner, typename Field>
+	struct member_pointer<Field Owner::*>
+	{
+		using owner = Owner;
+		using field = Field;
+	};
+}
@@ -0,0 +1,67 @@
+#include "doctest.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "Layout.hpp"
+
+namespace
+{
+	struct Vector3
+	{
+		float x;
+		float y;
+		float z;
+	};
+
+	struct Tagged
+	{
+		int tag;
+	};
+}
+
+namespace babs_ecs
+{
+	template <>
+	struct soa_layout<Vector3>
+	{
+		using fields = soa_fields<&Vector3::x, &Vector3::y, &Vector3::z>;
+	};
+}
+
+TEST_SUITE("Layout")
+{
+	TEST_CASE("AlignedAllocator aligns every allocation")
+	{
+		std::vector<float, babs_ecs::AlignedAllocator<float, 32>> avx;
+		std::vector<double, babs_ecs::AlignedAllocator<double, 64>> cacheLine;
+
+		for (int i = 0; i < 100; ++i)
+		{
+			avx.push_back(static_cast<float>(i));
+			cacheLine.push_back(static_cast<double>(i));
+
+			REQUIRE(reinterpret_cast<uintptr_t>(avx.data()) % 32 == 0);
+			REQUIRE(reinterpret_cast<uintptr_t>(cacheLine.data()) % 64 == 0);
+		}
+
+		REQUIRE(avx[99] == 99.0f);
+	}
+
+	TEST_CASE("Allocations are padded to whole alignment blocks")
+	{
+		REQUIRE(babs_ecs::AlignedAllocator<float, 32>::Padded(1) == 32);
+		REQUIRE(babs_ecs::AlignedAllocator<float, 32>::Padded(32) == 32);
+		REQUIRE(babs_ecs::AlignedAllocator<float, 32>::Padded(33) == 64);
+
+		REQUIRE(babs_ecs::PaddedCount<float>(0) == 0);
+		REQUIRE(babs_ecs::PaddedCount<float>(1) == BABS_ECS_ALIGNMENT / sizeof(float));
+		REQUIRE(babs_ecs::PaddedCount<Vector3>(1) == BABS_ECS_ALIGNMENT / sizeof(Vector3));
+	}
+
+	TEST_CASE("soa_layout opts components into the SoA layout")
+	{
+		REQUIRE(babs_ecs::is_soa_v<Vector3>);
+		REQUIRE_FALSE(babs_ecs::is_soa_v<Tagged>);
+	}
+}
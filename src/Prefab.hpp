@@ -0,0 +1,110 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+#include "ComponentContainer.hpp"
+#include "Entity.hpp"
+#include "Relationship.hpp"
+#include "TypeId.hpp"
+
+namespace babs_ecs
+{
+	// BasePrefabComponent is the type-erased default value of one component in a prefab.
+	class BasePrefabComponent
+	{
+	public:
+		BasePrefabComponent(size_t componentId, std::string componentName) : componentId(componentId), componentName(componentName) {};
+		virtual ~BasePrefabComponent() {};
+
+		// InstantiateInto copies the default value into the container for every entity.
+		virtual void InstantiateInto(BaseContainer* container, const std::vector<Entity>& entities) const = 0;
+
+		size_t componentId;
+		std::string componentName;
+	};
+
+	template <typename T>
+	class PrefabComponent : public BasePrefabComponent
+	{
+	public:
+		PrefabComponent(T value) : BasePrefabComponent(TypeIds<ComponentFamily>::Of<T>(), typeid(T).name()), value(value) {};
+		virtual ~PrefabComponent() {};
+
+		void InstantiateInto(BaseContainer* container, const std::vector<Entity>& entities) const override
+		{
+			static_cast<Storage<T>*>(container)->InsertBulk(entities, this->value);
+		}
+
+		T value;
+	};
+
+	// Prefab captures a set of components and their default values, so many identical entities can
+	// be created at once with ECSManager::Instantiate.
+	//
+	// Typical usage:
+	//   babs_ecs::Prefab grunt;
+	//   grunt.Set(Health{ 100, 100 }).Set(AI{ "aggressive" });
+	//   auto wave = ecs.Instantiate(grunt, 5000);
+	class Prefab
+	{
+	public:
+		// Set adds the component to the prefab, or replaces its default value.
+		template <typename T>
+		Prefab& Set(T value)
+		{
+			static_assert(!std::is_same_v<T, Relationship>, "Instances are attached to the hierarchy through SetParent, not a prefab");
+
+			auto component = std::make_unique<PrefabComponent<T>>(value);
+
+			for (auto& existing : this->components)
+			{
+				if (existing->componentId == component->componentId)
+				{
+					existing = std::move(component);
+					return *this;
+				}
+			}
+
+			this->components.push_back(std::move(component));
+			return *this;
+		}
+
+		template <typename T>
+		bool Has() const
+		{
+			return this->Find(TypeIds<ComponentFamily>::Of<T>()) != nullptr;
+		}
+
+		// Get returns the default value for T, or nullptr if the prefab doesn't have it.
+		template <typename T>
+		T* Get()
+		{
+			auto component = static_cast<PrefabComponent<T>*>(this->Find(TypeIds<ComponentFamily>::Of<T>()));
+			return component != nullptr ? &component->value : nullptr;
+		}
+
+		const std::vector<std::unique_ptr<BasePrefabComponent>>& Components() const
+		{
+			return this->components;
+		}
+
+	private:
+		std::vector<std::unique_ptr<BasePrefabComponent>> components;
+
+		BasePrefabComponent* Find(size_t componentId) const
+		{
+			for (auto& component : this->components)
+			{
+				if (component->componentId == componentId)
+				{
+					return component.get();
+				}
+			}
+			return nullptr;
+		}
+	};
+}
@@ -0,0 +1,166 @@
+#include "doctest.h"
+
+#include <string>
+
+#include "ECSManager.hpp"
+#include "Exceptions.hpp"
+#include "Prefab.hpp"
+
+namespace
+{
+	struct Health
+	{
+		int max;
+		int current;
+	};
+
+	struct Name
+	{
+		std::string value;
+	};
+
+	struct Velocity
+	{
+		float dx;
+	};
+
+	struct Spark
+	{
+		float x;
+		float life;
+	};
+}
+
+namespace babs_ecs
+{
+	template <>
+	struct soa_layout<Spark>
+	{
+		using fields = soa_fields<&Spark::x, &Spark::life>;
+	};
+}
+
+TEST_SUITE("Prefabs")
+{
+	TEST_CASE("Prefab stores default component values")
+	{
+		babs_ecs::Prefab prefab;
+		prefab.Set(Health{ 100, 100 }).Set(Name{ "grunt" });
+
+		REQUIRE(prefab.Has<Health>());
+		REQUIRE(prefab.Has<Velocity>() == false);
+		REQUIRE(prefab.Components().size() == 2);
+
+		// setting it again replaces the value
+		prefab.Set(Health{ 50, 50 });
+		REQUIRE(prefab.Components().size() == 2);
+		REQUIRE(prefab.Get<Health>()->max == 50);
+		REQUIRE(prefab.Get<Velocity>() == nullptr);
+	}
+
+	TEST_CASE("Instantiate creates entities with copies of every component")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Health>();
+		ecs.RegisterComponent<Name>();
+		ecs.RegisterComponent<Velocity>();
+
+		babs_ecs::Entity existing = ecs.CreateEntity();
+		ecs.AddComponent(existing, Health{ 1, 1 });
+
+		babs_ecs::Prefab grunt;
+		grunt.Set(Health{ 100, 80 }).Set(Name{ "grunt" });
+
+		auto wave = ecs.Instantiate(grunt, 100);
+
+		REQUIRE(wave.size() == 100);
+		REQUIRE(ecs.EntitiesWith().size() == 101);
+		REQUIRE(ecs.EntitiesWith<Health>().size() == 101);
+		REQUIRE(ecs.EntitiesWith<Health, Name>().size() == 100);
+		REQUIRE(ecs.EntitiesWith<Velocity>().size() == 0);
+
+		for (auto e : wave)
+		{
+			REQUIRE(ecs.GetComponent<Health>(e)->current == 80);
+			REQUIRE(ecs.GetComponent<Name>(e)->value == "grunt");
+		}
+
+		// instances are independent copies
+		ecs.GetComponent<Health>(wave[0])->current = 3;
+		REQUIRE(ecs.GetComponent<Health>(wave[1])->current == 80);
+		REQUIRE(ecs.GetComponent<Health>(existing)->current == 1);
+	}
+
+	TEST_CASE("Instantiate reuses removed entity ids")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Velocity>();
+
+		babs_ecs::Entity first = ecs.CreateEntity();
+		ecs.CreateEntity();
+		ecs.RemoveEntity(first);
+
+		babs_ecs::Prefab bullet;
+		bullet.Set(Velocity{ 5.0f });
+
+		auto bullets = ecs.Instantiate(bullet, 3);
+		REQUIRE(bullets[0].UUID == first.UUID);
+		REQUIRE(bullets[1].UUID == 3);
+		REQUIRE(bullets[2].UUID == 4);
+		REQUIRE(ecs.GetComponent<Velocity>(bullets[0])->dx == 5.0f);
+		REQUIRE(ecs.CreateEntity().UUID == 5);
+	}
+
+	TEST_CASE("Instantiate broadcasts a single batched event and fills groups")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Health>();
+		ecs.RegisterComponent<Velocity>();
+
+		auto& group = ecs.Group<Health, Velocity>();
+
+		int batches = 0;
+		int created = 0;
+		ecs.events.Subscribe<babs_ecs::EntitiesCreated>([&](const babs_ecs::EntitiesCreated& e) {
+			batches++;
+			REQUIRE(e.entities.size() == 10);
+		});
+		ecs.events.Subscribe<babs_ecs::EntityCreated>([&](const babs_ecs::EntityCreated&) { created++; });
+
+		babs_ecs::Prefab prefab;
+		prefab.Set(Health{ 1, 1 }).Set(Velocity{ 1.0f });
+		ecs.Instantiate(prefab, 10);
+
+		REQUIRE(batches == 1);
+		REQUIRE(created == 0);
+		REQUIRE(group.Size() == 10);
+	}
+
+	TEST_CASE("Instantiate with unregistered component throws")
+	{
+		babs_ecs::ECSManager ecs;
+
+		babs_ecs::Prefab prefab;
+		prefab.Set(Health{ 1, 1 });
+
+		CHECK_THROWS_AS(ecs.Instantiate(prefab, 10), const babs_ecs::ComponentNotRegisteredException&);
+		REQUIRE(ecs.EntitiesWith().size() == 0);
+	}
+
+	TEST_CASE("Instantiate fills SoA components")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Spark>();
+
+		babs_ecs::Prefab prefab;
+		prefab.Set(Spark{ 2.0f, 0.5f });
+
+		auto sparks = ecs.Instantiate(prefab, 20);
+		auto arrays = ecs.GetComponentArray<Spark>();
+
+		REQUIRE(arrays.Size() == 20);
+		REQUIRE(arrays.Field<&Spark::x>()[19] == 2.0f);
+		REQUIRE(arrays.Field<&Spark::life>()[0] == 0.5f);
+		REQUIRE(ecs.HasComponent<Spark>(sparks[7]));
+	}
+}
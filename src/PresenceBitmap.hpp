@@ -0,0 +1,348 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "SharedPages.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace babs_ecs
+{
+	// LowestBit returns the index of the lowest set bit, bits must not be 0.
+	inline unsigned LowestBit(uint64_t bits)
+	{
+#if defined(_MSC_VER)
+		unsigned long index = 0;
+		_BitScanForward64(&index, bits);
+		return static_cast<unsigned>(index);
+#else
+		return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+	}
+
+	// PopCount returns the number of set bits.
+	inline unsigned PopCount(uint64_t bits)
+	{
+#if defined(_MSC_VER)
+		return static_cast<unsigned>(__popcnt64(bits));
+#else
+		return static_cast<unsigned>(__builtin_popcountll(bits));
+#endif
+	}
+
+	// PresenceBitmap has one bit per entity UUID, set when the entity has a particular component.
+	// ECSManager keeps one per component so multi-component queries can intersect them a word (or
+	// an AVX2 register) at a time instead of checking entities one by one.
+	//
+	// Like SparseTable, the bits are split into pages of PageWords words that are only allocated
+	// once one of their bits is set, and freed again when their last bit is cleared. Unallocated
+	// pages at the end are dropped from the directory, so a bitmap's memory follows the UUIDs that
+	// currently have the component rather than the highest UUID that ever did, and Intersect skips
+	// whole pages that any of its bitmaps doesn't have. Copies share the directory and the pages
+	// until one side writes to them, see PageDirectory.
+	class PresenceBitmap
+	{
+	public:
+		static constexpr size_t PageWords = 64;
+		static constexpr size_t PageBits = PageWords * 64;
+
+		PresenceBitmap() {}
+
+		PresenceBitmap(const PresenceBitmap& other) : pages(other.pages) {}
+
+		PresenceBitmap(PresenceBitmap&& other) noexcept : pages(std::move(other.pages)), spare(other.spare)
+		{
+			other.spare = nullptr;
+		}
+
+		PresenceBitmap& operator=(PresenceBitmap other) noexcept
+		{
+			std::swap(this->pages, other.pages);
+			std::swap(this->spare, other.spare);
+			return *this;
+		}
+
+		~PresenceBitmap()
+		{
+			delete this->spare;
+		}
+
+		void Set(uint32_t uuid)
+		{
+			size_t page = uuid / PageBits;
+
+			if (page >= this->pages.Size())
+			{
+				this->pages.Edit().resize(page + 1, Page::Empty());
+			}
+
+			this->SetBit(page, uuid);
+		}
+
+		// SetMany sets the bits of the count UUIDs in uuids, growing the directory once for the batch.
+		void SetMany(const uint32_t* uuids, size_t count)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+
+			size_t highest = *std::max_element(uuids, uuids + count) / PageBits;
+			if (highest >= this->pages.Size())
+			{
+				this->pages.Edit().resize(highest + 1, Page::Empty());
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				this->SetBit(uuids[i] / PageBits, uuids[i]);
+			}
+		}
+
+		// Clear clears the bit for uuid, freeing its page if it was the last bit set in it.
+		void Clear(uint32_t uuid)
+		{
+			size_t page = uuid / PageBits;
+			uint64_t bit = uint64_t(1) << (uuid % 64);
+			if ((this->Word(uuid / 64) & bit) == 0)
+			{
+				return;
+			}
+
+			Page* target = this->pages.Writable(page);
+			target->words[uuid / 64 % PageWords] &= ~bit;
+			if (--target->live == 0)
+			{
+				this->Release(page);
+			}
+		}
+
+		bool Test(uint32_t uuid) const
+		{
+			return (this->Word(uuid / 64) >> (uuid % 64) & 1) != 0;
+		}
+
+		// Word returns the 64 bits starting at UUID word * 64, which are zero past the end.
+		uint64_t Word(size_t word) const
+		{
+			size_t page = word / PageWords;
+			return page < this->pages.Size() ? this->pages[page]->words[word % PageWords] : 0;
+		}
+
+		// Store overwrites the 64 bits starting at UUID word * 64. Storing zero never allocates.
+		void Store(size_t word, uint64_t bits)
+		{
+			size_t page = word / PageWords;
+
+			if (page >= this->pages.Size())
+			{
+				if (bits == 0)
+				{
+					return;
+				}
+
+				this->pages.Edit().resize(page + 1, Page::Empty());
+			}
+
+			if (this->pages[page] == Page::Empty() && bits == 0)
+			{
+				return;
+			}
+
+			Page* target = this->Writable(page);
+			uint64_t& stored = target->words[word % PageWords];
+			target->live = target->live + PopCount(bits) - PopCount(stored);
+			stored = bits;
+
+			if (target->live == 0)
+			{
+				this->Release(page);
+			}
+		}
+
+		// WordCount returns the number of words covered by the directory, a multiple of PageWords.
+		// Every bit past it is zero.
+		size_t WordCount() const
+		{
+			return this->pages.Size() * PageWords;
+		}
+
+		// PageData returns the PageWords words of page, or nullptr if none of its bits are set.
+		const uint64_t* PageData(size_t page) const
+		{
+			return page < this->pages.Size() && this->pages[page] != Page::Empty() ? this->pages[page]->words : nullptr;
+		}
+
+		// PageCount returns the number of pages currently allocated, not counting the spare.
+		size_t PageCount() const
+		{
+			const std::vector<Page*>& all = this->pages.Pages();
+			return static_cast<size_t>(std::count_if(all.begin(), all.end(), [](const Page* page) {
+				return page != Page::Empty();
+			}));
+		}
+
+	private:
+		struct Page
+		{
+			alignas(64) uint64_t words[PageWords];
+			uint32_t live;
+			PageRefCount refs;
+
+			// Empty is the shared page every unallocated directory entry points to. It is never written.
+			static Page* Empty()
+			{
+				static Page empty = [] {
+					Page page;
+					std::fill(std::begin(page.words), std::end(page.words), uint64_t(0));
+					page.live = 0;
+					return page;
+				}();
+
+				return &empty;
+			}
+		};
+
+		PageDirectory<Page> pages;
+		Page* spare = nullptr;
+
+		void SetBit(size_t index, uint32_t uuid)
+		{
+			Page* page = this->Writable(index);
+			uint64_t& word = page->words[uuid / 64 % PageWords];
+			uint64_t bit = uint64_t(1) << (uuid % 64);
+			page->live += (word & bit) == 0 ? 1 : 0;
+			word |= bit;
+		}
+
+		// Writable returns page index ready to be written, allocating it if it's the Empty page and
+		// copying it (and the directory) if it's shared with another bitmap.
+		Page* Writable(size_t index)
+		{
+			Page*& page = this->pages.Edit()[index];
+			if (page == Page::Empty())
+			{
+				// an emptied page only holds zero words, so the spare can be used as is
+				page = this->spare != nullptr ? this->spare : new Page(*Page::Empty());
+				this->spare = nullptr;
+				return page;
+			}
+
+			return OwnPage(page);
+		}
+
+		void Release(size_t index)
+		{
+			std::vector<Page*>& all = this->pages.Edit();
+			delete this->spare;
+			this->spare = all[index];
+			all[index] = Page::Empty();
+
+			// drop unallocated pages off the end so the directory shrinks with the bitmap
+			while (!all.empty() && all.back() == Page::Empty())
+			{
+				all.pop_back();
+			}
+		}
+	};
+
+	// Intersect calls visit(uuid) for every UUID set in all of the bitmaps, in ascending order.
+	// UUIDs set in excluded, if given, are masked out a word at a time. Pages missing from any of
+	// the bitmaps are skipped without being read.
+	template <size_t Count, typename Visit>
+	inline void Intersect(const PresenceBitmap* const (&bitmaps)[Count], Visit visit, const PresenceBitmap* excluded = nullptr)
+	{
+		static_assert(Count > 0, "Intersect needs at least one bitmap");
+		constexpr size_t PageWords = PresenceBitmap::PageWords;
+
+		// bits past the shortest bitmap can't be set in all of them
+		size_t wordCount = bitmaps[0]->WordCount();
+		for (size_t i = 1; i < Count; ++i)
+		{
+			wordCount = wordCount < bitmaps[i]->WordCount() ? wordCount : bitmaps[i]->WordCount();
+		}
+
+		auto emit = [&visit](size_t word, uint64_t bits) {
+			while (bits != 0)
+			{
+				visit(static_cast<uint32_t>(word * 64 + LowestBit(bits)));
+				bits &= bits - 1;
+			}
+		};
+
+		for (size_t page = 0; page < wordCount / PageWords; ++page)
+		{
+			const uint64_t* words[Count];
+			bool missing = false;
+			for (size_t i = 0; i < Count && !missing; ++i)
+			{
+				words[i] = bitmaps[i]->PageData(page);
+				missing = words[i] == nullptr;
+			}
+
+			if (missing)
+			{
+				continue;
+			}
+
+			// an excluded page that isn't there masks nothing out
+			const uint64_t* excludedWords = excluded != nullptr ? excluded->PageData(page) : nullptr;
+			size_t base = page * PageWords;
+
+#if defined(__AVX2__)
+			// four words per step, skipping blocks where no entity has everything
+			for (size_t word = 0; word < PageWords; word += 4)
+			{
+				__m256i block = _mm256_load_si256(reinterpret_cast<const __m256i*>(words[0] + word));
+				for (size_t i = 1; i < Count; ++i)
+				{
+					block = _mm256_and_si256(block, _mm256_load_si256(reinterpret_cast<const __m256i*>(words[i] + word)));
+				}
+
+				if (excludedWords != nullptr)
+				{
+					block = _mm256_andnot_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(excludedWords + word)), block);
+				}
+
+				if (_mm256_testz_si256(block, block))
+				{
+					continue;
+				}
+
+				alignas(32) uint64_t lanes[4];
+				_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), block);
+				for (size_t lane = 0; lane < 4; ++lane)
+				{
+					emit(base + word + lane, lanes[lane]);
+				}
+			}
+#else
+			for (size_t word = 0; word < PageWords; ++word)
+			{
+				uint64_t bits = words[0][word];
+				for (size_t i = 1; i < Count && bits != 0; ++i)
+				{
+					bits &= words[i][word];
+				}
+
+				if (excludedWords != nullptr)
+				{
+					bits &= ~excludedWords[word];
+				}
+
+				emit(base + word, bits);
+			}
+#endif
+		}
+	}
+}
@@ -0,0 +1,152 @@
+#include "doctest.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "PresenceBitmap.hpp"
+
+TEST_SUITE("Presence bitmaps")
+{
+	TEST_CASE("Bits can be set, cleared and tested")
+	{
+		babs_ecs::PresenceBitmap bitmap;
+		REQUIRE_FALSE(bitmap.Test(5));
+		REQUIRE(bitmap.WordCount() == 0);
+
+		bitmap.Set(5);
+		bitmap.Set(700);
+		REQUIRE(bitmap.Test(5));
+		REQUIRE(bitmap.Test(700));
+		REQUIRE_FALSE(bitmap.Test(6));
+
+		// always whole pages
+		REQUIRE(bitmap.WordCount() % babs_ecs::PresenceBitmap::PageWords == 0);
+		REQUIRE(bitmap.WordCount() * 64 > 700);
+
+		bitmap.Clear(5);
+		bitmap.Clear(100000);
+		REQUIRE_FALSE(bitmap.Test(5));
+	}
+
+	TEST_CASE("Pages are allocated on demand and freed once their last bit is cleared")
+	{
+		babs_ecs::PresenceBitmap bitmap;
+
+		bitmap.Set(3);
+		bitmap.Set(2000000);
+		REQUIRE(bitmap.PageCount() == 2);
+		REQUIRE(bitmap.WordCount() * 64 > 2000000);
+		REQUIRE(bitmap.PageData(100) == nullptr);
+
+		// clearing the highest bit gives the page back and trims the directory
+		bitmap.Clear(2000000);
+		REQUIRE(bitmap.PageCount() == 1);
+		REQUIRE(bitmap.WordCount() == babs_ecs::PresenceBitmap::PageWords);
+		REQUIRE(bitmap.Test(3));
+
+		// storing zero words neither allocates nor keeps a page alive
+		bitmap.Store(100000, 0);
+		REQUIRE(bitmap.WordCount() == babs_ecs::PresenceBitmap::PageWords);
+		bitmap.Store(0, 0);
+		REQUIRE(bitmap.PageCount() == 0);
+		REQUIRE(bitmap.WordCount() == 0);
+
+		// copies own their pages
+		bitmap.Set(5000);
+		babs_ecs::PresenceBitmap copy = bitmap;
+		bitmap.Clear(5000);
+		REQUIRE(copy.Test(5000));
+		REQUIRE_FALSE(bitmap.Test(5000));
+		REQUIRE(bitmap.WordCount() == 0);
+	}
+
+	TEST_CASE("Copies share pages until one of them writes")
+	{
+		babs_ecs::PresenceBitmap bitmap;
+		bitmap.Set(3);
+		bitmap.Set(5000);
+
+		babs_ecs::PresenceBitmap copy = bitmap;
+		REQUIRE(copy.PageData(0) == bitmap.PageData(0));
+		REQUIRE(copy.PageData(1) == bitmap.PageData(1));
+
+		// only the written page is copied
+		copy.Set(4);
+		REQUIRE(copy.PageData(0) != bitmap.PageData(0));
+		REQUIRE(copy.PageData(1) == bitmap.PageData(1));
+		REQUIRE_FALSE(bitmap.Test(4));
+
+		// emptying a shared page leaves the other side's bits alone
+		bitmap.Clear(5000);
+		REQUIRE(bitmap.PageCount() == 1);
+		REQUIRE(copy.Test(5000));
+
+		bitmap.Store(0, 0);
+		REQUIRE(bitmap.PageCount() == 0);
+		REQUIRE(copy.Test(3));
+		REQUIRE(copy.PageCount() == 2);
+	}
+
+	TEST_CASE("Intersect visits the bits set in every bitmap in ascending order")
+	{
+		babs_ecs::PresenceBitmap multiplesOfTwo;
+		babs_ecs::PresenceBitmap multiplesOfThree;
+		babs_ecs::PresenceBitmap shortOne;
+
+		for (uint32_t i = 0; i < 2000; ++i)
+		{
+			if (i % 2 == 0) multiplesOfTwo.Set(i);
+			if (i % 3 == 0) multiplesOfThree.Set(i);
+		}
+		for (uint32_t i = 0; i < 100; ++i)
+		{
+			shortOne.Set(i);
+		}
+
+		std::vector<uint32_t> both;
+		const babs_ecs::PresenceBitmap* const pair[] = { &multiplesOfTwo, &multiplesOfThree };
+		babs_ecs::Intersect(pair, [&both](uint32_t uuid) { both.push_back(uuid); });
+
+		REQUIRE(both.size() == 334);
+		for (size_t i = 0; i < both.size(); ++i)
+		{
+			REQUIRE(both[i] == i * 6);
+		}
+
+		std::vector<uint32_t> all;
+		const babs_ecs::PresenceBitmap* const triple[] = { &multiplesOfTwo, &multiplesOfThree, &shortOne };
+		babs_ecs::Intersect(triple, [&all](uint32_t uuid) { all.push_back(uuid); });
+
+		REQUIRE(all.size() == 17);
+		REQUIRE(all.back() == 96);
+	}
+
+	TEST_CASE("Intersect masks out excluded bits, even when the excluded bitmap is shorter")
+	{
+		babs_ecs::PresenceBitmap everything;
+		babs_ecs::PresenceBitmap odd;
+		babs_ecs::PresenceBitmap excluded;
+
+		for (uint32_t i = 0; i < 3000; ++i)
+		{
+			everything.Set(i);
+			if (i % 2 == 1) odd.Set(i);
+		}
+
+		// whole words go through Store, single bits through Set
+		excluded.Store(0, ~uint64_t(0));
+		excluded.Set(101);
+		REQUIRE(excluded.Word(1) == uint64_t(1) << 37);
+		REQUIRE(excluded.Word(5000) == 0);
+
+		std::vector<uint32_t> kept;
+		const babs_ecs::PresenceBitmap* const pair[] = { &everything, &odd };
+		babs_ecs::Intersect(pair, [&kept](uint32_t uuid) { kept.push_back(uuid); }, &excluded);
+
+		REQUIRE(kept.size() == 1500 - 32 - 1);
+		REQUIRE(kept.front() == 65);
+		REQUIRE(std::find(kept.begin(), kept.end(), 101u) == kept.end());
+		REQUIRE(kept.back() == 2999);
+		REQUIRE(babs_ecs::PopCount(excluded.Word(0)) == 64);
+	}
+}
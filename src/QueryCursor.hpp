@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace babs_ecs
+{
+	// QueryCursor remembers where ECSManager::Resume stopped, so an expensive pass over a query can
+	// be spread across several frames.
+	//
+	// The cursor walks entities in UUID order. That order doesn't change when other entities are
+	// added or removed, so a sweep picks up where it left off and visits each entity at most once.
+	// Entities created behind the cursor are picked up by the next sweep.
+	struct QueryCursor
+	{
+		// position is the next UUID to look at
+		uint32_t position = 1;
+
+		// sweeps counts the completed passes over the whole query
+		size_t sweeps = 0;
+
+		// visited counts the entities handed out so far in the current sweep
+		size_t visited = 0;
+	};
+}
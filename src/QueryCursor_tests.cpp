@@ -0,0 +1,138 @@
+#include "doctest.h"
+
+#include <chrono>
+#include <vector>
+
+#include "ECSManager.hpp"
+#include "QueryCursor.hpp"
+
+namespace
+{
+	struct Agent
+	{
+		int plans;
+	};
+
+	struct Asleep {};
+}
+
+TEST_SUITE("Query cursors")
+{
+	TEST_CASE("A zero budget visits one entity per call and resumes where it stopped")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Agent>();
+
+		std::vector<babs_ecs::Entity> agents;
+		for (int i = 0; i < 3; ++i)
+		{
+			agents.push_back(ecs.CreateEntity());
+			ecs.AddComponent(agents.back(), Agent{ 0 });
+		}
+
+		babs_ecs::QueryCursor cursor;
+		std::vector<uint32_t> visited;
+		auto replan = [&](babs_ecs::Entity e) {
+			visited.push_back(e.UUID);
+			ecs.GetComponent<Agent>(e)->plans++;
+		};
+
+		REQUIRE_FALSE(ecs.Resume<Agent>(cursor, std::chrono::microseconds(0), replan));
+		REQUIRE_FALSE(ecs.Resume<Agent>(cursor, std::chrono::microseconds(0), replan));
+		REQUIRE_FALSE(ecs.Resume<Agent>(cursor, std::chrono::microseconds(0), replan));
+		REQUIRE(visited == std::vector<uint32_t>{ agents[0].UUID, agents[1].UUID, agents[2].UUID });
+		REQUIRE(cursor.visited == 3);
+
+		// nothing is left, so this call only finishes the sweep
+		REQUIRE(ecs.Resume<Agent>(cursor, std::chrono::microseconds(0), replan));
+		REQUIRE(cursor.sweeps == 1);
+		REQUIRE(cursor.visited == 0);
+		REQUIRE(visited.size() == 3);
+	}
+
+	TEST_CASE("A large budget finishes the sweep in one call")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Agent>();
+		ecs.RegisterComponent<Asleep>();
+
+		for (int i = 0; i < 100; ++i)
+		{
+			babs_ecs::Entity e = ecs.CreateEntity();
+			ecs.AddComponent(e, Agent{ 0 });
+			if (i % 2 == 0)
+			{
+				ecs.AddComponent(e, Asleep{});
+			}
+		}
+
+		babs_ecs::QueryCursor cursor;
+		int visited = 0;
+		REQUIRE(ecs.Resume<Agent, Asleep>(cursor, std::chrono::seconds(10), [&](babs_ecs::Entity) { visited++; }));
+		REQUIRE(visited == 50);
+	}
+
+	TEST_CASE("Structural changes between calls don't cause repeats or skips")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Agent>();
+
+		std::vector<babs_ecs::Entity> agents;
+		for (int i = 0; i < 5; ++i)
+		{
+			agents.push_back(ecs.CreateEntity());
+			ecs.AddComponent(agents.back(), Agent{ 0 });
+		}
+
+		babs_ecs::QueryCursor cursor;
+		std::vector<uint32_t> visited;
+		auto record = [&](babs_ecs::Entity e) { visited.push_back(e.UUID); };
+
+		ecs.Resume<Agent>(cursor, std::chrono::microseconds(0), record);
+		ecs.Resume<Agent>(cursor, std::chrono::microseconds(0), record);
+
+		// remove one that wasn't visited yet and one that was, then add a new agent which reuses the
+		// id behind the cursor
+		ecs.RemoveEntity(agents[3]);
+		ecs.RemoveEntity(agents[0]);
+		babs_ecs::Entity late = ecs.CreateEntity();
+		ecs.AddComponent(late, Agent{ 0 });
+
+		while (!ecs.Resume<Agent>(cursor, std::chrono::microseconds(0), record))
+		{
+		}
+
+		REQUIRE(visited == std::vector<uint32_t>{ agents[0].UUID, agents[1].UUID, agents[2].UUID, agents[4].UUID });
+
+		// the next sweep sees the new agent
+		visited.clear();
+		ecs.Resume<Agent>(cursor, std::chrono::seconds(10), record);
+		REQUIRE(late.UUID == agents[0].UUID);
+		REQUIRE(visited == std::vector<uint32_t>{ late.UUID, agents[1].UUID, agents[2].UUID, agents[4].UUID });
+	}
+
+	TEST_CASE("Entities can be removed from inside the callback")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Agent>();
+
+		for (int i = 0; i < 10; ++i)
+		{
+			ecs.AddComponent(ecs.CreateEntity(), Agent{ 0 });
+		}
+
+		babs_ecs::QueryCursor cursor;
+		int visited = 0;
+		ecs.Resume<Agent>(cursor, std::chrono::seconds(10), [&](babs_ecs::Entity e) {
+			visited++;
+			ecs.RemoveEntity(e);
+			if (e.UUID + 1 < 11)
+			{
+				ecs.RemoveEntity(babs_ecs::Entity(e.UUID + 1));
+			}
+		});
+
+		REQUIRE(visited == 5);
+		REQUIRE(ecs.EntitiesWith<Agent>().empty());
+	}
+}
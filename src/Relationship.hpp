@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+namespace babs_ecs
+{
+	// Relationship is the component ECSManager uses to store the entity hierarchy. It's managed by
+	// ECSManager::SetParent, so don't add or modify it yourself. RemoveComponent<Relationship> takes
+	// an entity out of the hierarchy and turns its children into roots. ECSManager::Clear, AddToAll
+	// and Prefab::Set refuse it at compile time, since they can't keep the links consistent.
+	//
+	// Links are stored as UUIDs, with 0 (the dummy entity) meaning "none". Children of a parent form
+	// a doubly linked list starting at firstChild, so attaching and detaching are O(1) and the links
+	// live in the same packed container as every other component.
+	struct Relationship
+	{
+		uint32_t parent = 0;
+		uint32_t firstChild = 0;
+		uint32_t nextSibling = 0;
+		uint32_t prevSibling = 0;
+		uint32_t children = 0;
+
+		// number of ancestors, roots are at depth 0
+		uint32_t depth = 0;
+	};
+}
@@ -0,0 +1,202 @@
+#include "doctest.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include "ECSManager.hpp"
+#include "Exceptions.hpp"
+
+namespace
+{
+	struct Transform
+	{
+		int local;
+		int world;
+	};
+}
+
+TEST_SUITE("Entity hierarchy")
+{
+	TEST_CASE("SetParent links parents and children")
+	{
+		babs_ecs::ECSManager ecs;
+
+		babs_ecs::Entity root = ecs.CreateEntity();
+		babs_ecs::Entity a = ecs.CreateEntity();
+		babs_ecs::Entity b = ecs.CreateEntity();
+
+		ecs.SetParent(a, root);
+		ecs.SetParent(b, root);
+
+		REQUIRE(ecs.GetParent(a) == root);
+		REQUIRE(ecs.GetParent(b) == root);
+		REQUIRE(ecs.GetParent(root).UUID == 0);
+
+		auto children = ecs.GetChildren(root);
+		REQUIRE(children.size() == 2);
+		REQUIRE(ecs.GetComponent<babs_ecs::Relationship>(root)->children == 2);
+		REQUIRE(ecs.GetComponent<babs_ecs::Relationship>(a)->depth == 1);
+
+		// reparenting moves the entity and its depth
+		ecs.SetParent(b, a);
+		REQUIRE(ecs.GetChildren(root).size() == 1);
+		REQUIRE(ecs.GetChildren(a).size() == 1);
+		REQUIRE(ecs.GetComponent<babs_ecs::Relationship>(b)->depth == 2);
+
+		// and a dummy parent turns it back into a root
+		ecs.SetParent(b, babs_ecs::Entity());
+		REQUIRE(ecs.GetParent(b).UUID == 0);
+		REQUIRE(ecs.GetChildren(a).empty());
+		REQUIRE(ecs.GetComponent<babs_ecs::Relationship>(b)->depth == 0);
+	}
+
+	TEST_CASE("SetParent refuses to create cycles")
+	{
+		babs_ecs::ECSManager ecs;
+
+		babs_ecs::Entity root = ecs.CreateEntity();
+		babs_ecs::Entity child = ecs.CreateEntity();
+		babs_ecs::Entity grandchild = ecs.CreateEntity();
+
+		ecs.SetParent(child, root);
+		ecs.SetParent(grandchild, child);
+
+		CHECK_THROWS_AS(ecs.SetParent(root, grandchild), const std::invalid_argument&);
+		CHECK_THROWS_AS(ecs.SetParent(root, root), const std::invalid_argument&);
+		CHECK_THROWS_AS(ecs.SetParent(root, babs_ecs::Entity(99)), const babs_ecs::EntityNotFoundException&);
+	}
+
+	TEST_CASE("EachInHierarchy visits parents before children")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Transform>();
+
+		// build the tree bottom up so insertion order is the worst case
+		std::vector<babs_ecs::Entity> chain;
+		for (int i = 0; i < 6; ++i)
+		{
+			babs_ecs::Entity e = ecs.CreateEntity();
+			ecs.AddComponent(e, Transform{ 1, 0 });
+			chain.push_back(e);
+		}
+		for (size_t i = 0; i + 1 < chain.size(); ++i)
+		{
+			ecs.SetParent(chain[i], chain[i + 1]);
+		}
+
+		babs_ecs::Entity leaf = ecs.CreateEntity();
+		ecs.AddComponent(leaf, Transform{ 10, 0 });
+		ecs.SetParent(leaf, chain[3]);
+
+		std::map<uint32_t, bool> visited;
+		ecs.EachInHierarchy([&](babs_ecs::Entity e, babs_ecs::Entity parent) {
+			if (parent.UUID != 0)
+			{
+				REQUIRE(visited[parent.UUID]);
+			}
+			visited[e.UUID] = true;
+
+			Transform* transform = ecs.GetComponent<Transform>(e);
+			transform->world = transform->local + (parent.UUID != 0 ? ecs.GetComponent<Transform>(parent)->world : 0);
+		});
+
+		REQUIRE(visited.size() == 7);
+		REQUIRE(ecs.GetComponent<Transform>(chain[0])->world == 6);
+		REQUIRE(ecs.GetComponent<Transform>(leaf)->world == 13);
+	}
+
+	TEST_CASE("RemoveEntity removes the whole subtree")
+	{
+		babs_ecs::ECSManager ecs;
+
+		babs_ecs::Entity root = ecs.CreateEntity();
+		babs_ecs::Entity branch = ecs.CreateEntity();
+		babs_ecs::Entity leaf1 = ecs.CreateEntity();
+		babs_ecs::Entity leaf2 = ecs.CreateEntity();
+		babs_ecs::Entity sibling = ecs.CreateEntity();
+
+		ecs.SetParent(branch, root);
+		ecs.SetParent(sibling, root);
+		ecs.SetParent(leaf1, branch);
+		ecs.SetParent(leaf2, branch);
+
+		int removed = 0;
+		ecs.events.Subscribe<babs_ecs::EntityRemoved>([&](const babs_ecs::EntityRemoved&) { removed++; });
+
+		ecs.RemoveEntity(branch);
+
+		REQUIRE(removed == 3);
+		REQUIRE(ecs.EntitiesWith().size() == 2);
+		REQUIRE(ecs.EntitiesWith<babs_ecs::Relationship>().size() == 2);
+
+		auto children = ecs.GetChildren(root);
+		REQUIRE(children.size() == 1);
+		REQUIRE(children[0] == sibling);
+
+		int visited = 0;
+		ecs.EachInHierarchy([&](babs_ecs::Entity, babs_ecs::Entity) { visited++; });
+		REQUIRE(visited == 2);
+	}
+
+	TEST_CASE("Removing Relationship from a middle child unlinks it and makes its children roots")
+	{
+		babs_ecs::ECSManager ecs;
+
+		babs_ecs::Entity root = ecs.CreateEntity();
+		babs_ecs::Entity first = ecs.CreateEntity();
+		babs_ecs::Entity middle = ecs.CreateEntity();
+		babs_ecs::Entity last = ecs.CreateEntity();
+		babs_ecs::Entity grandchild = ecs.CreateEntity();
+		babs_ecs::Entity greatGrandchild = ecs.CreateEntity();
+
+		ecs.SetParent(first, root);
+		ecs.SetParent(middle, root);
+		ecs.SetParent(last, root);
+		ecs.SetParent(grandchild, middle);
+		ecs.SetParent(greatGrandchild, grandchild);
+
+		REQUIRE(ecs.RemoveComponent<babs_ecs::Relationship>(middle) == babs_ecs::Status::Ok);
+
+		// the siblings on either side are linked to each other now
+		auto children = ecs.GetChildren(root);
+		REQUIRE(children.size() == 2);
+		REQUIRE(children[0] == last);
+		REQUIRE(children[1] == first);
+		REQUIRE(ecs.GetParent(middle).UUID == 0);
+
+		// the removed entity's child is a root, and keeps its own subtree
+		REQUIRE(ecs.GetParent(grandchild).UUID == 0);
+		REQUIRE(ecs.GetChildren(grandchild).size() == 1);
+
+		std::map<uint32_t, uint32_t> parents;
+		std::vector<uint32_t> order;
+		ecs.EachInHierarchy([&](babs_ecs::Entity e, babs_ecs::Entity parent) {
+			parents[e.UUID] = parent.UUID;
+			order.push_back(e.UUID);
+		});
+		REQUIRE(order.size() == 5);
+		REQUIRE(parents[grandchild.UUID] == 0);
+		REQUIRE(parents[greatGrandchild.UUID] == grandchild.UUID);
+		REQUIRE(std::find(order.begin(), order.end(), grandchild.UUID) < std::find(order.begin(), order.end(), greatGrandchild.UUID));
+
+		// removing the rest of the hierarchy walks it safely
+		ecs.RemoveEntity(root);
+		REQUIRE(ecs.IsAlive(middle));
+		REQUIRE(ecs.IsAlive(grandchild));
+		REQUIRE(ecs.EntitiesWith().size() == 3);
+	}
+
+	TEST_CASE("Entities outside the hierarchy are unaffected")
+	{
+		babs_ecs::ECSManager ecs;
+
+		babs_ecs::Entity loner = ecs.CreateEntity();
+		REQUIRE(ecs.GetParent(loner).UUID == 0);
+		REQUIRE(ecs.GetChildren(loner).empty());
+
+		ecs.EachInHierarchy([&](babs_ecs::Entity, babs_ecs::Entity) { REQUIRE(false); });
+		CHECK_NOTHROW(ecs.RemoveEntity(loner));
+	}
+}
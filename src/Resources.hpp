@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "TypeId.hpp"
+
+namespace babs_ecs
+{
+	// ResourceFamily is the TypeIds family used for resource ids.
+	struct ResourceFamily {};
+
+	// BaseResource lets the manager own resources of any type.
+	class BaseResource
+	{
+	public:
+		BaseResource() {};
+		virtual ~BaseResource() {};
+
+		// Clone returns a copy of the resource, or nullptr if it can't be copied.
+		virtual std::unique_ptr<BaseResource> Clone() const = 0;
+
+		// Value points at the held resource.
+		virtual void* Value() = 0;
+	};
+
+	template <typename T>
+	class ResourceHolder : public BaseResource
+	{
+	public:
+		ResourceHolder(T value) : value(std::move(value)) {};
+		virtual ~ResourceHolder() {};
+
+		std::unique_ptr<BaseResource> Clone() const override
+		{
+			if constexpr (std::is_copy_constructible_v<T>)
+			{
+				return std::make_unique<ResourceHolder>(this->value);
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+		void* Value() override
+		{
+			return &this->value;
+		}
+
+		T value;
+	};
+
+	// Read and Write are tags for declaring how a system uses a resource, see ResourceAccess.
+	template <typename T>
+	struct Read {};
+
+	template <typename T>
+	struct Write {};
+
+	// ResourceAccess is a declaration of the resources a system reads and writes. A scheduler can
+	// run two systems in parallel when neither writes a resource the other one uses.
+	//
+	// Typical usage:
+	//   auto physics = babs_ecs::ResourceAccess::Of<babs_ecs::Read<Time>, babs_ecs::Write<PhysicsSettings>>();
+	//   auto render = babs_ecs::ResourceAccess::Of<babs_ecs::Read<Time>>();
+	//   physics.ConflictsWith(render); // false, both only read Time
+	struct ResourceAccess
+	{
+		std::vector<size_t> reads;
+		std::vector<size_t> writes;
+
+		template <typename... Accesses>
+		static ResourceAccess Of()
+		{
+			ResourceAccess access;
+			(access.Add(static_cast<Accesses*>(nullptr)), ...);
+			return access;
+		}
+
+		template <typename T>
+		bool Reads() const
+		{
+			return Find(this->reads, TypeIds<ResourceFamily>::Of<T>());
+		}
+
+		template <typename T>
+		bool Writes() const
+		{
+			return Find(this->writes, TypeIds<ResourceFamily>::Of<T>());
+		}
+
+		// ConflictsWith is true when one side writes a resource the other side reads or writes.
+		bool ConflictsWith(const ResourceAccess& other) const
+		{
+			for (size_t id : this->writes)
+			{
+				if (Find(other.reads, id) || Find(other.writes, id))
+				{
+					return true;
+				}
+			}
+
+			for (size_t id : other.writes)
+			{
+				if (Find(this->reads, id))
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+	private:
+		template <typename T>
+		void Add(Read<T>*)
+		{
+			this->reads.push_back(TypeIds<ResourceFamily>::Of<T>());
+		}
+
+		template <typename T>
+		void Add(Write<T>*)
+		{
+			this->writes.push_back(TypeIds<ResourceFamily>::Of<T>());
+		}
+
+		static bool Find(const std::vector<size_t>& ids, size_t id)
+		{
+			return std::find(ids.begin(), ids.end(), id) != ids.end();
+		}
+	};
+}
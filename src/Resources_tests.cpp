@@ -0,0 +1,99 @@
+#include "doctest.h"
+
+#include <string>
+
+#include "ECSManager.hpp"
+#include "Exceptions.hpp"
+#include "Resources.hpp"
+
+namespace
+{
+	struct Time
+	{
+		float delta;
+	};
+
+	struct PhysicsSettings
+	{
+		float gravity;
+	};
+
+	struct NavMesh
+	{
+		std::string name;
+	};
+}
+
+TEST_SUITE("Resources")
+{
+	TEST_CASE("SetResource stores a value that Resource can read and write")
+	{
+		babs_ecs::ECSManager ecs;
+
+		ecs.SetResource(Time{ 0.016f });
+		REQUIRE(ecs.HasResource<Time>());
+		REQUIRE(ecs.Resource<Time>().delta == 0.016f);
+
+		ecs.Resource<Time>().delta = 0.033f;
+		REQUIRE(ecs.Resource<Time>().delta == 0.033f);
+
+		// setting it again replaces it
+		ecs.SetResource(Time{ 1.0f });
+		REQUIRE(ecs.Resource<Time>().delta == 1.0f);
+	}
+
+	TEST_CASE("Resources don't show up as entities")
+	{
+		babs_ecs::ECSManager ecs;
+
+		ecs.SetResource(NavMesh{ "level1" });
+		ecs.SetResource(PhysicsSettings{ -9.8f });
+
+		REQUIRE(ecs.EntitiesWith().size() == 0);
+		REQUIRE(ecs.Resource<NavMesh>().name == "level1");
+	}
+
+	TEST_CASE("Missing resources throw")
+	{
+		babs_ecs::ECSManager ecs;
+
+		REQUIRE(ecs.HasResource<PhysicsSettings>() == false);
+		CHECK_THROWS_AS(ecs.Resource<PhysicsSettings>(), const babs_ecs::ResourceNotFoundException&);
+
+		ecs.SetResource(PhysicsSettings{ -9.8f });
+		ecs.RemoveResource<PhysicsSettings>();
+
+		REQUIRE(ecs.HasResource<PhysicsSettings>() == false);
+		CHECK_THROWS_AS(ecs.Resource<PhysicsSettings>(), const babs_ecs::ResourceNotFoundException&);
+	}
+
+	TEST_CASE("Managers have their own resources")
+	{
+		babs_ecs::ECSManager first;
+		babs_ecs::ECSManager second;
+
+		first.SetResource(Time{ 1.0f });
+		second.SetResource(Time{ 2.0f });
+
+		REQUIRE(first.Resource<Time>().delta == 1.0f);
+		REQUIRE(second.Resource<Time>().delta == 2.0f);
+	}
+
+	TEST_CASE("ResourceAccess detects conflicting systems")
+	{
+		auto physics = babs_ecs::ResourceAccess::Of<babs_ecs::Read<Time>, babs_ecs::Write<PhysicsSettings>>();
+		auto render = babs_ecs::ResourceAccess::Of<babs_ecs::Read<Time>>();
+		auto tuning = babs_ecs::ResourceAccess::Of<babs_ecs::Read<PhysicsSettings>>();
+		auto clock = babs_ecs::ResourceAccess::Of<babs_ecs::Write<Time>>();
+
+		REQUIRE(physics.Reads<Time>());
+		REQUIRE(physics.Writes<PhysicsSettings>());
+		REQUIRE(physics.Writes<Time>() == false);
+
+		REQUIRE(physics.ConflictsWith(render) == false);
+		REQUIRE(physics.ConflictsWith(tuning));
+		REQUIRE(tuning.ConflictsWith(physics));
+		REQUIRE(clock.ConflictsWith(render));
+		REQUIRE(clock.ConflictsWith(tuning) == false);
+	}
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace babs_ecs
+{
+	// PageRefCount counts the owners of a page shared between copies of a paged table
+	// (SparseTable, PresenceBitmap, EntityTable and the paged component pools). A forked world
+	// shares every page with the world it came from until one of them writes to a page, and only
+	// that page is copied.
+	//
+	// Copying a page starts the copy with a single reference. The count is atomic because the
+	// worlds sharing a page can live on different threads. A page is only written in place by an
+	// owner holding the only reference, so it can't change under another owner that's copying it.
+	class PageRefCount
+	{
+	public:
+		PageRefCount() {}
+		PageRefCount(const PageRefCount&) {}
+		PageRefCount& operator=(const PageRefCount&)
+		{
+			return *this;
+		}
+
+		void Acquire()
+		{
+			this->count.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// Release drops one reference and returns true if it was the last, meaning the page can be
+		// freed.
+		bool Release()
+		{
+			return this->count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+		}
+
+		bool Shared() const
+		{
+			return this->count.load(std::memory_order_acquire) > 1;
+		}
+
+	private:
+		std::atomic<uint32_t> count{ 1 };
+	};
+
+	// OwnPage makes page private to the caller before it's written: a shared page is swapped for a
+	// copy and the caller's reference to the original is dropped. Page must have a PageRefCount
+	// member called refs.
+	template <typename Page>
+	Page* OwnPage(Page*& page)
+	{
+		if (page->refs.Shared())
+		{
+			Page* copy = new Page(*page);
+			if (page->refs.Release())
+			{
+				// every other owner let go while this one was copying
+				delete page;
+			}
+			page = copy;
+		}
+
+		return page;
+	}
+
+	// ReleasePage drops the caller's reference to page and frees it if that was the last one.
+	template <typename Page>
+	void ReleasePage(Page* page)
+	{
+		if (page != nullptr && page->refs.Release())
+		{
+			delete page;
+		}
+	}
+
+	// PageDirectory is the list of pages of a paged table that's copied often enough for the
+	// list itself to matter, like the entity table and presence bitmaps that every Fork copies.
+	// Copying the directory shares the list, so copying a table costs the same whatever its size. The first change to a shared
+	// list gives the changing table a list of its own, taking a reference to every page in it,
+	// and the pages themselves are only copied once they're written (see OwnPage).
+	//
+	// Page must have a PageRefCount member called refs and a static Empty() returning the page
+	// that unallocated entries point to, or nullptr if the table doesn't use one. The Empty page
+	// is never counted or freed.
+	template <typename Page>
+	class PageDirectory
+	{
+	public:
+		PageDirectory() {}
+
+		PageDirectory(const PageDirectory& other) : list(other.list)
+		{
+			if (this->list != nullptr)
+			{
+				this->list->refs.Acquire();
+			}
+		}
+
+		PageDirectory(PageDirectory&& other) noexcept : list(other.list)
+		{
+			other.list = nullptr;
+		}
+
+		PageDirectory& operator=(PageDirectory other) noexcept
+		{
+			std::swap(this->list, other.list);
+			return *this;
+		}
+
+		~PageDirectory()
+		{
+			ReleasePage(this->list);
+		}
+
+		size_t Size() const
+		{
+			return this->list != nullptr ? this->list->pages.size() : 0;
+		}
+
+		// operator[] returns page index for reading, index must be below Size().
+		Page* operator[](size_t index) const
+		{
+			return this->list->pages[index];
+		}
+
+		// Pages returns every page for reading.
+		const std::vector<Page*>& Pages() const
+		{
+			static const std::vector<Page*> none;
+			return this->list != nullptr ? this->list->pages : none;
+		}
+
+		// Edit returns the list of pages for adding, removing or swapping pages, after making it
+		// this table's own. The pages in it may still be shared.
+		std::vector<Page*>& Edit()
+		{
+			if (this->list == nullptr)
+			{
+				this->list = new List;
+			}
+
+			return OwnPage(this->list)->pages;
+		}
+
+		// Writable returns page index ready to be written: the list and then the page are made
+		// this table's own. index must be below Size() and the page must not be the Empty page.
+		Page* Writable(size_t index)
+		{
+			return OwnPage(this->Edit()[index]);
+		}
+
+	private:
+		struct List
+		{
+			std::vector<Page*> pages;
+			PageRefCount refs;
+
+			List() {}
+
+			List(const List& other) : pages(other.pages)
+			{
+				for (Page* page : this->pages)
+				{
+					if (page != Page::Empty())
+					{
+						page->refs.Acquire();
+					}
+				}
+			}
+
+			List& operator=(const List&) = delete;
+
+			~List()
+			{
+				for (Page* page : this->pages)
+				{
+					if (page != Page::Empty())
+					{
+						ReleasePage(page);
+					}
+				}
+			}
+		};
+
+		List* list = nullptr;
+	};
+}
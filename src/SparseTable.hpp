@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "SharedPages.hpp"
+
+namespace babs_ecs
+{
+	// SparseTable maps entity UUIDs to slots in a packed component pool. The table is split into
+	// pages of PageSize entries that are only allocated once one of their UUIDs is set, and freed
+	// again when their last entry is erased, so a pool's memory follows the UUIDs it actually
+	// holds instead of the highest UUID ever issued.
+	//
+	// Pages that aren't allocated point at one shared page of Invalid entries, so a lookup is
+	// always two dependent loads (directory entry, then slot) with a single bounds check.
+	//
+	// The most recently emptied page is kept as a spare rather than freed, so entities that come
+	// and go around one page boundary don't allocate on every add.
+	//
+	// Copies share their pages until one side writes to them, see PageRefCount.
+	class SparseTable
+	{
+	public:
+		static constexpr uint32_t Invalid = std::numeric_limits<uint32_t>::max();
+		static constexpr uint32_t PageBits = 10;
+		static constexpr uint32_t PageSize = uint32_t(1) << PageBits;
+
+		SparseTable() {}
+
+		SparseTable(const SparseTable& other) : pages(other.pages)
+		{
+			for (Page* page : this->pages)
+			{
+				if (page != Empty())
+				{
+					page->refs.Acquire();
+				}
+			}
+		}
+
+		SparseTable(SparseTable&& other) noexcept : pages(std::move(other.pages)), spare(other.spare)
+		{
+			other.pages.clear();
+			other.spare = nullptr;
+		}
+
+		SparseTable& operator=(SparseTable other) noexcept
+		{
+			std::swap(this->pages, other.pages);
+			std::swap(this->spare, other.spare);
+			return *this;
+		}
+
+		~SparseTable()
+		{
+			for (Page* page : this->pages)
+			{
+				if (page != Empty())
+				{
+					ReleasePage(page);
+				}
+			}
+
+			delete this->spare;
+		}
+
+		// operator[] returns the slot stored for uuid, or Invalid if there is none.
+		uint32_t operator[](uint32_t uuid) const
+		{
+			size_t page = uuid >> PageBits;
+			return page < this->pages.size() ? this->pages[page]->slots[uuid & (PageSize - 1)] : Invalid;
+		}
+
+		bool Contains(uint32_t uuid) const
+		{
+			return (*this)[uuid] != Invalid;
+		}
+
+		// Set stores the slot for uuid, allocating its page if needed. slot must not be Invalid,
+		// use Erase to clear an entry.
+		void Set(uint32_t uuid, uint32_t slot)
+		{
+			size_t page = uuid >> PageBits;
+
+			if (page >= this->pages.size())
+			{
+				this->pages.resize(page + 1, Empty());
+			}
+
+			Page* target = this->Writable(this->pages[page]);
+			uint32_t& entry = target->slots[uuid & (PageSize - 1)];
+			target->live += entry == Invalid ? 1 : 0;
+			entry = slot;
+		}
+
+		// SetMany stores slots firstSlot, firstSlot + 1, ... for the count UUIDs in uuids, growing
+		// the directory once for the whole batch. None of the UUIDs may be set already.
+		void SetMany(const uint32_t* uuids, size_t count, uint32_t firstSlot)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+
+			size_t highest = *std::max_element(uuids, uuids + count) >> PageBits;
+			if (highest >= this->pages.size())
+			{
+				this->pages.resize(highest + 1, Empty());
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				Page* page = this->Writable(this->pages[uuids[i] >> PageBits]);
+				page->slots[uuids[i] & (PageSize - 1)] = firstSlot + static_cast<uint32_t>(i);
+				++page->live;
+			}
+		}
+
+		// Erase clears the entry for uuid, freeing its page if it was the last entry in it.
+		void Erase(uint32_t uuid)
+		{
+			size_t page = uuid >> PageBits;
+			if (page >= this->pages.size())
+			{
+				return;
+			}
+
+			if (this->pages[page]->slots[uuid & (PageSize - 1)] == Invalid)
+			{
+				return;
+			}
+
+			Page* target = OwnPage(this->pages[page]);
+			target->slots[uuid & (PageSize - 1)] = Invalid;
+			if (--target->live == 0)
+			{
+				delete this->spare;
+				this->spare = this->pages[page];
+				this->pages[page] = Empty();
+
+				// drop unallocated pages off the end so the directory shrinks with the table
+				while (!this->pages.empty() && this->pages.back() == Empty())
+				{
+					this->pages.pop_back();
+				}
+			}
+		}
+
+		// PageCount returns the number of pages currently in use, not counting the spare.
+		size_t PageCount() const
+		{
+			return static_cast<size_t>(std::count_if(this->pages.begin(), this->pages.end(), [](const Page* page) {
+				return page != Empty();
+			}));
+		}
+
+	private:
+		struct Page
+		{
+			uint32_t slots[PageSize];
+			uint32_t live;
+			PageRefCount refs;
+		};
+
+		std::vector<Page*> pages;
+		Page* spare = nullptr;
+
+		// Writable returns page ready to be written, allocating it if it's the Empty page and
+		// copying it if it's shared with another table.
+		Page* Writable(Page*& page)
+		{
+			if (page == Empty())
+			{
+				// an emptied page only holds Invalid entries, so the spare can be used as is
+				page = this->spare != nullptr ? this->spare : new Page(*Empty());
+				this->spare = nullptr;
+				return page;
+			}
+
+			return OwnPage(page);
+		}
+
+		// Empty is the shared page every unallocated directory entry points to. It is never written.
+		static Page* Empty()
+		{
+			static Page empty = [] {
+				Page page;
+				std::fill(std::begin(page.slots), std::end(page.slots), Invalid);
+				page.live = 0;
+				return page;
+			}();
+
+			return &empty;
+		}
+	};
+}
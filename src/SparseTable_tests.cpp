@@ -0,0 +1,94 @@
+#include "doctest.h"
+
+#include <cstdint>
+
+#include "ComponentContainer.hpp"
+#include "SparseTable.hpp"
+
+TEST_SUITE("Sparse Table")
+{
+	TEST_CASE("Pages are allocated on demand and freed when they empty")
+	{
+		babs_ecs::SparseTable table;
+		REQUIRE(table[12345] == babs_ecs::SparseTable::Invalid);
+		REQUIRE(table.PageCount() == 0);
+
+		table.Set(3, 0);
+		table.Set(5, 1);
+		table.Set(2'000'000, 2);
+		REQUIRE(table.PageCount() == 2);
+		REQUIRE(table[5] == 1);
+		REQUIRE(table[2'000'000] == 2);
+		REQUIRE_FALSE(table.Contains(4));
+
+		// overwriting an entry doesn't count it twice
+		table.Set(3, 7);
+		table.Erase(5);
+		REQUIRE(table.PageCount() == 2);
+		table.Erase(3);
+		REQUIRE(table.PageCount() == 1);
+		REQUIRE(table[3] == babs_ecs::SparseTable::Invalid);
+
+		table.Erase(2'000'000);
+		table.Erase(2'000'000);
+		REQUIRE(table.PageCount() == 0);
+		REQUIRE(table[2'000'000] == babs_ecs::SparseTable::Invalid);
+	}
+
+	TEST_CASE("Copies own their pages")
+	{
+		babs_ecs::SparseTable table;
+		table.Set(10, 1);
+
+		babs_ecs::SparseTable copy = table;
+		copy.Set(10, 2);
+		copy.Set(5000, 3);
+
+		REQUIRE(table[10] == 1);
+		REQUIRE(table[5000] == babs_ecs::SparseTable::Invalid);
+		REQUIRE(copy[10] == 2);
+	}
+
+	TEST_CASE("A copy and its original can each write the pages they share")
+	{
+		babs_ecs::SparseTable table;
+		table.Set(10, 1);
+		table.Set(5000, 2);
+
+		babs_ecs::SparseTable copy = table;
+		table.Erase(10);
+		table.Set(5001, 3);
+		REQUIRE(table.PageCount() == 1);
+
+		REQUIRE(copy[10] == 1);
+		REQUIRE(copy[5000] == 2);
+		REQUIRE_FALSE(copy.Contains(5001));
+		REQUIRE(copy.PageCount() == 2);
+
+		copy.Erase(5000);
+		REQUIRE(table[5000] == 2);
+	}
+
+	TEST_CASE("A rare component only keeps the pages its entities use")
+	{
+		struct Boss
+		{
+			int phase;
+		};
+
+		babs_ecs::ComponentContainer<Boss> bosses;
+		for (uint32_t uuid = 200'000; uuid < 2'000'000; uuid += 200'000)
+		{
+			bosses.Insert(babs_ecs::Entity(uuid), Boss{ 1 });
+		}
+
+		REQUIRE(bosses.sparse.PageCount() == 9);
+		REQUIRE(bosses.Get(1'000'000)->phase == 1);
+
+		for (uint32_t uuid = 200'000; uuid < 2'000'000; uuid += 200'000)
+		{
+			bosses.Remove(uuid);
+		}
+		REQUIRE(bosses.sparse.PageCount() == 0);
+	}
+}
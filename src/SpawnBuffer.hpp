@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "ComponentContainer.hpp"
+#include "ECSManager.hpp"
+#include "Entity.hpp"
+#include "Exceptions.hpp"
+#include "TypeId.hpp"
+
+namespace babs_ecs
+{
+	// BaseStagedColumn lets a SpawnBuffer hold components of any type.
+	class BaseStagedColumn
+	{
+	public:
+		virtual ~BaseStagedColumn() {};
+
+		virtual Status CommitTo(ECSManager& ecs) = 0;
+	};
+
+	template <typename T>
+	class StagedColumn : public BaseStagedColumn
+	{
+	public:
+		std::vector<Entity> entities;
+		std::vector<T> data;
+
+		// CommitTo adds every staged component and returns the first error, if any. Without
+		// exceptions the components after a failed one are still added.
+		Status CommitTo(ECSManager& ecs) override
+		{
+			Status status = Status::Ok;
+			for (size_t i = 0; i < this->entities.size(); ++i)
+			{
+				Status added = ecs.AddComponent(this->entities[i], std::move(this->data[i]));
+				if (status == Status::Ok)
+				{
+					status = added;
+				}
+			}
+
+			this->entities.clear();
+			this->data.clear();
+			return status;
+		}
+	};
+
+	// SpawnBuffer lets a worker thread create entities without going through the main thread. Each
+	// thread uses its own buffer: Create reserves ids lock-free (see ECSManager::ReserveEntity),
+	// and Add stages components in the buffer. Commit publishes everything at a sync point.
+	//
+	// Any number of buffers can be filled in parallel, as long as nothing makes a structural change
+	// to the manager (creating or removing entities, adding or removing components) at the same time.
+	//
+	// Typical usage:
+	//   // on each worker
+	//   babs_ecs::SpawnBuffer& spawner = spawners[thread];
+	//   babs_ecs::Entity bullet = spawner.Create();
+	//   spawner.Add(bullet, Position{ x, y });
+	//   // on the main thread, after the workers are done
+	//   for (auto& spawner : spawners) spawner.Commit();
+	class SpawnBuffer
+	{
+	public:
+		SpawnBuffer(ECSManager& ecs) : ecs(&ecs) {}
+
+		SpawnBuffer(const SpawnBuffer&) = delete;
+		SpawnBuffer& operator=(const SpawnBuffer&) = delete;
+		SpawnBuffer(SpawnBuffer&&) = default;
+		SpawnBuffer& operator=(SpawnBuffer&&) = default;
+
+		// Create reserves a new entity. It exists once the buffer is committed.
+		Entity Create()
+		{
+			this->created++;
+			return this->ecs->ReserveEntity();
+		}
+
+		// Add stages a component for the entity, which is added when the buffer is committed. The
+		// entity can be one from Create or one that already exists.
+		template <typename T>
+		void Add(Entity entity, T component)
+		{
+			StagedColumn<T>& column = this->Column<T>();
+			column.entities.push_back(entity);
+			column.data.push_back(std::move(component));
+		}
+
+		// Created returns how many entities have been created since the last Commit.
+		size_t Created() const
+		{
+			return this->created;
+		}
+
+		// Commit makes the reserved entities alive and adds the staged components, from the main
+		// thread. Components are added one type at a time, each in the order they were staged. The
+		// buffer keeps its capacity, so filling it again doesn't allocate.
+		//
+		// Adding a component fails like AddComponent does, for a component that isn't registered or
+		// an entity removed since it was staged. Commit throws the first such error, or, with
+		// BABS_ECS_NO_EXCEPTIONS, commits everything else and returns it.
+		Status Commit()
+		{
+			this->ecs->PublishReserved(true);
+
+			Status status = Status::Ok;
+			for (auto& column : this->columns)
+			{
+				if (column != nullptr)
+				{
+					Status committed = column->CommitTo(*this->ecs);
+					if (status == Status::Ok)
+					{
+						status = committed;
+					}
+				}
+			}
+
+			this->created = 0;
+			return status;
+		}
+
+	private:
+		ECSManager* ecs;
+		size_t created = 0;
+
+		// columns are indexed by TypeIds<ComponentFamily>, like the manager's containers
+		std::vector<std::unique_ptr<BaseStagedColumn>> columns;
+
+		template <typename T>
+		StagedColumn<T>& Column()
+		{
+			size_t componentId = TypeIds<ComponentFamily>::Of<T>();
+
+			if (componentId >= this->columns.size())
+			{
+				this->columns.resize(componentId + 1);
+			}
+
+			if (this->columns[componentId] == nullptr)
+			{
+				this->columns[componentId] = std::make_unique<StagedColumn<T>>();
+			}
+
+			return *static_cast<StagedColumn<T>*>(this->columns[componentId].get());
+		}
+	};
+}
@@ -0,0 +1,139 @@
+#include "doctest.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "ECSManager.hpp"
+#include "SpawnBuffer.hpp"
+
+namespace
+{
+	struct Bullet
+	{
+		float speed;
+	};
+
+	struct Owner
+	{
+		int thread;
+	};
+}
+
+TEST_SUITE("Spawn buffers")
+{
+	TEST_CASE("Entities reserved on worker threads exist once their buffers are committed")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Bullet>();
+		ecs.RegisterComponent<Owner>();
+
+		// leave some ids on the free list so workers recycle them as well
+		std::vector<babs_ecs::Entity> old;
+		for (int i = 0; i < 100; ++i)
+		{
+			old.push_back(ecs.CreateEntity());
+		}
+		for (babs_ecs::Entity e : old)
+		{
+			ecs.RemoveEntity(e);
+		}
+
+		int created = 0;
+		ecs.events.Subscribe<babs_ecs::EntityCreated>([&created](const babs_ecs::EntityCreated&) { created++; });
+
+		const int threads = 4;
+		const int perThread = 1000;
+
+		std::vector<babs_ecs::SpawnBuffer> spawners;
+		std::vector<std::vector<babs_ecs::Entity>> spawned(threads);
+		for (int t = 0; t < threads; ++t)
+		{
+			spawners.emplace_back(ecs);
+		}
+
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; ++t)
+		{
+			workers.emplace_back([&, t]() {
+				for (int i = 0; i < perThread; ++i)
+				{
+					babs_ecs::Entity bullet = spawners[t].Create();
+					spawners[t].Add(bullet, Bullet{ static_cast<float>(i) });
+					spawners[t].Add(bullet, Owner{ t });
+					spawned[t].push_back(bullet);
+				}
+			});
+		}
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+
+		REQUIRE(ecs.EntitiesWith().empty());
+		REQUIRE(spawners[0].Created() == perThread);
+
+		for (babs_ecs::SpawnBuffer& spawner : spawners)
+		{
+			spawner.Commit();
+		}
+
+		REQUIRE(created == threads * perThread);
+		REQUIRE(ecs.EntitiesWith<Bullet, Owner>().size() == threads * perThread);
+		REQUIRE(spawners[0].Created() == 0);
+
+		// every handle is unique, and the freed ids were used before fresh ones
+		std::vector<uint32_t> ids;
+		for (int t = 0; t < threads; ++t)
+		{
+			for (babs_ecs::Entity e : spawned[t])
+			{
+				ids.push_back(e.UUID);
+				REQUIRE(ecs.GetComponent<Owner>(e)->thread == t);
+			}
+		}
+		std::sort(ids.begin(), ids.end());
+		REQUIRE(std::adjacent_find(ids.begin(), ids.end()) == ids.end());
+		REQUIRE(ids.front() == 1);
+		REQUIRE(ids.back() == threads * perThread);
+	}
+
+	TEST_CASE("Reserved entities are created by the next structural change")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Bullet>();
+
+		babs_ecs::Entity kept = ecs.CreateEntity();
+		babs_ecs::Entity removed = ecs.CreateEntity();
+		ecs.RemoveEntity(removed);
+
+		babs_ecs::SpawnBuffer spawner(ecs);
+		babs_ecs::Entity recycled = spawner.Create();
+		babs_ecs::Entity fresh = spawner.Create();
+		spawner.Add(fresh, Bullet{ 2.0f });
+		REQUIRE(recycled.UUID == removed.UUID);
+		REQUIRE_FALSE(ecs.IsAlive(recycled));
+
+		// creating an entity on the main thread publishes the reservations first
+		babs_ecs::Entity created = ecs.CreateEntity();
+		REQUIRE(ecs.IsAlive(recycled));
+		REQUIRE(ecs.IsAlive(fresh));
+		REQUIRE(created.UUID != recycled.UUID);
+		REQUIRE(created.UUID != fresh.UUID);
+		REQUIRE_FALSE(ecs.HasComponent<Bullet>(fresh));
+
+		REQUIRE(spawner.Commit() == babs_ecs::Status::Ok);
+		REQUIRE(ecs.GetComponent<Bullet>(fresh)->speed == 2.0f);
+
+		// staging components for an existing entity works too
+		spawner.Add(kept, Bullet{ 1.0f });
+		spawner.Commit();
+		REQUIRE(ecs.GetComponent<Bullet>(kept)->speed == 1.0f);
+
+		// an entity removed after its component was staged makes the commit fail
+		spawner.Add(created, Bullet{ 3.0f });
+		ecs.RemoveEntity(created);
+		CHECK_THROWS_AS(spawner.Commit(), const std::runtime_error&);
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace babs_ecs
+{
+	// TypeIds hands out small, dense ids for types, starting at 0 and counting up in the order types
+	// are first asked for. Each Family gets its own sequence, so ids for one kind of thing (like
+	// resources) can index straight into a vector without gaps left by unrelated types.
+	//
+	// Ids are stable for the lifetime of the program, but not across runs.
+	template <typename Family>
+	class TypeIds
+	{
+	public:
+		template <typename T>
+		static size_t Of()
+		{
+			static const size_t id = Next();
+			return id;
+		}
+
+	private:
+		static size_t Next()
+		{
+			static std::atomic<size_t> next{ 0 };
+			return next++;
+		}
+	};
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "bitfield/bitfield.hpp"
+#include "ComponentContainer.hpp"
+#include "Entity.hpp"
+#include "Exceptions.hpp"
+
+namespace babs_ecs
+{
+	// World is the static counterpart of ECSManager for builds where every component type is known
+	// at compile time. Containers live in a std::tuple and component indices and signature bits are
+	// constexpr, so every access resolves to a direct array access with no string lookups, RTTI or
+	// virtual dispatch. This makes it usable with -fno-rtti.
+	//
+	// It mirrors the ECSManager entity/component API, but doesn't need RegisterComponent and doesn't
+	// broadcast events. Use ECSManager when component types need to be registered at runtime (mods).
+	//
+	// Typical usage:
+	//   babs_ecs::World<Position, Velocity> world;
+	//   auto e = world.CreateEntity();
+	//   world.AddComponent(e, Position{ 0, 0 });
+	//   world.Each<Position, Velocity>([](babs_ecs::Entity e, Position& p, Velocity& v) { ... });
+	template <typename... Components>
+	class World
+	{
+		static_assert(sizeof...(Components) > 0, "A World needs at least one component type");
+		static_assert(sizeof...(Components) <= sizeof(bitfield::Bitfield) * 8, "Exceeded available flags for the bitfield!");
+
+	public:
+		World()
+		{
+			this->entityIndex = 1;  // 0 is used for default/dummy entity
+			this->signatures.push_back(0);
+			this->alive.push_back(false);
+		}
+
+		// IndexOf is the position of T in the World's component list.
+		template <typename T>
+		static constexpr size_t IndexOf()
+		{
+			static_assert((std::is_same_v<T, Components> || ...), "T is not one of the World's components");
+			return Find<T, Components...>();
+		}
+
+		// SignatureOf is the bitfield with the flags of every component in Ts set.
+		template <typename... Ts>
+		static constexpr bitfield::Bitfield SignatureOf()
+		{
+			return ((bitfield::Bitfield(1) << IndexOf<Ts>()) | ... | 0);
+		}
+
+		// CreateEntity will initialize and return a new entity with no components.
+		Entity CreateEntity()
+		{
+			uint32_t entityId = 1;
+
+			if (!this->unusedEntityIndices.empty())
+			{
+				entityId = this->unusedEntityIndices.back();
+				this->unusedEntityIndices.pop_back();
+			}
+			else
+			{
+				entityId = this->entityIndex;
+				this->entityIndex++;
+				this->signatures.push_back(0);
+				this->alive.push_back(false);
+			}
+
+			this->signatures[entityId] = 0;
+			this->alive[entityId] = true;
+			return Entity(entityId);
+		}
+
+		bool IsAlive(Entity entity) const
+		{
+			return entity.UUID < this->alive.size() && this->alive[entity.UUID];
+		}
+
+		// RemoveEntity removes the entity and all of its component data.
+		Status RemoveEntity(Entity entity)
+		{
+			if (!this->IsAlive(entity))
+			{
+				BABS_ECS_ERROR(std::runtime_error("Failed to find entity to remove"), Status::EntityNotFound);
+			}
+
+			(this->Pool<Components>().Remove(entity.UUID), ...);
+
+			this->signatures[entity.UUID] = 0;
+			this->alive[entity.UUID] = false;
+			this->unusedEntityIndices.push_back(entity.UUID);
+			return Status::Ok;
+		}
+
+		// AddComponent will add the component to the entity, or overwrite it if it already has one.
+		template <typename T>
+		Status AddComponent(Entity entity, T component)
+		{
+			if (!this->IsAlive(entity))
+			{
+				BABS_ECS_ERROR(std::runtime_error("Failed to find entity to add component to"), Status::EntityNotFound);
+			}
+
+			this->Pool<T>().Insert(entity, std::move(component));
+			this->signatures[entity.UUID] = bitfield::Set(this->signatures[entity.UUID], SignatureOf<T>());
+			return Status::Ok;
+		}
+
+		// RemoveComponent removes the entity's T, if it has one.
+		template <typename T>
+		Status RemoveComponent(Entity entity)
+		{
+			if (!this->IsAlive(entity))
+			{
+				BABS_ECS_ERROR(std::runtime_error("Failed to find entity to remove component from"), Status::EntityNotFound);
+			}
+
+			if (!this->HasComponent<T>(entity))
+			{
+				// Nothing to remove
+				return Status::Ok;
+			}
+
+			this->Pool<T>().Remove(entity.UUID);
+			this->signatures[entity.UUID] = bitfield::Clear(this->signatures[entity.UUID], SignatureOf<T>());
+			return Status::Ok;
+		}
+
+		// GetComponent will return a pointer to the entities component data, or nullptr if it has none.
+		template <typename T>
+		T* GetComponent(Entity entity)
+		{
+			return this->Pool<T>().Get(entity.UUID);
+		}
+
+		template <typename T>
+		bool HasComponent(Entity entity) const
+		{
+			return this->IsAlive(entity) && bitfield::Has(this->signatures[entity.UUID], SignatureOf<T>());
+		}
+
+		// Signature returns the bitfield of the entity's components, see SignatureOf.
+		bitfield::Bitfield Signature(Entity entity) const
+		{
+			return this->IsAlive(entity) ? this->signatures[entity.UUID] : 0;
+		}
+
+		// Pool gives direct access to the packed container for T.
+		template <typename T>
+		ComponentContainer<T>& Pool()
+		{
+			return std::get<IndexOf<T>()>(this->containers);
+		}
+
+		// GetComponentArray returns the packed pool for T as aligned, padded arrays, see
+		// ECSManager::GetComponentArray. World always stores components as arrays of structs.
+		template <typename T>
+		ComponentArray<T> GetComponentArray()
+		{
+			return this->Pool<T>().Array();
+		}
+
+		// EntitiesWith returns the entities that have all of Ts, or every entity if Ts is empty.
+		template <typename... Ts>
+		std::vector<Entity> EntitiesWith()
+		{
+			std::vector<Entity> found;
+
+			if constexpr (sizeof...(Ts) == 0)
+			{
+				for (uint32_t uuid = 1; uuid < this->alive.size(); ++uuid)
+				{
+					if (this->alive[uuid])
+					{
+						Entity e(uuid);
+						e.bitfield = this->signatures[uuid];
+						found.push_back(e);
+					}
+				}
+			}
+			else
+			{
+				this->Each<Ts...>([&](Entity e, Ts&...) {
+					found.push_back(e);
+				});
+			}
+
+			return found;
+		}
+
+		// Each calls func(entity, components...) for every entity with all of Ts. It walks the
+		// smallest of the containers and checks the other components against the entity's signature.
+		template <typename... Ts, typename Func>
+		void Each(Func func)
+		{
+			static_assert(sizeof...(Ts) > 0, "Each needs at least one component type");
+			constexpr bitfield::Bitfield signature = SignatureOf<Ts...>();
+
+			const std::vector<Entity>* smallest = nullptr;
+			((smallest = (smallest == nullptr || this->Pool<Ts>().entities.size() < smallest->size()) ? &this->Pool<Ts>().entities : smallest), ...);
+
+			for (size_t i = 0; i < smallest->size(); ++i)
+			{
+				Entity e = (*smallest)[i];
+				e.bitfield = this->signatures[e.UUID];
+
+				if (bitfield::Has(e.bitfield, signature))
+				{
+					func(e, this->Pool<Ts>().data[this->Pool<Ts>().sparse[e.UUID]]...);
+				}
+			}
+		}
+
+	private:
+		std::tuple<ComponentContainer<Components>...> containers;
+
+		// signatures and alive are indexed by entity UUID
+		std::vector<bitfield::Bitfield> signatures;
+		std::vector<bool> alive;
+
+		std::vector<uint32_t> unusedEntityIndices;
+		uint32_t entityIndex;
+
+		template <typename T, typename First, typename... Rest>
+		static constexpr size_t Find()
+		{
+			if constexpr (std::is_same_v<T, First>)
+			{
+				return 0;
+			}
+			else
+			{
+				return 1 + Find<T, Rest...>();
+			}
+		}
+	};
+}
@@ -0,0 +1,117 @@
+#include "doctest.h"
+
+#include <stdexcept>
+
+#include "World.hpp"
+
+// This file is also built into tests-nortti with RTTI disabled, so it must not include
+// ECSManager.hpp or anything else that relies on typeid.
+namespace
+{
+	struct Position
+	{
+		float x;
+		float y;
+	};
+
+	struct Velocity
+	{
+		float dx;
+		float dy;
+	};
+
+	struct Dead {};
+
+	using TestWorld = babs_ecs::World<Position, Velocity, Dead>;
+}
+
+TEST_SUITE("Static World")
+{
+	TEST_CASE("Component indices and signatures are constexpr")
+	{
+		static_assert(TestWorld::IndexOf<Position>() == 0);
+		static_assert(TestWorld::IndexOf<Dead>() == 2);
+		static_assert(TestWorld::SignatureOf<Position, Dead>() == 0b101);
+		static_assert(TestWorld::SignatureOf<>() == 0);
+	}
+
+	TEST_CASE("CreateEntity starts at 1 and reuses removed ids")
+	{
+		TestWorld world;
+
+		babs_ecs::Entity first = world.CreateEntity();
+		babs_ecs::Entity second = world.CreateEntity();
+		REQUIRE(first.UUID == 1);
+		REQUIRE(second.UUID == 2);
+
+		world.RemoveEntity(first);
+		REQUIRE(world.IsAlive(first) == false);
+		REQUIRE(world.CreateEntity().UUID == 1);
+		REQUIRE(world.CreateEntity().UUID == 3);
+
+		CHECK_THROWS_AS(world.RemoveEntity(babs_ecs::Entity(42)), const std::runtime_error&);
+	}
+
+	TEST_CASE("Add, get and remove components")
+	{
+		TestWorld world;
+		babs_ecs::Entity e = world.CreateEntity();
+
+		world.AddComponent(e, Position{ 1.0f, 2.0f });
+		REQUIRE(world.HasComponent<Position>(e));
+		REQUIRE(world.HasComponent<Velocity>(e) == false);
+		REQUIRE(world.GetComponent<Position>(e)->y == 2.0f);
+		REQUIRE(world.GetComponent<Velocity>(e) == nullptr);
+		REQUIRE(world.Signature(e) == TestWorld::SignatureOf<Position>());
+
+		world.GetComponent<Position>(e)->x = 5.0f;
+		REQUIRE(world.GetComponent<Position>(e)->x == 5.0f);
+
+		REQUIRE(world.RemoveComponent<Position>(e) == babs_ecs::Status::Ok);
+		REQUIRE(world.RemoveComponent<Velocity>(e) == babs_ecs::Status::Ok);
+		REQUIRE(world.HasComponent<Position>(e) == false);
+		REQUIRE(world.GetComponent<Position>(e) == nullptr);
+		REQUIRE(world.Signature(e) == 0);
+
+		CHECK_THROWS_AS(world.AddComponent(babs_ecs::Entity(42), Dead{}), const std::runtime_error&);
+		CHECK_THROWS_AS(world.RemoveComponent<Position>(babs_ecs::Entity(42)), const std::runtime_error&);
+	}
+
+	TEST_CASE("EntitiesWith and Each match on every component")
+	{
+		TestWorld world;
+
+		for (int i = 0; i < 10; ++i)
+		{
+			babs_ecs::Entity e = world.CreateEntity();
+			world.AddComponent(e, Position{ 0.0f, 0.0f });
+
+			if (i % 2 == 0)
+			{
+				world.AddComponent(e, Velocity{ 1.0f, static_cast<float>(i) });
+			}
+		}
+
+		REQUIRE(world.EntitiesWith().size() == 10);
+		REQUIRE(world.EntitiesWith<Position>().size() == 10);
+		REQUIRE(world.EntitiesWith<Position, Velocity>().size() == 5);
+		REQUIRE(world.EntitiesWith<Dead>().size() == 0);
+
+		world.Each<Position, Velocity>([](babs_ecs::Entity, Position& p, Velocity& v) {
+			p.x += v.dx;
+			p.y += v.dy;
+		});
+
+		for (auto e : world.EntitiesWith<Velocity>())
+		{
+			REQUIRE(world.GetComponent<Position>(e)->x == 1.0f);
+			REQUIRE(world.GetComponent<Position>(e)->y == world.GetComponent<Velocity>(e)->dy);
+		}
+
+		// removing an entity removes it from every container
+		babs_ecs::Entity removed = world.EntitiesWith<Velocity>().front();
+		world.RemoveEntity(removed);
+		REQUIRE(world.EntitiesWith<Position>().size() == 9);
+		REQUIRE(world.EntitiesWith<Position, Velocity>().size() == 4);
+	}
+}
@@ -1,9 +1,18 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <string>
 #include <iomanip>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 #include "ECS.hpp"
+#include "ipc/Exporter.hpp"
+#include "persistence/Snapshot.hpp"
 
 class Timer {
 public:
@@ -46,6 +55,54 @@ struct Identity
 
 struct Tag {};
 
+struct Armed {};
+struct Shielded {};
+struct Flying {};
+
+struct Particle
+{
+	float x, y, z;
+	float vx, vy, vz;
+};
+
+struct ParticleSoA
+{
+	float x, y, z;
+	float vx, vy, vz;
+};
+
+namespace babs_ecs
+{
+	template <>
+	struct soa_layout<ParticleSoA>
+	{
+		using fields = soa_fields<&ParticleSoA::x, &ParticleSoA::y, &ParticleSoA::z, &ParticleSoA::vx, &ParticleSoA::vy, &ParticleSoA::vz>;
+	};
+
+	template <>
+	struct component_hash<Particle> : hash_members<&Particle::x, &Particle::y, &Particle::z, &Particle::vx, &Particle::vy, &Particle::vz> {};
+}
+
+// keeps the optimizer from dropping loops whose results are never read
+volatile float sink;
+
+// Hitpoints is the same component under each storage policy, so the policies can be compared
+template <typename Policy>
+struct Hitpoints
+{
+	int value;
+};
+
+namespace babs_ecs
+{
+	template <typename Policy>
+	struct component_traits<Hitpoints<Policy>>
+	{
+		using storage = Policy;
+	};
+}
+
+
 void babsEcsTest(int entityCount, int iterationCount, int tagProb)
 {
 	babs_ecs::ECSManager ecs;
@@ -78,6 +135,561 @@ void babsEcsTest(int entityCount, int iterationCount, int tagProb)
         timer.End();
         printResults("Identity + Tag", entityCount, iterationCount, tagProb, timer.elapsed);
 	}
+	{
+		auto& group = ecs.Group<Identity, Tag>();
+		Timer timer;
+
+		std::uint64_t sum = 0;
+		for (int i = 0; i < iterationCount; ++i) {
+			group.Each([&](babs_ecs::Entity, Identity&, Tag&) {
+				sum++;
+			});
+		}
+		timer.End();
+		printResults("Identity + Tag group", entityCount, iterationCount, tagProb, timer.elapsed);
+	}
+}
+
+// joinTest queries three components that are each common, but rarely found together, which is
+// where intersecting presence bitmaps beats checking every entity in the smallest pool.
+//
+// The Identity + Tag rows at 1/1000 can't show this: Tag is on only one entity in a thousand, so
+// its pool is tiny and the planner always walks it. Both plans are timed here on the same world,
+// through EntitiesWith with an explicit plan, next to what the planner picks.
+void joinTest(int entityCount, int iterationCount)
+{
+	babs_ecs::ECSManager ecs;
+	ecs.RegisterComponent<Armed>();
+	ecs.RegisterComponent<Shielded>();
+	ecs.RegisterComponent<Flying>();
+
+	// each component on 40% of the entities, about 6% have all three
+	uint32_t seed = 12345;
+	auto chance = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return (seed >> 8) % 100 < 40;
+	};
+
+	for (int i = 0; i < entityCount; ++i) {
+		auto entity = ecs.CreateEntity();
+		if (chance()) ecs.AddComponent(entity, Armed{});
+		if (chance()) ecs.AddComponent(entity, Shielded{});
+		if (chance()) ecs.AddComponent(entity, Flying{});
+	}
+
+	std::uint64_t sum = 0;
+	{
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			sum += ecs.EntitiesWith<Armed, Shielded, Flying>(babs_ecs::QueryPlan::SmallestPool).size();
+		}
+		timer.End();
+		printResults("Join, smallest pool", entityCount, iterationCount, 16, timer.elapsed);
+	}
+	{
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			sum += ecs.EntitiesWith<Armed, Shielded, Flying>(babs_ecs::QueryPlan::Bitmaps).size();
+		}
+		timer.End();
+		printResults("Join, bitmaps\t", entityCount, iterationCount, 16, timer.elapsed);
+	}
+	{
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			sum += ecs.EntitiesWith<Armed, Shielded, Flying>().size();
+		}
+		timer.End();
+		printResults(ecs.PlanQuery<Armed, Shielded, Flying>() == babs_ecs::QueryPlan::Bitmaps ? "Join, planned (bitmaps)" : "Join, planned (pool)", entityCount, iterationCount, 16, timer.elapsed);
+	}
+	sink = static_cast<float>(sum);
+}
+
+// storageTest gives a component to one entity in `sparsity`, then reads it back through
+// GetComponent for every entity, which is the access pattern policies differ most in
+template <typename Policy>
+void storageTest(std::string name, int entityCount, int iterationCount, int sparsity)
+{
+	babs_ecs::ECSManager ecs;
+	ecs.RegisterComponent<Hitpoints<Policy>>();
+
+	std::vector<babs_ecs::Entity> entities;
+	for (int i = 0; i < entityCount; ++i) {
+		entities.push_back(ecs.CreateEntity());
+	}
+
+	{
+		Timer timer;
+		for (int i = 0; i < entityCount; i += sparsity) {
+			ecs.AddComponent(entities[i], Hitpoints<Policy>{ i });
+		}
+		timer.End();
+		printResults(name + " add\t", entityCount, 1, sparsity, timer.elapsed);
+	}
+	{
+		Timer timer;
+		std::int64_t sum = 0;
+		for (int i = 0; i < iterationCount; ++i) {
+			for (const babs_ecs::Entity& entity : entities) {
+				if (Hitpoints<Policy>* hitpoints = ecs.GetComponent<Hitpoints<Policy>>(entity)) {
+					sum += hitpoints->value;
+				}
+			}
+		}
+		timer.End();
+		printResults(name + " get\t", entityCount, iterationCount, sparsity, timer.elapsed);
+		sink = static_cast<float>(sum);
+	}
+}
+
+void storagePolicyTest(int entityCount, int iterationCount, int sparsity)
+{
+	storageTest<babs_ecs::dense_storage>("Dense", entityCount, iterationCount, sparsity);
+	storageTest<babs_ecs::paged_storage>("Paged", entityCount, iterationCount, sparsity);
+	storageTest<babs_ecs::stable_storage>("Stable", entityCount, iterationCount, sparsity);
+	storageTest<babs_ecs::map_storage>("Map", entityCount, iterationCount, sparsity);
+}
+
+void spawnTest(int entityCount)
+{
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Identity>();
+		ecs.RegisterComponent<Tag>();
+
+		Timer timer;
+		for (int i = 0; i < entityCount; ++i) {
+			auto entity = ecs.CreateEntity();
+			ecs.AddComponent(entity, Identity{ 1 });
+			ecs.AddComponent(entity, Tag{});
+		}
+		timer.End();
+		printResults("Spawn one by one", entityCount, 1, 1, timer.elapsed);
+	}
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Identity>();
+		ecs.RegisterComponent<Tag>();
+
+		babs_ecs::Prefab prefab;
+		prefab.Set(Identity{ 1 }).Set(Tag{});
+
+		Timer timer;
+		ecs.Instantiate(prefab, entityCount);
+		timer.End();
+		printResults("Spawn from prefab", entityCount, 1, 1, timer.elapsed);
+	}
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Identity>();
+		ecs.RegisterComponent<Tag>();
+
+		unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<babs_ecs::SpawnBuffer> spawners;
+		for (unsigned t = 0; t < threadCount; ++t) {
+			spawners.emplace_back(ecs);
+		}
+
+		Timer staging;
+		std::vector<std::thread> workers;
+		for (unsigned t = 0; t < threadCount; ++t) {
+			workers.emplace_back([&spawners, t, threadCount, entityCount]() {
+				for (int i = static_cast<int>(t); i < entityCount; i += static_cast<int>(threadCount)) {
+					auto entity = spawners[t].Create();
+					spawners[t].Add(entity, Identity{ 1 });
+					spawners[t].Add(entity, Tag{});
+				}
+			});
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+		staging.End();
+		printResults("Spawn staged on workers", entityCount, 1, 1, staging.elapsed);
+
+		Timer timer;
+		for (auto& spawner : spawners) {
+			spawner.Commit();
+		}
+		timer.End();
+		printResults("Spawn staged, commit", entityCount, 1, 1, timer.elapsed);
+	}
+}
+
+// integrate is the kernel for one SoA axis, simple enough for the compiler to vectorise
+void integrate(float* position, const float* velocity, size_t count, float dt)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		position[i] += velocity[i] * dt;
+	}
+}
+
+// integrateTest moves particles by their velocity, once with the particles stored as structs
+// (AoS) and once with a soa_layout (SoA). Build with -mavx2 (or -march=native) for the AVX2 row.
+void integrateTest(int entityCount, int iterationCount)
+{
+	const float dt = 0.016f;
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Particle>();
+
+		babs_ecs::Prefab prefab;
+		prefab.Set(Particle{ 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f });
+		ecs.Instantiate(prefab, entityCount);
+
+		Timer timer;
+		auto particles = ecs.GetComponentArray<Particle>();
+		for (int i = 0; i < iterationCount; ++i) {
+			for (Particle& p : particles)
+			{
+				p.x += p.vx * dt;
+				p.y += p.vy * dt;
+				p.z += p.vz * dt;
+			}
+		}
+		timer.End();
+		sink = particles[0].x;
+		printResults("Integrate AoS", entityCount, iterationCount, 1, timer.elapsed);
+	}
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<ParticleSoA>();
+
+		babs_ecs::Prefab prefab;
+		prefab.Set(ParticleSoA{ 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f });
+		ecs.Instantiate(prefab, entityCount);
+
+		Timer timer;
+		auto particles = ecs.GetComponentArray<ParticleSoA>();
+		float* x = particles.Field<&ParticleSoA::x>();
+		float* y = particles.Field<&ParticleSoA::y>();
+		float* z = particles.Field<&ParticleSoA::z>();
+		const float* vx = particles.Field<&ParticleSoA::vx>();
+		const float* vy = particles.Field<&ParticleSoA::vy>();
+		const float* vz = particles.Field<&ParticleSoA::vz>();
+		size_t count = particles.PaddedSize<&ParticleSoA::x>();
+
+		for (int i = 0; i < iterationCount; ++i) {
+			integrate(x, vx, count, dt);
+			integrate(y, vy, count, dt);
+			integrate(z, vz, count, dt);
+		}
+		timer.End();
+		sink = x[0];
+		printResults("Integrate SoA", entityCount, iterationCount, 1, timer.elapsed);
+
+#if defined(__AVX2__)
+		static_assert(BABS_ECS_ALIGNMENT >= 32, "aligned AVX loads need 32 byte alignment");
+
+		Timer avxTimer;
+		const __m256 step = _mm256_set1_ps(dt);
+		for (int i = 0; i < iterationCount; ++i) {
+			// the arrays are aligned and padded to 8 floats, so there's no remainder loop
+			for (size_t j = 0; j < count; j += 8) {
+				_mm256_store_ps(x + j, _mm256_add_ps(_mm256_load_ps(x + j), _mm256_mul_ps(_mm256_load_ps(vx + j), step)));
+				_mm256_store_ps(y + j, _mm256_add_ps(_mm256_load_ps(y + j), _mm256_mul_ps(_mm256_load_ps(vy + j), step)));
+				_mm256_store_ps(z + j, _mm256_add_ps(_mm256_load_ps(z + j), _mm256_mul_ps(_mm256_load_ps(vz + j), step)));
+			}
+		}
+		avxTimer.End();
+		sink = x[0];
+		printResults("Integrate SoA AVX2", entityCount, iterationCount, 1, avxTimer.elapsed);
+#endif
+	}
+}
+
+// forkTest forks a world and runs one tick in the fork that only writes one entity, the pattern
+// of rollback and lookahead searches. Forking shares the pages of the entity table and bitmaps,
+// so it should cost the same at any world size. Writing a dense pool copies that pool, writing a
+// paged one only copies the page that was written.
+void forkTest(int entityCount, int iterationCount)
+{
+	babs_ecs::ECSManager ecs;
+	ecs.RegisterComponent<Identity>();
+	ecs.RegisterComponent<Particle>();
+	ecs.RegisterComponent<Hitpoints<babs_ecs::paged_storage>>();
+
+	babs_ecs::Prefab prefab;
+	prefab.Set(Identity{ 1 }).Set(Particle{ 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f }).Set(Hitpoints<babs_ecs::paged_storage>{ 100 });
+	ecs.Instantiate(prefab, entityCount);
+
+	{
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			auto fork = ecs.Fork();
+		}
+		timer.End();
+		printResults("Fork\t\t", entityCount, iterationCount, 1, timer.elapsed);
+	}
+	{
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			auto fork = ecs.Fork();
+			fork->GetComponent<Hitpoints<babs_ecs::paged_storage>>(babs_ecs::Entity(1))->value--;
+		}
+		timer.End();
+		printResults("Fork, write paged", entityCount, iterationCount, 1, timer.elapsed);
+	}
+	{
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			auto fork = ecs.Fork();
+			fork->Patch<Identity>(babs_ecs::Entity(1), [](Identity& identity) { identity.uuid++; });
+		}
+		timer.End();
+		printResults("Fork, write dense", entityCount, iterationCount, 1, timer.elapsed);
+	}
+}
+
+// hashTest hashes the world every tick, once with every container written and once with only
+// the entity table and one small write
+void hashTest(int entityCount, int iterationCount)
+{
+	babs_ecs::ECSManager ecs;
+	ecs.RegisterComponent<Identity>();
+	ecs.RegisterComponent<Particle>();
+
+	babs_ecs::Prefab prefab;
+	prefab.Set(Identity{ 1 }).Set(Particle{ 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f });
+	ecs.Instantiate(prefab, entityCount);
+
+	std::uint64_t digest = 0;
+	{
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			ecs.GetComponentArray<Identity>();
+			ecs.GetComponentArray<Particle>();
+			digest += ecs.Hash();
+		}
+		timer.End();
+		printResults("Hash, all written", entityCount, iterationCount, 1, timer.elapsed);
+	}
+	{
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			ecs.GetComponent<Identity>(babs_ecs::Entity(1))->uuid = i;
+			digest += ecs.Hash();
+		}
+		timer.End();
+		printResults("Hash, one written", entityCount, iterationCount, 1, timer.elapsed);
+	}
+	sink = static_cast<float>(digest);
+}
+
+// migrateTest moves a batch of entities between two zones every tick, there and back again
+void migrateTest(int entityCount, int iterationCount, int batchSize)
+{
+	babs_ecs::ECSManager west;
+	babs_ecs::ECSManager east;
+	west.RegisterComponent<Identity>();
+	west.RegisterComponent<Particle>();
+	west.RegisterComponent<Tag>();
+	east.RegisterComponent<Particle>();
+
+	babs_ecs::Prefab prefab;
+	prefab.Set(Identity{ 1 }).Set(Particle{ 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f }).Set(Tag{});
+	std::vector<babs_ecs::Entity> entities = west.Instantiate(prefab, entityCount);
+	std::vector<babs_ecs::Entity> batch(entities.begin(), entities.begin() + batchSize);
+
+	Timer timer;
+	for (int i = 0; i < iterationCount; ++i) {
+		batch = west.MoveEntities(batch, east);
+		batch = east.MoveEntities(batch, west);
+	}
+	timer.End();
+	printResults("Migrate		", entityCount, iterationCount, entityCount / batchSize, timer.elapsed);
+}
+
+// bulkTest runs frame-end cleanup, adding a tag to a third of the entities, clearing it and
+// destroying them, once entity by entity and once with the bulk operations
+void bulkTest(int entityCount, int iterationCount)
+{
+	babs_ecs::Prefab prefab;
+	prefab.Set(Identity{ 1 }).Set(Particle{ 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f });
+
+	auto setup = [&](babs_ecs::ECSManager& ecs) {
+		ecs.RegisterComponent<Identity>();
+		ecs.RegisterComponent<Particle>();
+		ecs.RegisterComponent<Tag>();
+		ecs.RegisterComponent<Armed>();
+	};
+
+	{
+		babs_ecs::ECSManager ecs;
+		setup(ecs);
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			std::vector<babs_ecs::Entity> created = ecs.Instantiate(prefab, entityCount);
+			for (size_t j = 0; j < created.size(); j += 3) {
+				ecs.AddComponent(created[j], Tag{});
+			}
+			for (auto e : ecs.EntitiesWith<Tag>()) {
+				ecs.AddComponent(e, Armed{});
+			}
+			for (auto e : ecs.EntitiesWith<Armed>()) {
+				ecs.RemoveComponent<Armed>(e);
+			}
+			for (auto e : ecs.EntitiesWith<Tag>()) {
+				ecs.RemoveEntity(e);
+			}
+			for (auto e : ecs.EntitiesWith<Identity>()) {
+				ecs.RemoveEntity(e);
+			}
+		}
+		timer.End();
+		printResults("Cleanup one by one", entityCount, iterationCount, 3, timer.elapsed);
+	}
+	{
+		babs_ecs::ECSManager ecs;
+		setup(ecs);
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			std::vector<babs_ecs::Entity> created = ecs.Instantiate(prefab, entityCount);
+			for (size_t j = 0; j < created.size(); j += 3) {
+				ecs.AddComponent(created[j], Tag{});
+			}
+			ecs.AddToAll<Tag>(Armed{});
+			ecs.Clear<Armed>();
+			ecs.DestroyAll<Tag>();
+			ecs.DestroyAll<Identity>();
+		}
+		timer.End();
+		printResults("Cleanup in bulk", entityCount, iterationCount, 3, timer.elapsed);
+	}
+}
+
+// toggleTest turns half of the entities off, queries the rest and turns them back on, once with
+// a tag component that the query has to filter out and once with SetEnabled
+void toggleTest(int entityCount, int iterationCount)
+{
+	babs_ecs::Prefab prefab;
+	prefab.Set(Identity{ 1 }).Set(Particle{ 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f });
+
+	auto setup = [&](babs_ecs::ECSManager& ecs) {
+		ecs.RegisterComponent<Identity>();
+		ecs.RegisterComponent<Particle>();
+		ecs.RegisterComponent<Tag>();
+		return ecs.Instantiate(prefab, entityCount);
+	};
+
+	size_t found = 0;
+	{
+		babs_ecs::ECSManager ecs;
+		std::vector<babs_ecs::Entity> created = setup(ecs);
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			for (int j = 0; j < entityCount / 2; ++j) {
+				ecs.AddComponent(created[j], Tag{});
+			}
+			for (auto e : ecs.EntitiesWith<Identity, Particle>()) {
+				found += ecs.HasComponent<Tag>(e) ? 0 : 1;
+			}
+			ecs.Clear<Tag>();
+		}
+		timer.End();
+		printResults("Toggle with a tag", entityCount, iterationCount, 2, timer.elapsed);
+	}
+	{
+		babs_ecs::ECSManager ecs;
+		std::vector<babs_ecs::Entity> created = setup(ecs);
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			ecs.SetEnabled(created.front(), created[entityCount / 2 - 1], false);
+			found += ecs.EntitiesWith<Identity, Particle>().size();
+			ecs.SetEnabled(created.front(), created.back(), true);
+		}
+		timer.End();
+		printResults("Toggle with SetEnabled", entityCount, iterationCount, 2, timer.elapsed);
+	}
+
+	// keep the queries from being optimised away
+	if (found == 0) {
+		std::cout << "nothing found" << std::endl;
+	}
+}
+
+// exportTest hands the world to another process every frame, once by serializing query results
+// into a buffer (what would be written to a pipe) and once by publishing to shared memory
+void exportTest(int entityCount, int iterationCount)
+{
+	babs_ecs::ECSManager ecs;
+	ecs.RegisterComponent<Identity>();
+	ecs.RegisterComponent<Particle>();
+	for (int i = 0; i < entityCount; ++i) {
+		auto entity = ecs.CreateEntity();
+		ecs.AddComponent(entity, Identity{ i });
+		ecs.AddComponent(entity, Particle{ 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f });
+	}
+
+	{
+		std::vector<char> buffer;
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			buffer.clear();
+			for (auto e : ecs.EntitiesWith<Identity, Particle>()) {
+				const Identity* identity = ecs.ReadComponent<Identity>(e);
+				const Particle* particle = ecs.ReadComponent<Particle>(e);
+				buffer.insert(buffer.end(), reinterpret_cast<const char*>(&e), reinterpret_cast<const char*>(&e) + sizeof(e));
+				buffer.insert(buffer.end(), reinterpret_cast<const char*>(identity), reinterpret_cast<const char*>(identity) + sizeof(Identity));
+				buffer.insert(buffer.end(), reinterpret_cast<const char*>(particle), reinterpret_cast<const char*>(particle) + sizeof(Particle));
+			}
+		}
+		timer.End();
+		printResults("Export by serializing", entityCount, iterationCount, 1, timer.elapsed);
+	}
+
+#if defined(BABS_ECS_POSIX_SHM)
+	{
+		auto exporter = ipc::Exporter<Identity, Particle>::Create("/babs_ecs_benchmark", static_cast<uint32_t>(entityCount + 1));
+		Timer timer;
+		for (int i = 0; i < iterationCount; ++i) {
+			exporter->Publish(ecs);
+		}
+		timer.End();
+		printResults("Export to shared memory", entityCount, iterationCount, 1, timer.elapsed);
+	}
+#endif
+}
+
+// snapshotTest compares rebuilding a world entity by entity, the way a server boots from its own
+// save format, with checkpointing it and restoring the checkpoint
+void snapshotTest(int entityCount)
+{
+	using Save = persistence::Snapshot<Identity, Particle, Tag>;
+	std::string path = "babs_ecs_benchmark.snapshot";
+
+	babs_ecs::ECSManager ecs;
+	ecs.RegisterComponent<Identity>();
+	ecs.RegisterComponent<Particle>();
+	ecs.RegisterComponent<Tag>();
+	{
+		Timer timer;
+		for (int i = 0; i < entityCount; ++i) {
+			auto entity = ecs.CreateEntity();
+			ecs.AddComponent(entity, Identity{ i });
+			ecs.AddComponent(entity, Particle{ 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3.0f });
+			if (i % 3 == 0) {
+				ecs.AddComponent(entity, Tag{});
+			}
+		}
+		timer.End();
+		printResults("Rebuild one by one", entityCount, 1, 3, timer.elapsed);
+	}
+	{
+		Timer timer;
+		Save::Checkpoint(ecs, path);
+		timer.End();
+		printResults("Checkpoint\t", entityCount, 1, 3, timer.elapsed);
+	}
+	{
+		babs_ecs::ECSManager restored;
+		Timer timer;
+		Save::Restore(restored, path);
+		timer.End();
+		printResults("Restore\t\t", entityCount, 1, 3, timer.elapsed);
+	}
+	std::remove(path.c_str());
 }
 
 void runTest(int entityCount, int iterationCount, int tagProb) {
@@ -93,5 +705,19 @@ int main() {
 	runTest(100'000, 10'000, 5);
 	runTest(10'000, 100'000, 1'000);
 	runTest(100'000, 100'000, 1'000);
+	joinTest(1'000'000, 20);
+	storagePolicyTest(1'000'000, 20, 1);
+	storagePolicyTest(1'000'000, 20, 1'000);
+	spawnTest(5'000);
+	spawnTest(30'000);
+	integrateTest(100'000, 1'000);
+	forkTest(10'000, 1'000);
+	forkTest(1'000'000, 1'000);
+	hashTest(100'000, 1'000);
+	migrateTest(100'000, 1'000, 2'000);
+	snapshotTest(1'000'000);
+	bulkTest(100'000, 20);
+	toggleTest(100'000, 100);
+	exportTest(100'000, 1'000);
 	printFooter();
 }
\ No newline at end of file
@@ -1,13 +1,17 @@
 #pragma once
 
+#include <algorithm>
 #include <functional>
-#include <map>
+#include <memory>
 #include <vector>
-#include <string>
-#include <any>
+
+#include "../TypeId.hpp"
 
 namespace events
 {
+    // EventFamily is the TypeIds family used to index observers by event type
+    struct EventFamily {};
+
     // EventManager is a simple observer pattern for subscribing to and broadcasting custom events
     class EventManager
     {
@@ -16,41 +20,144 @@ namespace events
         template <typename EventType>
         using EventHandler = std::function<void(const EventType&)>;
 
+        // SubscriptionId identifies a subscription so it can be removed again with Unsubscribe
+        using SubscriptionId = size_t;
+
         // Subscribe to the provided EventType with a function
         template <typename EventType>
-        void Subscribe(EventHandler<EventType>&& slot)
+        SubscriptionId Subscribe(EventHandler<EventType>&& slot)
+        {
+            size_t type = babs_ecs::TypeIds<EventFamily>::Of<EventType>();
+            if (type >= this->observers.size())
+            {
+                this->observers.resize(type + 1);
+            }
+
+            SubscriptionId id = this->nextSubscriptionId++;
+            this->observers[type].push_back({ id, std::make_unique<Handler<EventType>>(std::move(slot)) });
+            return id;
+        }
+
+        // Unsubscribe removes the observer added by Subscribe. Observers that capture objects with
+        // a shorter lifetime than the manager must unsubscribe before they go away.
+        template <typename EventType>
+        void Unsubscribe(SubscriptionId id)
         {
-            std::string type = typeid(EventType).name();
-            this->observers[type].push_back(slot);
+            size_t type = babs_ecs::TypeIds<EventFamily>::Of<EventType>();
+            if (type >= this->observers.size())
+            {
+                return;
+            }
+
+            auto& handlers = this->observers[type];
+            auto observer = std::find_if(handlers.begin(), handlers.end(), [id](const Observer& observer) {
+                return observer.id == id;
+            });
+
+            if (observer == handlers.end())
+            {
+                return;
+            }
+
+            // a handler may be running right now, so it's only dropped once the outermost broadcast ends
+            if (this->broadcasting > 0)
+            {
+                observer->removed = true;
+                this->hasRemoved = true;
+                return;
+            }
+
+            handlers.erase(observer);
         }
 
-        // Broadcast will emit the EventType to all registered observers
+        // Broadcast will emit the EventType to all registered observers. It doesn't allocate, so it's
+        // cheap to call on every component change even when nobody is listening.
+        //
+        // Observers subscribed while the event is being broadcast only see the next one. If an
+        // observer throws, the exception leaves Broadcast and the observers after it miss the event.
         template <typename EventType>
         void Broadcast(const EventType& event) const
         {
-            std::string type = typeid(EventType).name();
+            size_t type = babs_ecs::TypeIds<EventFamily>::Of<EventType>();
 
             // bail if we don't have any observers
-            if (observers.find(type) == observers.end())
+            if (type >= this->observers.size() || this->observers[type].empty())
             {
                 return;
             }
 
-            // for each observer, call their event handler
-            auto event_observers = this->observers.at(type);
+            BroadcastScope scope(*this);
 
-            for (auto event_observer : event_observers)
+            // handlers live on the heap, so subscribing from inside a handler can't move the one that's running
+            size_t count = this->observers[type].size();
+            for (size_t i = 0; i < count; ++i)
             {
-                // cast back to the concrete function handler and call it
-                // we do this here so that the observer doesn't have to
-                auto handler = std::any_cast<EventHandler<EventType>>(event_observer);
-
-                handler(event);
+                const Observer& observer = this->observers[type][i];
+                if (!observer.removed)
+                {
+                    static_cast<Handler<EventType>*>(observer.handler.get())->function(event);
+                }
             }
         }
 
     private:
-        // this is a map of event type names -> list of function handlers
-        std::map<std::string, std::vector<std::any>> observers;
+        struct BaseHandler
+        {
+            virtual ~BaseHandler() {};
+        };
+
+        template <typename EventType>
+        struct Handler : BaseHandler
+        {
+            Handler(EventHandler<EventType>&& function) : function(std::move(function)) {}
+            EventHandler<EventType> function;
+        };
+
+        struct Observer
+        {
+            SubscriptionId id;
+            std::unique_ptr<BaseHandler> handler;
+            bool removed = false;
+        };
+
+        // observers are indexed by TypeIds<EventFamily>, so a broadcast is a single indexed load
+        mutable std::vector<std::vector<Observer>> observers;
+        SubscriptionId nextSubscriptionId = 0;
+
+        mutable size_t broadcasting = 0;
+        mutable bool hasRemoved = false;
+
+        // BroadcastScope counts a running broadcast. An observer that throws (like a unique field
+        // index refusing a key) ends the broadcast early, and the count still has to come down.
+        struct BroadcastScope
+        {
+            const EventManager& events;
+
+            BroadcastScope(const EventManager& events) : events(events)
+            {
+                this->events.broadcasting++;
+            }
+
+            ~BroadcastScope()
+            {
+                this->events.broadcasting--;
+
+                if (this->events.broadcasting == 0 && this->events.hasRemoved)
+                {
+                    this->events.Compact();
+                }
+            }
+        };
+
+        void Compact() const
+        {
+            for (auto& handlers : this->observers)
+            {
+                handlers.erase(std::remove_if(handlers.begin(), handlers.end(), [](const Observer& observer) {
+                    return observer.removed;
+                }), handlers.end());
+            }
+            this->hasRemoved = false;
+        }
     };
 }
@@ -49,11 +49,57 @@ TEST_SUITE("Event Manager")
 		ExampleObserver observer;
 		REQUIRE(observer.eventCount == 0);
 
-		eventManager.Subscribe<ExampleEvent>(std::bind(&ExampleObserver::HandlExample, &observer, std::placeholders::_1));
+		auto id = eventManager.Subscribe<ExampleEvent>(std::bind(&ExampleObserver::HandlExample, &observer, std::placeholders::_1));
 		eventManager.Broadcast<ExampleEvent>(ExampleEvent(expectedPayload));
 
 		REQUIRE(observer.eventCount == 1);
 		REQUIRE(observer.lastPayloadReceived == expectedPayload);
+
+		// the observer goes out of scope, so it must stop listening
+		eventManager.Unsubscribe<ExampleEvent>(id);
+	}
+
+	TEST_CASE("EventManager stops calling unsubscribed observers")
+	{
+		events::EventManager localEvents;
+		int calls = 0;
+
+		auto first = localEvents.Subscribe<ExampleEvent>([&](const ExampleEvent&) { calls++; });
+		localEvents.Subscribe<ExampleEvent>([&](const ExampleEvent&) { calls += 10; });
+
+		localEvents.Broadcast<ExampleEvent>(ExampleEvent(1));
+		REQUIRE(calls == 11);
+
+		localEvents.Unsubscribe<ExampleEvent>(first);
+		localEvents.Broadcast<ExampleEvent>(ExampleEvent(1));
+		REQUIRE(calls == 21);
+
+		// unknown ids and event types are ignored
+		localEvents.Unsubscribe<ExampleEvent>(first);
+		localEvents.Unsubscribe<int>(first);
+	}
+
+	TEST_CASE("EventManager handlers can subscribe and unsubscribe while a broadcast is running")
+	{
+		events::EventManager localEvents;
+		int calls = 0;
+		int lateCalls = 0;
+		events::EventManager::SubscriptionId self = 0;
+
+		self = localEvents.Subscribe<ExampleEvent>([&](const ExampleEvent&) {
+			calls++;
+			localEvents.Unsubscribe<ExampleEvent>(self);
+			localEvents.Subscribe<ExampleEvent>([&](const ExampleEvent&) { lateCalls++; });
+		});
+
+		// the new observer only sees the next broadcast, the removed one is gone after this one
+		localEvents.Broadcast<ExampleEvent>(ExampleEvent(1));
+		REQUIRE(calls == 1);
+		REQUIRE(lateCalls == 0);
+
+		localEvents.Broadcast<ExampleEvent>(ExampleEvent(1));
+		REQUIRE(calls == 1);
+		REQUIRE(lateCalls == 1);
 	}
 
 	TEST_CASE("EventManager can broadcast an event no one is listening to")
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "../ComponentObserver.hpp"
+#include "../ECSManager.hpp"
+#include "../Entity.hpp"
+#include "../Events.hpp"
+#include "../Exceptions.hpp"
+#include "../Layout.hpp"
+
+// The indexes namespace contains optional secondary indexes that find entities by the value of a
+// component field. Like the spatial indexes, they follow the ECS events and don't need to be
+// registered with the manager.
+namespace indexes
+{
+	// FieldKey is the type a pointer to member indexes by.
+	template <auto Field>
+	using FieldKey = std::decay_t<typename babs_ecs::member_pointer<decltype(Field)>::field>;
+
+	// Keys says whether entities may share a key in a FieldIndex.
+	enum class Keys
+	{
+		// any number of entities may have the same key
+		Shared,
+		// a key already held by another entity is an error, see FieldIndex::Update
+		Unique
+	};
+
+	// FieldIndex maps the value of one component field to the entities holding it. Use it through
+	// UnorderedIndex (O(1) lookups) or OrderedIndex (lookups and range queries).
+	//
+	// The index follows the component's events through a babs_ecs::ComponentObserver, see there for
+	// which ones. Writes made directly through GetComponent are not observed; report those with
+	// Update() instead.
+	template <auto Field, typename Map, Keys Mode>
+	class FieldIndex
+	{
+	public:
+		using Component = typename babs_ecs::member_pointer<decltype(Field)>::owner;
+		using Key = FieldKey<Field>;
+
+		static_assert(!babs_ecs::is_soa_v<Component>, "SoA components can't be indexed");
+
+		FieldIndex(babs_ecs::ECSManager& ecs)
+			: observer(ecs, [this](babs_ecs::Entity e, const Component& component) { this->Update(e, component); }, [this](babs_ecs::Entity e) { this->Remove(e); })
+		{
+			// index everything that already exists, a unique index reports the first repeated key
+			for (babs_ecs::Entity e : ecs.EntitiesWith<Component>(babs_ecs::DisabledEntities::Include))
+			{
+				this->Update(e, *ecs.ReadComponent<Component>(e));
+			}
+		}
+
+		FieldIndex(const FieldIndex&) = delete;
+		FieldIndex& operator=(const FieldIndex&) = delete;
+
+		// Update re-indexes the entity under the component's current key. Use it for changes the
+		// index can't see, like writes through GetComponent.
+		//
+		// A unique index refuses a key another entity already has: the entity is dropped from the
+		// index and DuplicateKeyException is thrown, or Status::DuplicateKey returned without
+		// exceptions. The world can't be stopped from holding the component, so when the key comes
+		// from an event the exception leaves the AddComponent, Patch or Instantiate that raised it,
+		// after the component was stored. Events have nowhere to return a Status to, so without
+		// exceptions those duplicates are only left out.
+		babs_ecs::Status Update(babs_ecs::Entity entity, const Component& component)
+		{
+			const Key& key = component.*Field;
+
+			auto existing = this->keys.find(entity.UUID);
+			if (existing != this->keys.end() && existing->second == key)
+			{
+				return babs_ecs::Status::Ok;
+			}
+
+			if constexpr (Mode == Keys::Unique)
+			{
+				auto holder = this->entries.find(key);
+				if (holder != this->entries.end())
+				{
+					uint32_t holderId = holder->second;
+
+					// the old key no longer describes the entity, so it's left out altogether
+					this->Remove(entity);
+					BABS_ECS_ERROR(babs_ecs::DuplicateKeyException(entity.UUID, holderId), babs_ecs::Status::DuplicateKey);
+				}
+			}
+
+			if (existing != this->keys.end())
+			{
+				this->EraseEntry(existing->second, entity.UUID);
+				existing->second = key;
+			}
+			else
+			{
+				this->keys.emplace(entity.UUID, key);
+			}
+
+			this->entries.emplace(key, entity.UUID);
+			return babs_ecs::Status::Ok;
+		}
+
+		// Remove drops the entity from the index. Removing an entity that isn't indexed does nothing.
+		void Remove(babs_ecs::Entity entity)
+		{
+			auto existing = this->keys.find(entity.UUID);
+			if (existing == this->keys.end())
+			{
+				return;
+			}
+
+			this->EraseEntry(existing->second, entity.UUID);
+			this->keys.erase(existing);
+		}
+
+		// Find returns the entity with the key, or a dummy entity (UUID 0) if there is none. If
+		// several entities share the key, any one of them is returned.
+		babs_ecs::Entity Find(const Key& key) const
+		{
+			auto entry = this->entries.find(key);
+			return entry != this->entries.end() ? babs_ecs::Entity(entry->second) : babs_ecs::Entity();
+		}
+
+		// FindAll returns every entity with the key.
+		std::vector<babs_ecs::Entity> FindAll(const Key& key) const
+		{
+			std::vector<babs_ecs::Entity> found;
+			auto range = this->entries.equal_range(key);
+
+			for (auto entry = range.first; entry != range.second; ++entry)
+			{
+				found.emplace_back(entry->second);
+			}
+
+			return found;
+		}
+
+		// Range returns the entities with min <= key <= max, in key order. Only OrderedIndex has it.
+		std::vector<babs_ecs::Entity> Range(const Key& min, const Key& max) const
+		{
+			std::vector<babs_ecs::Entity> found;
+			auto last = this->entries.upper_bound(max);
+
+			for (auto entry = this->entries.lower_bound(min); entry != last; ++entry)
+			{
+				found.emplace_back(entry->second);
+			}
+
+			return found;
+		}
+
+		// Size returns the number of indexed entities.
+		size_t Size() const
+		{
+			return this->keys.size();
+		}
+
+	private:
+		Map entries;
+
+		// keys remembers what each entity was indexed under, removal events don't carry the component
+		std::unordered_map<uint32_t, Key> keys;
+
+		// last, so it stops calling back before the maps go away
+		babs_ecs::ComponentObserver<Component> observer;
+
+		void EraseEntry(const Key& key, uint32_t uuid)
+		{
+			auto range = this->entries.equal_range(key);
+
+			for (auto entry = range.first; entry != range.second; ++entry)
+			{
+				if (entry->second == uuid)
+				{
+					this->entries.erase(entry);
+					return;
+				}
+			}
+		}
+	};
+
+	// UnorderedIndex hashes entities by a field. By default duplicates are kept: Find returns any one
+	// of the entities with a key and FindAll returns all of them. Fields that must be unique, like a
+	// network or database id, can use Keys::Unique to have a repeated key reported instead.
+	//
+	// Typical usage:
+	//   indexes::UnorderedIndex<&Identity::uuid, indexes::Keys::Unique> byId(ecs);
+	//   babs_ecs::Entity player = byId.Find(packet.playerId);
+	template <auto Field, Keys Mode = Keys::Shared>
+	using UnorderedIndex = FieldIndex<Field, std::unordered_multimap<FieldKey<Field>, uint32_t>, Mode>;
+
+	// OrderedIndex keeps entities sorted by a field, for range queries.
+	//
+	// Typical usage:
+	//   indexes::OrderedIndex<&Score::points> byScore(ecs);
+	//   for (auto e : byScore.Range(100, 200)) { ... }
+	template <auto Field, Keys Mode = Keys::Shared>
+	using OrderedIndex = FieldIndex<Field, std::multimap<FieldKey<Field>, uint32_t>, Mode>;
+}
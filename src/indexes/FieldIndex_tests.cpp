@@ -0,0 +1,151 @@
+#include "doctest.h"
+
+#include <string>
+#include <vector>
+
+#include "FieldIndex.hpp"
+#include "../ECSManager.hpp"
+#include "../Exceptions.hpp"
+#include "../Prefab.hpp"
+
+namespace
+{
+	struct Identity
+	{
+		std::string uuid;
+	};
+
+	struct Score
+	{
+		int points;
+	};
+}
+
+TEST_SUITE("Field indexes")
+{
+	TEST_CASE("UnorderedIndex finds entities by key as components come and go")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Identity>();
+
+		babs_ecs::Entity existing = ecs.CreateEntity();
+		ecs.AddComponent(existing, Identity{ "babs" });
+
+		indexes::UnorderedIndex<&Identity::uuid> byId(ecs);
+		REQUIRE(byId.Find("babs").UUID == existing.UUID);
+
+		babs_ecs::Entity added = ecs.CreateEntity();
+		ecs.AddComponent(added, Identity{ "bob" });
+		REQUIRE(byId.Find("bob").UUID == added.UUID);
+		REQUIRE(byId.Size() == 2);
+
+		// re-adding the component moves it to the new key
+		ecs.AddComponent(added, Identity{ "robert" });
+		REQUIRE(byId.Find("bob").UUID == 0);
+		REQUIRE(byId.Find("robert").UUID == added.UUID);
+
+		ecs.Patch<Identity>(added, [](Identity& identity) { identity.uuid = "rob"; });
+		REQUIRE(byId.Find("robert").UUID == 0);
+		REQUIRE(byId.Find("rob").UUID == added.UUID);
+
+		// silent writes have to be reported
+		ecs.GetComponent<Identity>(existing)->uuid = "barbara";
+		byId.Update(existing, *ecs.GetComponent<Identity>(existing));
+		REQUIRE(byId.Find("barbara").UUID == existing.UUID);
+
+		ecs.RemoveComponent<Identity>(added);
+		ecs.RemoveEntity(existing);
+		REQUIRE(byId.Find("rob").UUID == 0);
+		REQUIRE(byId.Find("barbara").UUID == 0);
+		REQUIRE(byId.Size() == 0);
+	}
+
+	TEST_CASE("UnorderedIndex keeps every entity that shares a key")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Identity>();
+
+		babs_ecs::Prefab prefab;
+		prefab.Set(Identity{ "grunt" });
+		std::vector<babs_ecs::Entity> grunts = ecs.Instantiate(prefab, 3);
+
+		indexes::UnorderedIndex<&Identity::uuid> byId(ecs);
+		REQUIRE(byId.FindAll("grunt").size() == 3);
+
+		ecs.RemoveEntity(grunts[1]);
+		std::vector<babs_ecs::Entity> remaining = byId.FindAll("grunt");
+		REQUIRE(remaining.size() == 2);
+		REQUIRE(remaining[0].UUID != grunts[1].UUID);
+		REQUIRE(remaining[1].UUID != grunts[1].UUID);
+
+		// entities instantiated after the index exists are picked up too
+		ecs.Instantiate(prefab, 2);
+		REQUIRE(byId.FindAll("grunt").size() == 4);
+	}
+
+	TEST_CASE("A unique UnorderedIndex reports a key another entity already has")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Identity>();
+
+		using UniqueIds = indexes::UnorderedIndex<&Identity::uuid, indexes::Keys::Unique>;
+		UniqueIds byId(ecs);
+
+		babs_ecs::Entity babs = ecs.CreateEntity();
+		ecs.AddComponent(babs, Identity{ "babs" });
+
+		babs_ecs::Entity bob = ecs.CreateEntity();
+		ecs.AddComponent(bob, Identity{ "bob" });
+
+		// the component is stored, but bob leaves the index rather than share babs' key
+		CHECK_THROWS_AS(ecs.Patch<Identity>(bob, [](Identity& identity) { identity.uuid = "babs"; }), const babs_ecs::DuplicateKeyException&);
+		REQUIRE(ecs.GetComponent<Identity>(bob)->uuid == "babs");
+		REQUIRE(byId.Find("babs").UUID == babs.UUID);
+		REQUIRE(byId.Find("bob").UUID == 0);
+		REQUIRE(byId.Size() == 1);
+
+		// re-indexing under the key an entity already holds isn't a duplicate
+		REQUIRE(byId.Update(babs, *ecs.GetComponent<Identity>(babs)) == babs_ecs::Status::Ok);
+
+		// once the key is free again the entity can take it
+		ecs.RemoveEntity(babs);
+		REQUIRE(byId.Update(bob, *ecs.GetComponent<Identity>(bob)) == babs_ecs::Status::Ok);
+		REQUIRE(byId.Find("babs").UUID == bob.UUID);
+
+		// duplicates that exist before an index does are reported when it's built
+		babs_ecs::Entity copy = ecs.CreateEntity();
+		CHECK_THROWS_AS(ecs.AddComponent(copy, Identity{ "babs" }), const babs_ecs::DuplicateKeyException&);
+		CHECK_THROWS_AS(UniqueIds{ ecs }, const babs_ecs::DuplicateKeyException&);
+	}
+
+	TEST_CASE("OrderedIndex answers range queries in key order")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Score>();
+
+		indexes::OrderedIndex<&Score::points> byScore(ecs);
+
+		std::vector<babs_ecs::Entity> players;
+		for (int points : { 50, 300, 120, 200, 10 })
+		{
+			players.push_back(ecs.CreateEntity());
+			ecs.AddComponent(players.back(), Score{ points });
+		}
+
+		auto ids = [](const std::vector<babs_ecs::Entity>& entities) {
+			std::vector<uint32_t> result;
+			for (const babs_ecs::Entity& e : entities)
+			{
+				result.push_back(e.UUID);
+			}
+			return result;
+		};
+
+		REQUIRE(ids(byScore.Range(100, 200)) == std::vector<uint32_t>{ players[2].UUID, players[3].UUID });
+
+		ecs.Patch<Score>(players[0], [](Score& score) { score.points = 150; });
+		REQUIRE(ids(byScore.Range(100, 200)) == std::vector<uint32_t>{ players[2].UUID, players[0].UUID, players[3].UUID });
+		REQUIRE(byScore.Find(150).UUID == players[0].UUID);
+		REQUIRE(byScore.Range(400, 500).empty());
+	}
+}
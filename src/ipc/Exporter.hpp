@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include "SharedMemory.hpp"
+#include "../ECSManager.hpp"
+#include "../Entity.hpp"
+#include "../Exceptions.hpp"
+
+namespace ipc
+{
+	// Exporter publishes a world's entity table and its components Ts into a named shared memory
+	// segment, for ipc::Reader in other processes. Every one of Ts has to be trivially copyable,
+	// since readers use the raw bytes. Components that aren't in Ts, resources and events aren't
+	// exported.
+	//
+	// Publish copies the world into whichever of the segment's two frames readers aren't being
+	// pointed at, then flips them over to it, so it never waits for readers and readers never
+	// lock anything. The segment is sized once, for a fixed entity capacity, so publishing doesn't
+	// allocate.
+	//
+	// Typical usage:
+	//   auto exporter = ipc::Exporter<Transform, Sprite>::Create("/game-world", 100'000);
+	//   ... once per frame, after the systems have run:
+	//   exporter->Publish(ecs);
+	template <typename... Ts>
+	class Exporter
+	{
+	public:
+		static_assert(sizeof...(Ts) > 0, "An export needs at least one component type");
+		static_assert((std::is_trivially_copyable_v<Ts> && ...), "Only trivially copyable components can be exported");
+		static_assert(!(babs_ecs::is_soa_v<Ts> || ...), "SoA components can't be exported");
+		static_assert(((alignof(Ts) <= exportBlock) && ...), "Exported components can't be aligned to more than 64 bytes");
+
+		// Create makes the segment called name, replacing any stale one of the same name, with
+		// room for worlds whose entity table holds up to entityCapacity entities (the highest UUID
+		// plus one). The segment is removed again when the exporter is destroyed.
+		static std::unique_ptr<Exporter> Create(const std::string& name, uint32_t entityCapacity)
+		{
+			ExportOffsets<Ts...> offsets(entityCapacity);
+			std::unique_ptr<Exporter> exporter(new Exporter(name, offsets));
+
+			if (exporter->memory.Data() == nullptr)
+			{
+				BABS_ECS_ERROR(babs_ecs::ExportException(name, "couldn't be created"), nullptr);
+			}
+
+			unsigned char* base = exporter->memory.Data();
+			ExportHeader* header = new (base) ExportHeader();
+			header->version = exportVersion;
+			header->componentCount = static_cast<uint32_t>(sizeof...(Ts));
+			header->entityCapacity = entityCapacity;
+			header->segmentSize = offsets.segmentSize;
+			header->frameSize = offsets.frameSize;
+			header->generation.store(0, std::memory_order_relaxed);
+
+			ExportLayout* layout = reinterpret_cast<ExportLayout*>(base + offsets.layout);
+			size_t i = 0;
+			((layout[i++] = ExportLayoutOf<Ts>()), ...);
+
+			for (size_t frame = 0; frame < exportFrames; ++frame)
+			{
+				new (base + offsets.firstFrame + frame * offsets.frameSize) ExportFrame();
+			}
+
+			// readers only look at the rest of the header once the magic is there
+			header->magic.store(exportMagic, std::memory_order_release);
+			return exporter;
+		}
+
+		// Publish copies the entity table, which entities are disabled and every pool in Ts into
+		// the next frame, and makes it the newest. It fails without touching the segment if the
+		// entity table has outgrown the capacity the segment was created with.
+		babs_ecs::Status Publish(babs_ecs::ECSManager& ecs)
+		{
+			size_t tableSize = ecs.entities.Size();
+			if (tableSize > this->Header()->entityCapacity)
+			{
+				BABS_ECS_ERROR(babs_ecs::ExportException(this->name, "holds " + std::to_string(this->Header()->entityCapacity) + " entities, the world has " + std::to_string(tableSize)), babs_ecs::Status::ExportFailed);
+			}
+
+			uint64_t generation = ++this->generation;
+			unsigned char* frame = this->memory.Data() + this->offsets.firstFrame + (generation % exportFrames) * this->offsets.frameSize;
+			ExportFrame* header = reinterpret_cast<ExportFrame*>(frame);
+
+			// an odd sequence tells readers still on this frame that it's being overwritten
+			header->sequence.store(2 * generation - 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			header->tableSize = static_cast<uint32_t>(tableSize);
+			ecs.entities.CopyTo(reinterpret_cast<babs_ecs::Entity*>(frame + this->offsets.entities));
+
+			// the disabled bitmap can be shorter or longer than the table, it's zero past its end
+			uint64_t* disabled = reinterpret_cast<uint64_t*>(frame + this->offsets.disabled);
+			for (size_t word = 0; word < (tableSize + 63) / 64; ++word)
+			{
+				disabled[word] = ecs.disabled.Word(word);
+			}
+
+			ExportPool* pools = reinterpret_cast<ExportPool*>(frame + this->offsets.pools);
+			size_t i = 0;
+			(this->ExportComponents<Ts>(ecs, frame, pools, i++), ...);
+
+			header->sequence.store(2 * generation, std::memory_order_release);
+			this->Header()->generation.store(generation, std::memory_order_release);
+			return babs_ecs::Status::Ok;
+		}
+
+		// Generation is the number of frames published so far.
+		uint64_t Generation() const
+		{
+			return this->generation;
+		}
+
+	private:
+		Exporter(const std::string& name, const ExportOffsets<Ts...>& offsets)
+			: name(name), offsets(offsets), memory(name, offsets.segmentSize) {}
+
+		ExportHeader* Header()
+		{
+			return reinterpret_cast<ExportHeader*>(this->memory.Data());
+		}
+
+		template <typename T>
+		void ExportComponents(babs_ecs::ECSManager& ecs, unsigned char* frame, ExportPool* pools, size_t i)
+		{
+			ExportPool& pool = pools[i];
+			pool.count = 0;
+			pool.flag = 0;
+
+			size_t componentId = babs_ecs::ECSManager::ComponentId<T>();
+			if (!ecs.ComponentIsRegistered(componentId))
+			{
+				return;
+			}
+
+			const babs_ecs::Storage<T>* container = ecs.ReadContainer<T>();
+			size_t count = container->Size();
+			uint32_t* uuids = reinterpret_cast<uint32_t*>(frame + this->offsets.uuids[i]);
+			T* data = reinterpret_cast<T*>(frame + this->offsets.data[i]);
+
+			for (size_t slot = 0; slot < count; ++slot)
+			{
+				uuids[slot] = container->EntityAt(slot).UUID;
+			}
+
+			if constexpr (babs_ecs::uses_storage_v<T, babs_ecs::dense_storage>)
+			{
+				std::memcpy(data, container->data.data(), count * sizeof(T));
+			}
+			else
+			{
+				for (size_t slot = 0; slot < count; ++slot)
+				{
+					std::memcpy(data + slot, ecs.ReadComponent<T>(babs_ecs::Entity(uuids[slot])), sizeof(T));
+				}
+			}
+
+			pool.count = count;
+			pool.flag = ecs.componentIndex[componentId];
+		}
+
+		std::string name;
+		ExportOffsets<Ts...> offsets;
+		SharedMemory memory;
+		uint64_t generation = 0;
+	};
+}
@@ -0,0 +1,224 @@
+#include "doctest.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Exporter.hpp"
+#include "Reader.hpp"
+#include "../ECSManager.hpp"
+
+#if defined(BABS_ECS_POSIX_SHM)
+#include <sys/wait.h>
+#endif
+
+namespace
+{
+	struct Position
+	{
+		float x;
+		float y;
+	};
+
+	struct Health
+	{
+		int max;
+		int current;
+	};
+
+	struct Velocity
+	{
+		float dx;
+		float dy;
+	};
+
+	std::string SegmentName(const char* name)
+	{
+#if defined(BABS_ECS_POSIX_SHM)
+		return std::string("/babs_ecs_") + name + "_" + std::to_string(::getpid());
+#else
+		return std::string("/babs_ecs_") + name;
+#endif
+	}
+}
+
+namespace babs_ecs
+{
+	template <>
+	struct component_traits<Health>
+	{
+		using storage = stable_storage;
+	};
+}
+
+#if defined(BABS_ECS_POSIX_SHM)
+TEST_SUITE("Shared memory export")
+{
+	using Export = ipc::Exporter<Position, Health>;
+	using Read = ipc::Reader<Position, Health>;
+
+	TEST_CASE("Readers see the newest frame in place")
+	{
+		std::string name = SegmentName("frames");
+		auto exporter = Export::Create(name, 64);
+		REQUIRE(exporter != nullptr);
+
+		auto reader = Read::Open(name);
+		REQUIRE(reader != nullptr);
+		REQUIRE(reader->Latest().Generation() == 0);
+		REQUIRE(reader->Latest().Pool<Position>().count == 0);
+
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		ecs.RegisterComponent<Health>();
+
+		std::vector<babs_ecs::Entity> entities;
+		for (int i = 0; i < 10; ++i)
+		{
+			entities.push_back(ecs.CreateEntity());
+			ecs.AddComponent(entities.back(), Position{ static_cast<float>(i), 0.0f });
+			if (i % 2 == 0) ecs.AddComponent(entities.back(), Health{ 10, i });
+		}
+		ecs.RemoveEntity(entities[3]);
+		ecs.SetEnabled(entities[4], false);
+
+		REQUIRE(exporter->Publish(ecs) == babs_ecs::Status::Ok);
+
+		auto frame = reader->Latest();
+		REQUIRE(frame.Generation() == 1);
+		REQUIRE(frame.TableSize() == 11);
+		REQUIRE_FALSE(frame.IsAlive(entities[3].UUID));
+		REQUIRE_FALSE(frame.IsEnabled(entities[4].UUID));
+		REQUIRE(frame.IsEnabled(entities[5].UUID));
+
+		auto positions = frame.Pool<Position>();
+		REQUIRE(positions.count == 9);
+		for (size_t i = 0; i < positions.count; ++i)
+		{
+			REQUIRE(positions.data[i].x == static_cast<float>(positions.uuids[i] - 1));
+			REQUIRE(bitfield::Has(frame.Entities()[positions.uuids[i]].bitfield, positions.flag));
+		}
+
+		auto health = frame.Pool<Health>();
+		REQUIRE(health.count == 5);
+		REQUIRE(health.data[0].current == 0);
+		REQUIRE(frame.Intact());
+
+		// the newest frame is left alone by the next publish, but not by the one after
+		REQUIRE(exporter->Publish(ecs) == babs_ecs::Status::Ok);
+		REQUIRE(frame.Intact());
+		REQUIRE(exporter->Publish(ecs) == babs_ecs::Status::Ok);
+		REQUIRE_FALSE(frame.Intact());
+		REQUIRE(reader->Latest().Generation() == 3);
+	}
+
+	TEST_CASE("Mismatched readers and worlds that don't fit are refused")
+	{
+		std::string name = SegmentName("refused");
+		auto exporter = Export::Create(name, 4);
+		REQUIRE(exporter != nullptr);
+
+		// a type the exporter doesn't have, and the right types in the wrong order
+		using Other = ipc::Reader<Position, Velocity>;
+		using Swapped = ipc::Reader<Health, Position>;
+		CHECK_THROWS_AS(Other::Open(name), const babs_ecs::ExportException&);
+		CHECK_THROWS_AS(Swapped::Open(name), const babs_ecs::ExportException&);
+		CHECK_THROWS_AS(Read::Open(SegmentName("missing")), const babs_ecs::ExportException&);
+
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		for (int i = 0; i < 4; ++i)
+		{
+			ecs.AddComponent(ecs.CreateEntity(), Position{ 1.0f, 1.0f });
+		}
+		CHECK_THROWS_AS(exporter->Publish(ecs), const babs_ecs::ExportException&);
+		REQUIRE(exporter->Generation() == 0);
+
+		// the segment goes away with the exporter
+		exporter.reset();
+		CHECK_THROWS_AS(Read::Open(name), const babs_ecs::ExportException&);
+	}
+
+	TEST_CASE("Another process reads consistent frames while the world keeps publishing")
+	{
+		std::string name = SegmentName("processes");
+		auto exporter = Export::Create(name, 1024);
+		REQUIRE(exporter != nullptr);
+
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		ecs.RegisterComponent<Health>();
+		std::vector<babs_ecs::Entity> entities;
+		for (int i = 0; i < 1000; ++i)
+		{
+			entities.push_back(ecs.CreateEntity());
+			ecs.AddComponent(entities.back(), Position{ 0.0f, 0.0f });
+		}
+
+		constexpr uint64_t wanted = 200;
+		pid_t child = ::fork();
+		REQUIRE(child >= 0);
+
+		if (child == 0)
+		{
+			// the reader process: every intact frame must have been written in one piece, with
+			// every position and the health count stamped with its generation
+			auto reader = Read::Open(name);
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+			uint64_t seen = 0;
+
+			while (reader != nullptr && seen < wanted && std::chrono::steady_clock::now() < deadline)
+			{
+				auto frame = reader->Latest();
+				auto positions = frame.Pool<Position>();
+				auto health = frame.Pool<Health>();
+
+				bool consistent = positions.count == 1000 && health.count == frame.Generation() % 1000;
+				for (size_t i = 0; consistent && i < positions.count; ++i)
+				{
+					consistent = positions.data[i].x == static_cast<float>(frame.Generation());
+				}
+
+				if (frame.Intact() && frame.Generation() > 0)
+				{
+					if (!consistent)
+					{
+						::_exit(2);
+					}
+					seen = frame.Generation();
+				}
+			}
+
+			::_exit(seen >= wanted ? 0 : 3);
+		}
+
+		// the simulation process publishes until the reader has seen enough
+		int status = -1;
+		for (uint64_t generation = 1; ::waitpid(child, &status, WNOHANG) == 0; ++generation)
+		{
+			for (const babs_ecs::Entity& e : entities)
+			{
+				ecs.GetComponent<Position>(e)->x = static_cast<float>(generation);
+			}
+
+			// add or reset health so its pool size tracks the generation too
+			size_t healthy = generation % 1000;
+			if (healthy == 0)
+			{
+				ecs.Clear<Health>();
+			}
+			else
+			{
+				ecs.AddComponent(entities[healthy - 1], Health{ 1, 1 });
+			}
+
+			REQUIRE(exporter->Publish(ecs) == babs_ecs::Status::Ok);
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+
+		REQUIRE(WIFEXITED(status));
+		REQUIRE(WEXITSTATUS(status) == 0);
+	}
+}
+#endif
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "SharedMemory.hpp"
+#include "../Entity.hpp"
+#include "../Exceptions.hpp"
+
+namespace ipc
+{
+	// ExportIndex is the position of T in Ts.
+	template <typename T, typename... Ts>
+	constexpr size_t ExportIndex()
+	{
+		size_t index = 0;
+		size_t found = sizeof...(Ts);
+		((found = std::is_same_v<T, Ts> && found == sizeof...(Ts) ? index : found, ++index), ...);
+		return found;
+	}
+
+	// SharedPool is one exported component pool: count components with the UUIDs of their
+	// entities alongside, in the world's pool order. flag is the component's bit in the exported
+	// entities' signatures, 0 if the world hadn't registered the component.
+	template <typename T>
+	struct SharedPool
+	{
+		const uint32_t* uuids = nullptr;
+		const T* data = nullptr;
+		size_t count = 0;
+		bitfield::Bitfield flag = 0;
+	};
+
+	// SharedFrame is one published state of the world, read in place from the shared segment.
+	// Nothing is copied, so the writer may start overwriting the frame once it has published the
+	// next one. Check Intact after reading, and drop whatever was read if it returns false.
+	template <typename... Ts>
+	class SharedFrame
+	{
+	public:
+		SharedFrame() = default;
+
+		SharedFrame(const unsigned char* frame, const ExportOffsets<Ts...>* offsets, uint64_t generation)
+			: frame(frame), offsets(offsets), generation(generation) {}
+
+		// Generation counts the frames published before and including this one, 0 means nothing
+		// has been published yet and the frame is empty.
+		uint64_t Generation() const
+		{
+			return this->generation;
+		}
+
+		// TableSize is the size of the entity table, the highest UUID plus one.
+		size_t TableSize() const
+		{
+			return this->frame != nullptr ? this->Header()->tableSize : 0;
+		}
+
+		// Entities is the entity table, indexed by UUID. Removed entities have UUID 0.
+		const babs_ecs::Entity* Entities() const
+		{
+			return this->frame != nullptr ? reinterpret_cast<const babs_ecs::Entity*>(this->frame + this->offsets->entities) : nullptr;
+		}
+
+		bool IsAlive(uint32_t uuid) const
+		{
+			return uuid != 0 && uuid < this->TableSize() && this->Entities()[uuid].UUID == uuid;
+		}
+
+		// IsEnabled is false for entities that don't exist, or were turned off with SetEnabled.
+		bool IsEnabled(uint32_t uuid) const
+		{
+			if (!this->IsAlive(uuid))
+			{
+				return false;
+			}
+
+			const uint64_t* disabled = reinterpret_cast<const uint64_t*>(this->frame + this->offsets->disabled);
+			return (disabled[uuid / 64] >> (uuid % 64) & 1) == 0;
+		}
+
+		template <typename T>
+		SharedPool<T> Pool() const
+		{
+			constexpr size_t index = ExportIndex<T, Ts...>();
+			static_assert(index < sizeof...(Ts), "The component isn't part of this export");
+
+			SharedPool<T> pool;
+			if (this->frame != nullptr)
+			{
+				const ExportPool& exported = reinterpret_cast<const ExportPool*>(this->frame + this->offsets->pools)[index];
+				pool.uuids = reinterpret_cast<const uint32_t*>(this->frame + this->offsets->uuids[index]);
+				pool.data = reinterpret_cast<const T*>(this->frame + this->offsets->data[index]);
+				pool.count = static_cast<size_t>(exported.count);
+				pool.flag = exported.flag;
+			}
+
+			return pool;
+		}
+
+		// Intact is true as long as the writer hasn't started reusing the frame, so everything read
+		// from it so far is consistent.
+		bool Intact() const
+		{
+			if (this->frame == nullptr)
+			{
+				return true;
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return this->Header()->sequence.load(std::memory_order_relaxed) == 2 * this->generation;
+		}
+
+	private:
+		const ExportFrame* Header() const
+		{
+			return reinterpret_cast<const ExportFrame*>(this->frame);
+		}
+
+		const unsigned char* frame = nullptr;
+		const ExportOffsets<Ts...>* offsets = nullptr;
+		uint64_t generation = 0;
+	};
+
+	// Reader maps a segment published by ipc::Exporter<Ts...> in another process. It only
+	// depends on the entity and component types, not on ECSManager, so tools can read the world
+	// without linking the simulation. Ts have to be listed in the same order as the exporter's.
+	//
+	// Typical usage, in the renderer:
+	//   auto world = ipc::Reader<Transform, Sprite>::Open("/game-world");
+	//   auto frame = world->Latest();
+	//   auto sprites = frame.Pool<Sprite>();
+	//   for (size_t i = 0; i < sprites.count; ++i) Draw(sprites.uuids[i], sprites.data[i]);
+	//   if (!frame.Intact()) { ... the frame was overwritten while drawing, skip presenting it }
+	template <typename... Ts>
+	class Reader
+	{
+	public:
+		static_assert(sizeof...(Ts) > 0, "An export needs at least one component type");
+
+		// Open maps the segment called name. It fails if the segment doesn't exist yet, or was
+		// created by an exporter of different component types.
+		static std::unique_ptr<Reader> Open(const std::string& name)
+		{
+			std::unique_ptr<Reader> reader(new Reader(name));
+			const unsigned char* base = reader->memory.Data();
+
+			if (base == nullptr || reader->memory.Size() < sizeof(ExportHeader))
+			{
+				BABS_ECS_ERROR(babs_ecs::ExportException(name, "can't be opened"), nullptr);
+			}
+
+			const ExportHeader* header = reinterpret_cast<const ExportHeader*>(base);
+			if (header->magic.load(std::memory_order_acquire) != exportMagic)
+			{
+				BABS_ECS_ERROR(babs_ecs::ExportException(name, "isn't an export segment"), nullptr);
+			}
+
+			if (header->version != exportVersion)
+			{
+				BABS_ECS_ERROR(babs_ecs::ExportException(name, "was written by export format version " + std::to_string(header->version)), nullptr);
+			}
+
+			reader->offsets.reset(new ExportOffsets<Ts...>(header->entityCapacity));
+			if (header->segmentSize != reader->memory.Size() || header->segmentSize != reader->offsets->segmentSize || header->frameSize != reader->offsets->frameSize)
+			{
+				BABS_ECS_ERROR(babs_ecs::ExportException(name, "is truncated"), nullptr);
+			}
+
+			ExportLayout expected[sizeof...(Ts)] = { ExportLayoutOf<Ts>()... };
+			if (header->componentCount != sizeof...(Ts) || std::memcmp(base + reader->offsets->layout, expected, sizeof(expected)) != 0)
+			{
+				BABS_ECS_ERROR(babs_ecs::ExportException(name, "was exported with different component types"), nullptr);
+			}
+
+			return reader;
+		}
+
+		// Latest returns the newest complete frame, without waiting and without copying it.
+		SharedFrame<Ts...> Latest() const
+		{
+			const ExportHeader* header = reinterpret_cast<const ExportHeader*>(this->memory.Data());
+
+			while (true)
+			{
+				uint64_t generation = header->generation.load(std::memory_order_acquire);
+				if (generation == 0)
+				{
+					return SharedFrame<Ts...>();
+				}
+
+				const unsigned char* frame = this->memory.Data() + this->offsets->firstFrame + (generation % exportFrames) * this->offsets->frameSize;
+				if (reinterpret_cast<const ExportFrame*>(frame)->sequence.load(std::memory_order_acquire) == 2 * generation)
+				{
+					return SharedFrame<Ts...>(frame, this->offsets.get(), generation);
+				}
+
+				// the writer published twice more since the generation was read, look again
+			}
+		}
+
+	private:
+		explicit Reader(const std::string& name) : memory(name) {}
+
+		SharedMemory memory;
+		std::unique_ptr<ExportOffsets<Ts...>> offsets;
+	};
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <typeinfo>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BABS_ECS_POSIX_SHM 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../Entity.hpp"
+#include "../Hash.hpp"
+
+// The ipc namespace publishes world state into shared memory, so tools running as separate
+// processes on the same machine (renderers, debuggers, analytics) can read it in place instead
+// of having it serialized to them every frame.
+namespace ipc
+{
+	// An export segment is written in native byte order, with every block on a 64 byte boundary:
+	//
+	//   header   uint32 magic "BABX", uint32 version, uint32 component count, uint32 entity
+	//            capacity, uint64 segment size, uint64 frame size, uint64 newest generation
+	//   layout   per component: uint32 sizeof, uint32 alignof, uint64 hash of the type's name
+	//   frames   two of them, frame size bytes each
+	//
+	// and each frame is:
+	//
+	//   header   uint64 sequence, uint32 entity table size, uint32 0
+	//   pools    per component: uint64 count, uint32 signature flag, uint32 0
+	//   entities entity capacity Entity slots, indexed by UUID, removed entities have UUID 0
+	//   disabled one bit per UUID, set for entities turned off with SetEnabled
+	//   per component: entity capacity uint32 UUIDs | entity capacity raw components
+	//
+	// Generation g is written into frame g % 2. Its sequence is 2g - 1 while it's being written
+	// and 2g once it's complete, and the header's generation is bumped to g after that. Readers
+	// read a frame in place and then check that its sequence hasn't moved, like a seqlock, but
+	// with two frames the writer never touches the newest one, so a reader has a whole publish
+	// interval to finish before its frame is reused.
+	constexpr uint32_t exportMagic = 0x58424142; // "BABX" in little endian
+	constexpr uint32_t exportVersion = 1;
+	constexpr size_t exportBlock = 64;
+	constexpr size_t exportFrames = 2;
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory exports need lock-free 64 bit atomics");
+
+	struct ExportHeader
+	{
+		std::atomic<uint32_t> magic;
+		uint32_t version;
+		uint32_t componentCount;
+		uint32_t entityCapacity;
+		uint64_t segmentSize;
+		uint64_t frameSize;
+		std::atomic<uint64_t> generation;
+	};
+
+	struct ExportLayout
+	{
+		uint32_t size;
+		uint32_t alignment;
+		uint64_t name;
+	};
+
+	struct ExportFrame
+	{
+		std::atomic<uint64_t> sequence;
+		uint32_t tableSize;
+		uint32_t unused;
+	};
+
+	struct ExportPool
+	{
+		uint64_t count;
+		uint32_t flag;
+		uint32_t unused;
+	};
+
+	inline size_t ExportPadded(size_t offset)
+	{
+		return (offset + exportBlock - 1) / exportBlock * exportBlock;
+	}
+
+	// ExportLayoutOf describes T, so both sides can check they agree on the component types.
+	template <typename T>
+	inline ExportLayout ExportLayoutOf()
+	{
+		return ExportLayout{ static_cast<uint32_t>(sizeof(T)), static_cast<uint32_t>(alignof(T)), babs_ecs::HashBytes(typeid(T).name(), std::strlen(typeid(T).name()), 0) };
+	}
+
+	// ExportOffsets finds every block of a segment exporting Ts with room for capacity entities.
+	// Pool offsets are relative to the start of the frame.
+	template <typename... Ts>
+	struct ExportOffsets
+	{
+		explicit ExportOffsets(uint32_t capacity)
+		{
+			this->layout = ExportPadded(sizeof(ExportHeader));
+			this->firstFrame = ExportPadded(this->layout + sizeof...(Ts) * sizeof(ExportLayout));
+
+			this->pools = ExportPadded(sizeof(ExportFrame));
+			this->entities = ExportPadded(this->pools + sizeof...(Ts) * sizeof(ExportPool));
+			this->disabled = ExportPadded(this->entities + size_t(capacity) * sizeof(babs_ecs::Entity));
+
+			size_t offset = ExportPadded(this->disabled + (size_t(capacity) + 63) / 64 * sizeof(uint64_t));
+			size_t i = 0;
+			((this->uuids[i] = offset, offset = ExportPadded(offset + size_t(capacity) * sizeof(uint32_t)),
+			  this->data[i++] = offset, offset = ExportPadded(offset + size_t(capacity) * sizeof(Ts))), ...);
+
+			this->frameSize = offset;
+			this->segmentSize = this->firstFrame + exportFrames * this->frameSize;
+		}
+
+		size_t layout;
+		size_t firstFrame;
+		size_t frameSize;
+		size_t segmentSize;
+
+		size_t pools;
+		size_t entities;
+		size_t disabled;
+		size_t uuids[sizeof...(Ts)];
+		size_t data[sizeof...(Ts)];
+	};
+
+	// SharedMemory maps a named POSIX shared memory segment. The creating side owns the name and
+	// removes it again when it goes away, mappings that other processes already have stay valid.
+	class SharedMemory
+	{
+	public:
+		// SharedMemory(name, size) replaces any segment called name with a new zero filled one and
+		// maps it read-write. name should start with a slash, like "/game-world".
+		SharedMemory(const std::string& name, size_t size) : name(name), owner(true)
+		{
+#if defined(BABS_ECS_POSIX_SHM)
+			// a segment left behind by a crashed exporter is replaced rather than reused
+			::shm_unlink(name.c_str());
+
+			int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+			if (fd < 0)
+			{
+				return;
+			}
+
+			if (::ftruncate(fd, static_cast<off_t>(size)) == 0)
+			{
+				void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+				if (mapped != MAP_FAILED)
+				{
+					this->data = static_cast<unsigned char*>(mapped);
+					this->size = size;
+				}
+			}
+
+			::close(fd);
+			if (this->data == nullptr)
+			{
+				::shm_unlink(name.c_str());
+			}
+#endif
+		}
+
+		// SharedMemory(name) maps an existing segment read-only.
+		explicit SharedMemory(const std::string& name) : name(name), owner(false)
+		{
+#if defined(BABS_ECS_POSIX_SHM)
+			int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+			if (fd < 0)
+			{
+				return;
+			}
+
+			struct stat info;
+			if (::fstat(fd, &info) == 0 && info.st_size > 0)
+			{
+				void* mapped = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+				if (mapped != MAP_FAILED)
+				{
+					this->data = static_cast<unsigned char*>(mapped);
+					this->size = static_cast<size_t>(info.st_size);
+				}
+			}
+
+			::close(fd);
+#endif
+		}
+
+		SharedMemory(const SharedMemory&) = delete;
+		SharedMemory& operator=(const SharedMemory&) = delete;
+
+		~SharedMemory()
+		{
+#if defined(BABS_ECS_POSIX_SHM)
+			if (this->data != nullptr)
+			{
+				::munmap(this->data, this->size);
+				if (this->owner)
+				{
+					::shm_unlink(this->name.c_str());
+				}
+			}
+#endif
+		}
+
+		// Data returns the start of the segment, which is page aligned, or nullptr if it couldn't
+		// be created or opened (always, on platforms without POSIX shared memory).
+		unsigned char* Data() const
+		{
+			return this->data;
+		}
+
+		size_t Size() const
+		{
+			return this->size;
+		}
+
+	private:
+		std::string name;
+		bool owner;
+		unsigned char* data = nullptr;
+		size_t size = 0;
+	};
+}
@@ -0,0 +1,506 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BABS_ECS_POSIX_FILES 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../ECSManager.hpp"
+#include "../Entity.hpp"
+#include "../Exceptions.hpp"
+#include "../Hash.hpp"
+#include "../Layout.hpp"
+
+// The persistence namespace checkpoints whole worlds to files that can be mapped straight back
+// in, so a restarted process doesn't have to rebuild its world entity by entity.
+namespace persistence
+{
+	// Snapshot files are written in native byte order. Every block starts on a 64 byte boundary,
+	// so components can be used in place from a mapping of the file:
+	//
+	//   header      "BABW", uint32 version, uint32 component count, uint32 entity table size,
+	//               uint32 free id count, uint32 disabled id count, uint64 file size
+	//   layout      per component: uint32 sizeof, uint32 alignof, uint64 hash of the type's name
+	//   free ids    the ids waiting to be reused, in the order they will be handed out
+	//   disabled    the ids of the entities turned off with SetEnabled, in ascending order
+	//   components  per component: uint64 count | count uint32 UUIDs | count raw components
+	//
+	// The entity table size counts the dummy entity 0, and every other id below it that isn't
+	// free is alive. Components are matched by their position in the Ts list, and the layout
+	// block catches components that were renamed or changed size or alignment. Type names come
+	// from the compiler, so snapshots only move between builds made with the same compiler.
+	constexpr char snapshotMagic[4] = { 'B', 'A', 'B', 'W' };
+	constexpr uint32_t snapshotVersion = 2;
+	constexpr size_t snapshotBlock = 64;
+
+	struct SnapshotHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t componentCount;
+		uint32_t tableSize;
+		uint32_t freeCount;
+		uint32_t disabledCount;
+		uint64_t fileSize;
+	};
+
+	struct SnapshotLayout
+	{
+		uint32_t size;
+		uint32_t alignment;
+		uint64_t name;
+	};
+
+	// MappedFile maps a whole file read-only, straight out of the page cache. Where mmap isn't
+	// available the file is read into memory instead.
+	class MappedFile
+	{
+	public:
+		explicit MappedFile(const std::string& path)
+		{
+#if defined(BABS_ECS_POSIX_FILES)
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+			{
+				return;
+			}
+
+			struct stat info;
+			if (::fstat(fd, &info) == 0 && info.st_size > 0)
+			{
+				// pages are faulted in as restoring reaches them, front to back, so read ahead of it
+				void* mapped = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				if (mapped != MAP_FAILED)
+				{
+					::posix_madvise(mapped, static_cast<size_t>(info.st_size), POSIX_MADV_SEQUENTIAL);
+					this->data = static_cast<const unsigned char*>(mapped);
+					this->size = static_cast<size_t>(info.st_size);
+				}
+			}
+
+			::close(fd);
+#else
+			std::FILE* file = std::fopen(path.c_str(), "rb");
+			if (file == nullptr)
+			{
+				return;
+			}
+
+			if (std::fseek(file, 0, SEEK_END) == 0)
+			{
+				long length = std::ftell(file);
+				if (length > 0 && std::fseek(file, 0, SEEK_SET) == 0)
+				{
+					this->buffer.resize(static_cast<size_t>(length));
+					if (std::fread(this->buffer.data(), 1, this->buffer.size(), file) == this->buffer.size())
+					{
+						this->data = this->buffer.data();
+						this->size = this->buffer.size();
+					}
+				}
+			}
+
+			std::fclose(file);
+#endif
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile()
+		{
+#if defined(BABS_ECS_POSIX_FILES)
+			if (this->data != nullptr)
+			{
+				::munmap(const_cast<unsigned char*>(this->data), this->size);
+			}
+#endif
+		}
+
+		// Data returns the start of the file, which is aligned to at least 64 bytes, or nullptr
+		// if it couldn't be opened or is empty.
+		const unsigned char* Data() const
+		{
+			return this->data;
+		}
+
+		size_t Size() const
+		{
+			return this->size;
+		}
+
+	private:
+		const unsigned char* data = nullptr;
+		size_t size = 0;
+#if !defined(BABS_ECS_POSIX_FILES)
+		babs_ecs::AlignedVector<unsigned char> buffer;
+#endif
+	};
+
+	// Snapshot checkpoints a world's entities and their components Ts to a file, and restores
+	// them into a new world after a restart. Every one of Ts has to be trivially copyable, since
+	// they're stored as raw bytes. Components that aren't in Ts aren't saved, and neither are
+	// resources, groups, collectors or event subscribers.
+	//
+	// Unlike streaming::Partition, a snapshot keeps entity ids, the free list and the order of
+	// every pool, so components that refer to other entities stay valid without remapping. That
+	// includes Relationship, so listing it in Ts saves the hierarchy too.
+	//
+	// Typical usage:
+	//   using Save = persistence::Snapshot<Position, Velocity, Health>;
+	//   Save::Checkpoint(ecs, "world.snapshot");   // every few minutes, and at shutdown
+	//   ... after a restart:
+	//   babs_ecs::ECSManager ecs;
+	//   Save::Restore(ecs, "world.snapshot");
+	template <typename... Ts>
+	class Snapshot
+	{
+	public:
+		static_assert(sizeof...(Ts) > 0, "A snapshot needs at least one component type");
+		static_assert((std::is_trivially_copyable_v<Ts> && ...), "Snapshots can only store trivially copyable components");
+		static_assert(!(babs_ecs::is_soa_v<Ts> || ...), "SoA components can't be stored in a snapshot");
+		static_assert(((alignof(Ts) <= snapshotBlock) && ...), "Snapshot components can't be aligned to more than 64 bytes");
+
+		// Checkpoint writes the world to the file at path. The new file is written and flushed to
+		// disk next to the old one, and then renamed over it, so a crash at any point leaves
+		// either the previous checkpoint or the new one, never a mix. Entities that have been
+		// reserved but not created yet aren't part of the checkpoint.
+		static babs_ecs::Status Checkpoint(babs_ecs::ECSManager& ecs, const std::string& path)
+		{
+			std::string temporary = path + ".tmp";
+			std::FILE* file = std::fopen(temporary.c_str(), "wb");
+			if (file == nullptr)
+			{
+				BABS_ECS_ERROR(babs_ecs::SnapshotException(temporary, "can't be opened for writing"), babs_ecs::Status::SnapshotFailed);
+			}
+
+			SnapshotHeader header = {};
+			std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+			header.version = snapshotVersion;
+			header.componentCount = static_cast<uint32_t>(sizeof...(Ts));
+			header.tableSize = static_cast<uint32_t>(ecs.entities.Size());
+			header.freeCount = static_cast<uint32_t>(ecs.unusedEntityIndices.size());
+
+			std::vector<uint32_t> disabled;
+			disabled.reserve(ecs.disabledCount);
+			for (size_t word = 0; word < ecs.disabled.WordCount(); ++word)
+			{
+				for (uint64_t bits = ecs.disabled.Word(word); bits != 0; bits &= bits - 1)
+				{
+					disabled.push_back(static_cast<uint32_t>(word * 64 + babs_ecs::LowestBit(bits)));
+				}
+			}
+			header.disabledCount = static_cast<uint32_t>(disabled.size());
+
+			SnapshotLayout layout[sizeof...(Ts)];
+			Layout(layout);
+
+			Writer writer{ file };
+			writer.Write(&header, sizeof(header));
+			writer.Write(layout, sizeof(layout));
+			writer.Pad();
+			writer.Write(ecs.unusedEntityIndices.data(), ecs.unusedEntityIndices.size() * sizeof(uint32_t));
+			writer.Pad();
+			writer.Write(disabled.data(), disabled.size() * sizeof(uint32_t));
+			writer.Pad();
+			(SaveComponents<Ts>(ecs, writer), ...);
+
+			// the header goes in again once the size is known
+			header.fileSize = writer.offset;
+			bool written = writer.ok && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+			written = std::fflush(file) == 0 && Sync(file) && written;
+			written = std::fclose(file) == 0 && written;
+
+			if (!written || !Replace(temporary, path))
+			{
+				std::remove(temporary.c_str());
+				BABS_ECS_ERROR(babs_ecs::SnapshotException(path, "couldn't be written"), babs_ecs::Status::SnapshotFailed);
+			}
+
+			return babs_ecs::Status::Ok;
+		}
+
+		// Restore maps the file at path and rebuilds the checkpointed world in ecs, which must not
+		// have had any entities yet. Ts are registered if they aren't already. Each dense pool is
+		// copied out of the mapping as one block, so nothing is parsed or added entity by entity,
+		// and a single EntitiesCreated event announces every restored entity.
+		//
+		// The whole file is checked before ecs is touched, so a failed restore leaves it empty.
+		static babs_ecs::Status Restore(babs_ecs::ECSManager& ecs, const std::string& path)
+		{
+			if (!ecs.IsPristine())
+			{
+				BABS_ECS_ERROR(babs_ecs::SnapshotException(path, "can only be restored into a world without entities"), babs_ecs::Status::SnapshotFailed);
+			}
+
+			MappedFile file(path);
+			if (file.Data() == nullptr)
+			{
+				BABS_ECS_ERROR(babs_ecs::SnapshotException(path, "can't be opened for reading"), babs_ecs::Status::SnapshotFailed);
+			}
+
+			SnapshotHeader header;
+			if (file.Size() < sizeof(header) || std::memcmp(file.Data(), snapshotMagic, sizeof(snapshotMagic)) != 0)
+			{
+				BABS_ECS_ERROR(babs_ecs::SnapshotException(path, "isn't a snapshot file"), babs_ecs::Status::SnapshotFailed);
+			}
+			std::memcpy(&header, file.Data(), sizeof(header));
+
+			if (header.version != snapshotVersion)
+			{
+				BABS_ECS_ERROR(babs_ecs::SnapshotException(path, "was written by snapshot format version " + std::to_string(header.version)), babs_ecs::Status::SnapshotFailed);
+			}
+
+			if (header.fileSize != file.Size())
+			{
+				BABS_ECS_ERROR(babs_ecs::SnapshotException(path, "is truncated"), babs_ecs::Status::SnapshotFailed);
+			}
+
+			SnapshotLayout expected[sizeof...(Ts)];
+			Layout(expected);
+			if (header.componentCount != sizeof...(Ts) || file.Size() < sizeof(header) + sizeof(expected) || std::memcmp(file.Data() + sizeof(header), expected, sizeof(expected)) != 0)
+			{
+				BABS_ECS_ERROR(babs_ecs::SnapshotException(path, "was saved with different component types"), babs_ecs::Status::SnapshotFailed);
+			}
+
+			// find every block and check the ids in it before the world is changed
+			Reader reader{ file.Data(), file.Size(), Padded(sizeof(header) + sizeof(expected)) };
+			std::vector<bool> live(header.tableSize, true);
+			const uint32_t* freeIds = reader.Take<uint32_t>(header.freeCount);
+			bool valid = header.tableSize > 0 && freeIds != nullptr;
+
+			for (uint32_t i = 0; valid && i < header.freeCount; ++i)
+			{
+				// each free id has to be a real id, listed once
+				valid = freeIds[i] != 0 && freeIds[i] < header.tableSize && live[freeIds[i]];
+				if (valid)
+				{
+					live[freeIds[i]] = false;
+				}
+			}
+
+			// disabled ids have to be alive, and ascending so none is listed twice
+			const uint32_t* disabledIds = reader.Take<uint32_t>(header.disabledCount);
+			valid = valid && disabledIds != nullptr;
+			for (uint32_t i = 0; valid && i < header.disabledCount; ++i)
+			{
+				valid = disabledIds[i] != 0 && disabledIds[i] < header.tableSize && live[disabledIds[i]] && (i == 0 || disabledIds[i - 1] < disabledIds[i]);
+			}
+
+			// owner remembers which block last listed each id, to catch an entity listed twice in one
+			std::vector<uint32_t> owner(valid ? header.tableSize : 0, 0);
+			uint32_t index = 0;
+
+			std::tuple<Block<Ts>...> blocks;
+			std::apply([&](auto&... block) {
+				((valid = valid && Find(reader, block, live, owner, ++index)), ...);
+			}, blocks);
+
+			if (!valid)
+			{
+				BABS_ECS_ERROR(babs_ecs::SnapshotException(path, "is corrupt"), babs_ecs::Status::SnapshotFailed);
+			}
+
+			babs_ecs::Status registered = babs_ecs::Status::Ok;
+			((registered = registered == babs_ecs::Status::Ok ? ecs.RegisterComponent<Ts>() : registered), ...);
+			if (registered != babs_ecs::Status::Ok)
+			{
+				return registered;
+			}
+
+			ecs.RestoreEntities(header.tableSize, freeIds, header.freeCount, disabledIds, header.disabledCount);
+			std::apply([&](auto&... block) {
+				(ecs.RestoreComponents(block.uuids, block.data, block.count), ...);
+			}, blocks);
+			ecs.FinishRestore();
+
+			return babs_ecs::Status::Ok;
+		}
+
+	private:
+		template <typename T>
+		struct Block
+		{
+			const uint32_t* uuids = nullptr;
+			const T* data = nullptr;
+			size_t count = 0;
+		};
+
+		struct Writer
+		{
+			std::FILE* file;
+			uint64_t offset = 0;
+			bool ok = true;
+
+			void Write(const void* bytes, size_t size)
+			{
+				if (size > 0 && std::fwrite(bytes, 1, size, this->file) != size)
+				{
+					this->ok = false;
+				}
+
+				this->offset += size;
+			}
+
+			// Pad zero fills up to the start of the next block
+			void Pad()
+			{
+				static const unsigned char zeros[snapshotBlock] = {};
+				this->Write(zeros, static_cast<size_t>((snapshotBlock - this->offset % snapshotBlock) % snapshotBlock));
+			}
+		};
+
+		struct Reader
+		{
+			const unsigned char* data;
+			size_t size;
+			size_t offset;
+
+			// Take returns the next block of count Ts, or nullptr if the file is too short for it
+			template <typename T>
+			const T* Take(uint64_t count)
+			{
+				if (this->offset > this->size || count > (this->size - this->offset) / sizeof(T))
+				{
+					return nullptr;
+				}
+
+				const T* taken = reinterpret_cast<const T*>(this->data + this->offset);
+				this->offset = Padded(this->offset + static_cast<size_t>(count) * sizeof(T));
+				return taken;
+			}
+		};
+
+		static size_t Padded(size_t offset)
+		{
+			return (offset + snapshotBlock - 1) / snapshotBlock * snapshotBlock;
+		}
+
+		// Layout fills in the size, alignment and name of each of Ts
+		static void Layout(SnapshotLayout* layout)
+		{
+			size_t i = 0;
+			((layout[i++] = SnapshotLayout{ static_cast<uint32_t>(sizeof(Ts)), static_cast<uint32_t>(alignof(Ts)), babs_ecs::HashBytes(typeid(Ts).name(), std::strlen(typeid(Ts).name()), 0) }), ...);
+		}
+
+		template <typename T>
+		static void SaveComponents(babs_ecs::ECSManager& ecs, Writer& writer)
+		{
+			uint64_t count = 0;
+			if (!ecs.ComponentIsRegistered(babs_ecs::ECSManager::ComponentId<T>()))
+			{
+				writer.Write(&count, sizeof(count));
+				writer.Pad();
+				return;
+			}
+
+			const babs_ecs::Storage<T>* container = ecs.ReadContainer<T>();
+			count = container->Size();
+
+			std::vector<uint32_t> uuids(static_cast<size_t>(count));
+			for (size_t i = 0; i < uuids.size(); ++i)
+			{
+				uuids[i] = container->EntityAt(i).UUID;
+			}
+
+			writer.Write(&count, sizeof(count));
+			writer.Pad();
+			writer.Write(uuids.data(), uuids.size() * sizeof(uint32_t));
+			writer.Pad();
+
+			if constexpr (babs_ecs::uses_storage_v<T, babs_ecs::dense_storage>)
+			{
+				writer.Write(container->data.data(), uuids.size() * sizeof(T));
+			}
+			else
+			{
+				for (uint32_t uuid : uuids)
+				{
+					writer.Write(ecs.ReadComponent<T>(babs_ecs::Entity(uuid)), sizeof(T));
+				}
+			}
+			writer.Pad();
+		}
+
+		// Find locates one component's block and checks that it only lists live entities, each of
+		// them once. index is the block's position in Ts, counting from 1.
+		template <typename T>
+		static bool Find(Reader& reader, Block<T>& block, const std::vector<bool>& live, std::vector<uint32_t>& owner, uint32_t index)
+		{
+			const uint64_t* count = reader.Take<uint64_t>(1);
+			if (count == nullptr || *count > live.size())
+			{
+				return false;
+			}
+
+			block.count = static_cast<size_t>(*count);
+			block.uuids = reader.Take<uint32_t>(block.count);
+			block.data = reader.Take<T>(block.count);
+			if (block.uuids == nullptr || block.data == nullptr)
+			{
+				return false;
+			}
+
+			return std::all_of(block.uuids, block.uuids + block.count, [&](uint32_t uuid) {
+				if (uuid == 0 || uuid >= live.size() || !live[uuid] || owner[uuid] == index)
+				{
+					return false;
+				}
+
+				owner[uuid] = index;
+				return true;
+			});
+		}
+
+		// Sync flushes the file's data through to the disk
+		static bool Sync(std::FILE* file)
+		{
+#if defined(BABS_ECS_POSIX_FILES)
+			return ::fsync(::fileno(file)) == 0;
+#else
+			return file != nullptr;
+#endif
+		}
+
+		// Replace renames from over to. On POSIX systems the rename is atomic, and the directory is
+		// synced so the rename survives a crash too. Elsewhere rename can't replace an existing
+		// file, so the old one is removed first.
+		static bool Replace(const std::string& from, const std::string& to)
+		{
+#if defined(BABS_ECS_POSIX_FILES)
+			if (std::rename(from.c_str(), to.c_str()) != 0)
+			{
+				return false;
+			}
+
+			size_t slash = to.find_last_of('/');
+			std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : to.substr(0, slash);
+			int fd = ::open(directory.c_str(), O_RDONLY);
+			if (fd >= 0)
+			{
+				::fsync(fd);
+				::close(fd);
+			}
+
+			return true;
+#else
+			std::remove(to.c_str());
+			return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+		}
+	};
+}
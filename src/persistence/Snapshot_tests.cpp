@@ -0,0 +1,185 @@
+#include "doctest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "Snapshot.hpp"
+#include "../ECSManager.hpp"
+
+namespace
+{
+	struct Position
+	{
+		float x;
+		float y;
+	};
+
+	struct Health
+	{
+		int max;
+		int current;
+	};
+
+	struct Asleep {};
+
+	std::string TempPath(const char* name)
+	{
+		return std::string("babs_ecs_snapshot_") + name + ".bin";
+	}
+
+	bool Exists(const std::string& path)
+	{
+		return static_cast<bool>(std::ifstream(path));
+	}
+}
+
+namespace babs_ecs
+{
+	template <>
+	struct component_traits<Asleep>
+	{
+		using storage = tag_storage;
+	};
+
+	template <>
+	struct component_hash<Position> : hash_members<&Position::x, &Position::y> {};
+}
+
+TEST_SUITE("Snapshots")
+{
+	using Save = persistence::Snapshot<Position, Health, Asleep, babs_ecs::Relationship>;
+
+	TEST_CASE("A restored world picks up exactly where the checkpoint left off")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Health>();
+		ecs.RegisterComponent<Asleep>();
+		ecs.RegisterComponent<Position>();
+
+		std::vector<babs_ecs::Entity> entities;
+		for (int i = 0; i < 10; ++i)
+		{
+			entities.push_back(ecs.CreateEntity());
+			ecs.AddComponent(entities.back(), Position{ static_cast<float>(i), 1.0f });
+			if (i % 3 == 0) ecs.AddComponent(entities.back(), Health{ 10, i });
+			if (i % 4 == 0) ecs.AddComponent(entities.back(), Asleep{});
+		}
+		ecs.SetParent(entities[5], entities[4]);
+		ecs.RemoveEntity(entities[2]);
+		ecs.RemoveEntity(entities[7]);
+		ecs.SetEnabled(entities[9], false);
+
+		std::string path = TempPath("restore");
+		REQUIRE(Save::Checkpoint(ecs, path) == babs_ecs::Status::Ok);
+		REQUIRE_FALSE(Exists(path + ".tmp"));
+
+		// Restore registers Relationship, the hash needs the same registration order on both sides
+		babs_ecs::ECSManager restored;
+		restored.RegisterComponent<Health>();
+		restored.RegisterComponent<Asleep>();
+		restored.RegisterComponent<Position>();
+
+		// collectors and groups that exist before the restore see the restored entities
+		auto& sleepers = restored.Collect<Health, Asleep>();
+		auto& grouped = restored.Group<Health, Position>();
+
+		size_t announced = 0;
+		restored.events.Subscribe<babs_ecs::EntitiesCreated>([&](const babs_ecs::EntitiesCreated& e) {
+			announced += e.entities.size();
+		});
+
+		REQUIRE(Save::Restore(restored, path) == babs_ecs::Status::Ok);
+		REQUIRE(announced == 8);
+		REQUIRE(restored.Hash() == ecs.Hash());
+
+		REQUIRE_FALSE(restored.IsAlive(entities[2]));
+		REQUIRE(restored.GetComponent<Position>(entities[9])->x == 9.0f);
+		REQUIRE(restored.GetComponent<Health>(entities[6])->current == 6);
+		REQUIRE(restored.EntitiesWith<Position, Asleep>().size() == 3);
+		REQUIRE(restored.GetParent(entities[5]) == entities[4]);
+		REQUIRE_FALSE(restored.IsEnabled(entities[9]));
+		REQUIRE(restored.EntitiesWith<Position>().size() == 7);
+		REQUIRE(sleepers.Entered() == std::vector<babs_ecs::Entity>{ entities[0] });
+		REQUIRE(grouped.Size() == 4);
+
+		// the pools keep their order, and freed ids are reused in the same order
+		REQUIRE(restored.GetComponentArray<Position>().entities[0] == ecs.GetComponentArray<Position>().entities[0]);
+		REQUIRE(restored.CreateEntity() == ecs.CreateEntity());
+		REQUIRE(restored.CreateEntity() == ecs.CreateEntity());
+		REQUIRE(restored.CreateEntity() == ecs.CreateEntity());
+
+		std::remove(path.c_str());
+	}
+
+	TEST_CASE("Restoring reports missing, mismatched and damaged files")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		ecs.AddComponent(ecs.CreateEntity(), Position{ 1.0f, 2.0f });
+
+		babs_ecs::ECSManager empty;
+		CHECK_THROWS_AS(Save::Restore(empty, TempPath("missing")), const babs_ecs::SnapshotException&);
+		CHECK_THROWS_AS(Save::Restore(ecs, TempPath("missing")), const babs_ecs::SnapshotException&);
+
+		std::string path = TempPath("mismatch");
+		REQUIRE(persistence::Snapshot<Position>::Checkpoint(ecs, path) == babs_ecs::Status::Ok);
+		CHECK_THROWS_AS(Save::Restore(empty, path), const babs_ecs::SnapshotException&);
+		CHECK_THROWS_AS(persistence::Snapshot<Health>::Restore(empty, path), const babs_ecs::SnapshotException&);
+
+		// cut the file short
+		{
+			std::ifstream original(path, std::ios::binary);
+			std::string bytes((std::istreambuf_iterator<char>(original)), std::istreambuf_iterator<char>());
+			std::ofstream truncate(path, std::ios::binary | std::ios::trunc);
+			truncate.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 8));
+		}
+		CHECK_THROWS_AS(persistence::Snapshot<Position>::Restore(empty, path), const babs_ecs::SnapshotException&);
+
+		// none of the failures touched the world
+		REQUIRE(empty.CreateEntity().UUID == 1);
+
+		// a new checkpoint replaces the damaged one
+		REQUIRE(persistence::Snapshot<Position>::Checkpoint(ecs, path) == babs_ecs::Status::Ok);
+		babs_ecs::ECSManager restored;
+		REQUIRE(persistence::Snapshot<Position>::Restore(restored, path) == babs_ecs::Status::Ok);
+		REQUIRE(restored.GetComponent<Position>(babs_ecs::Entity(1))->y == 2.0f);
+
+		std::remove(path.c_str());
+	}
+
+	TEST_CASE("Pools that list an entity twice are rejected")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		ecs.AddComponent(ecs.CreateEntity(), Position{ 1.0f, 2.0f });
+		ecs.AddComponent(ecs.CreateEntity(), Position{ 3.0f, 4.0f });
+
+		std::string path = TempPath("duplicate");
+		REQUIRE(persistence::Snapshot<Position>::Checkpoint(ecs, path) == babs_ecs::Status::Ok);
+
+		// the Position block's count comes after the header, the layout and the empty free and
+		// disabled blocks, and its UUIDs start on the next block boundary
+		size_t uuids = (sizeof(persistence::SnapshotHeader) + sizeof(persistence::SnapshotLayout) + persistence::snapshotBlock - 1) / persistence::snapshotBlock * persistence::snapshotBlock + persistence::snapshotBlock;
+		{
+			std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+			uint32_t listed[2] = {};
+			file.seekg(static_cast<std::streamoff>(uuids));
+			file.read(reinterpret_cast<char*>(listed), sizeof(listed));
+			REQUIRE(listed[0] == 1);
+			REQUIRE(listed[1] == 2);
+
+			listed[1] = listed[0];
+			file.seekp(static_cast<std::streamoff>(uuids));
+			file.write(reinterpret_cast<const char*>(listed), sizeof(listed));
+		}
+
+		babs_ecs::ECSManager restored;
+		CHECK_THROWS_AS(persistence::Snapshot<Position>::Restore(restored, path), const babs_ecs::SnapshotException&);
+		REQUIRE(restored.CreateEntity().UUID == 1);
+
+		std::remove(path.c_str());
+	}
+}
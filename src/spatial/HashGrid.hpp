@@ -0,0 +1,318 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "../ComponentObserver.hpp"
+#include "../ECSManager.hpp"
+#include "../Entity.hpp"
+#include "../Events.hpp"
+
+// The spatial namespace contains optional indexes that answer proximity queries without scanning
+// every entity. They're kept up to date through the ECS events, so nothing needs to be registered
+// with the manager itself.
+namespace spatial
+{
+	struct Point
+	{
+		float x;
+		float y;
+		float z;
+	};
+
+	struct AABB
+	{
+		Point min;
+		Point max;
+	};
+
+	// UpdateMode controls when component changes reach the index.
+	//
+	// Immediate applies every add/update/remove as its event fires. Deferred only records the latest
+	// change per entity and applies them all in one batch on Flush(), which is cheaper when entities
+	// move several times a frame and queries only happen after the simulation step.
+	enum class UpdateMode
+	{
+		Immediate,
+		Deferred
+	};
+
+	// HashGrid is a uniform hash grid over the position stored in component T.
+	//
+	// The grid follows T's events through a babs_ecs::ComponentObserver, see there for which ones.
+	// Changes made directly through GetComponent are not observed; report those with Update()
+	// instead. For 2D worlds, return z = 0 from the locator.
+	//
+	// Typical usage:
+	//   spatial::HashGrid<Position> grid(ecs, 16.0f, [](const Position& p) { return spatial::Point{ p.x, p.y, 0.0f }; });
+	//   for (auto e : grid.QueryRadius({ 10.0f, 10.0f, 0.0f }, 32.0f)) { ... }
+	template <typename T>
+	class HashGrid
+	{
+	public:
+		// Locator extracts the indexed position from the component
+		using Locator = std::function<Point(const T&)>;
+
+		HashGrid(babs_ecs::ECSManager& ecs, float cellSize, Locator locate, UpdateMode mode = UpdateMode::Immediate)
+			: cellSize(cellSize), locate(locate), mode(mode),
+			  observer(ecs, [this](babs_ecs::Entity e, const T& component) { this->Update(e, component); }, [this](babs_ecs::Entity e) { this->Remove(e); })
+		{
+			// index everything that already exists
+			for (babs_ecs::Entity e : ecs.EntitiesWith<T>(babs_ecs::DisabledEntities::Include))
+			{
+				this->Insert(e.UUID, this->locate(*ecs.ReadComponent<T>(e)));
+			}
+		}
+
+		HashGrid(const HashGrid&) = delete;
+		HashGrid& operator=(const HashGrid&) = delete;
+
+		// Update reports a new position for the entity. Use it for changes the grid can't see,
+		// like writes through GetComponent.
+		void Update(babs_ecs::Entity entity, const T& component)
+		{
+			Point position = this->locate(component);
+
+			if (this->mode == UpdateMode::Deferred)
+			{
+				this->pending[entity.UUID] = Pending{ position, false };
+				return;
+			}
+
+			this->Insert(entity.UUID, position);
+		}
+
+		// Remove drops the entity from the grid. Removing an entity that isn't indexed does nothing.
+		void Remove(babs_ecs::Entity entity)
+		{
+			if (this->mode == UpdateMode::Deferred)
+			{
+				this->pending[entity.UUID] = Pending{ Point{ 0.0f, 0.0f, 0.0f }, true };
+				return;
+			}
+
+			this->Erase(entity.UUID);
+		}
+
+		// Flush applies every change recorded in Deferred mode. Call it once per frame, after the
+		// systems that move entities have run.
+		void Flush()
+		{
+			for (auto& change : this->pending)
+			{
+				if (change.second.removed)
+				{
+					this->Erase(change.first);
+				}
+				else
+				{
+					this->Insert(change.first, change.second.position);
+				}
+			}
+			this->pending.clear();
+		}
+
+		// Size returns the number of indexed entities.
+		size_t Size() const
+		{
+			return this->records.size();
+		}
+
+		// QueryBox returns every indexed entity whose position is inside the box (inclusive).
+		std::vector<babs_ecs::Entity> QueryBox(AABB box) const
+		{
+			std::vector<babs_ecs::Entity> found;
+
+			this->VisitCells(box, [&](const std::vector<uint32_t>& cell) {
+				for (uint32_t uuid : cell)
+				{
+					const Point& p = this->records.at(uuid).position;
+					if (p.x >= box.min.x && p.x <= box.max.x &&
+						p.y >= box.min.y && p.y <= box.max.y &&
+						p.z >= box.min.z && p.z <= box.max.z)
+					{
+						found.emplace_back(uuid);
+					}
+				}
+			});
+
+			return found;
+		}
+
+		// QueryRadius returns every indexed entity within radius of center (inclusive).
+		std::vector<babs_ecs::Entity> QueryRadius(Point center, float radius) const
+		{
+			std::vector<babs_ecs::Entity> found;
+			AABB box{ { center.x - radius, center.y - radius, center.z - radius }, { center.x + radius, center.y + radius, center.z + radius } };
+			float radiusSquared = radius * radius;
+
+			this->VisitCells(box, [&](const std::vector<uint32_t>& cell) {
+				for (uint32_t uuid : cell)
+				{
+					const Point& p = this->records.at(uuid).position;
+					float dx = p.x - center.x;
+					float dy = p.y - center.y;
+					float dz = p.z - center.z;
+					if (dx * dx + dy * dy + dz * dz <= radiusSquared)
+					{
+						found.emplace_back(uuid);
+					}
+				}
+			});
+
+			return found;
+		}
+
+	private:
+		struct Record
+		{
+			Point position;
+			uint64_t cell;
+		};
+
+		struct Pending
+		{
+			Point position;
+			bool removed;
+		};
+
+		float cellSize;
+		Locator locate;
+		UpdateMode mode;
+
+		std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+		std::unordered_map<uint32_t, Record> records;
+		std::unordered_map<uint32_t, Pending> pending;
+
+		// last, so it stops calling back before the maps go away
+		babs_ecs::ComponentObserver<T> observer;
+
+
+		// CoordinateLimit bounds the cell coordinates to the 21 bits Key packs
+		static constexpr float CoordinateLimit = float(1 << 20);
+
+		// Coordinate returns the cell along one axis. Anything past the packable range, infinities
+		// included, is clamped into the outermost cell, and NaN goes to cell 0, so the cast to an
+		// integer is always defined. Queries check exact positions, so a crowded edge cell only
+		// costs extra distance checks.
+		int64_t Coordinate(float value) const
+		{
+			float cell = std::floor(value / this->cellSize);
+			if (std::isnan(cell))
+			{
+				return 0;
+			}
+
+			return static_cast<int64_t>(std::clamp(cell, -CoordinateLimit, CoordinateLimit - 1.0f));
+		}
+
+		// cells are keyed by packing 21 bits of each coordinate, the range Coordinate clamps to
+		static uint64_t Key(int64_t x, int64_t y, int64_t z)
+		{
+			const uint64_t mask = (1 << 21) - 1;
+			return (static_cast<uint64_t>(x) & mask) | ((static_cast<uint64_t>(y) & mask) << 21) | ((static_cast<uint64_t>(z) & mask) << 42);
+		}
+
+		uint64_t KeyFor(Point p) const
+		{
+			return Key(this->Coordinate(p.x), this->Coordinate(p.y), this->Coordinate(p.z));
+		}
+
+		void Insert(uint32_t uuid, Point position)
+		{
+			uint64_t cell = this->KeyFor(position);
+
+			auto record = this->records.find(uuid);
+			if (record != this->records.end())
+			{
+				record->second.position = position;
+				if (record->second.cell == cell)
+				{
+					return;
+				}
+
+				this->EraseFromCell(record->second.cell, uuid);
+				record->second.cell = cell;
+			}
+			else
+			{
+				this->records[uuid] = Record{ position, cell };
+			}
+
+			this->cells[cell].push_back(uuid);
+		}
+
+		void Erase(uint32_t uuid)
+		{
+			auto record = this->records.find(uuid);
+			if (record == this->records.end())
+			{
+				return;
+			}
+
+			this->EraseFromCell(record->second.cell, uuid);
+			this->records.erase(record);
+		}
+
+		void EraseFromCell(uint64_t key, uint32_t uuid)
+		{
+			auto cell = this->cells.find(key);
+			std::vector<uint32_t>& members = cell->second;
+
+			for (size_t i = 0; i < members.size(); ++i)
+			{
+				if (members[i] == uuid)
+				{
+					members[i] = members.back();
+					members.pop_back();
+					break;
+				}
+			}
+
+			if (members.empty())
+			{
+				this->cells.erase(cell);
+			}
+		}
+
+		// VisitCells calls visit for each occupied cell overlapping the box. Huge boxes fall back
+		// to walking the occupied cells, so a query never costs more than a full scan.
+		template <typename Visit>
+		void VisitCells(const AABB& box, Visit visit) const
+		{
+			int64_t minX = this->Coordinate(box.min.x), maxX = this->Coordinate(box.max.x);
+			int64_t minY = this->Coordinate(box.min.y), maxY = this->Coordinate(box.max.y);
+			int64_t minZ = this->Coordinate(box.min.z), maxZ = this->Coordinate(box.max.z);
+
+			double covered = static_cast<double>(maxX - minX + 1) * static_cast<double>(maxY - minY + 1) * static_cast<double>(maxZ - minZ + 1);
+
+			if (covered > static_cast<double>(this->cells.size()))
+			{
+				for (auto& cell : this->cells)
+				{
+					visit(cell.second);
+				}
+				return;
+			}
+
+			for (int64_t z = minZ; z <= maxZ; ++z)
+			{
+				for (int64_t y = minY; y <= maxY; ++y)
+				{
+					for (int64_t x = minX; x <= maxX; ++x)
+					{
+						auto cell = this->cells.find(Key(x, y, z));
+						if (cell != this->cells.end())
+						{
+							visit(cell->second);
+						}
+					}
+				}
+			}
+		}
+	};
+}
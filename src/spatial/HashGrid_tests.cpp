@@ -0,0 +1,210 @@
+#include "doctest.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "HashGrid.hpp"
+#include "../ECSManager.hpp"
+
+namespace
+{
+	struct Position
+	{
+		float x;
+		float y;
+	};
+
+	spatial::Point Locate(const Position& p)
+	{
+		return spatial::Point{ p.x, p.y, 0.0f };
+	}
+
+	bool Found(const std::vector<babs_ecs::Entity>& entities, babs_ecs::Entity entity)
+	{
+		return std::find(entities.begin(), entities.end(), entity) != entities.end();
+	}
+}
+
+TEST_SUITE("Spatial hash grid")
+{
+	TEST_CASE("Grid indexes existing and newly added components")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+
+		babs_ecs::Entity before = ecs.CreateEntity();
+		ecs.AddComponent(before, Position{ 1.0f, 1.0f });
+
+		spatial::HashGrid<Position> grid(ecs, 10.0f, Locate);
+
+		babs_ecs::Entity after = ecs.CreateEntity();
+		ecs.AddComponent(after, Position{ 3.0f, 4.0f });
+
+		babs_ecs::Entity far = ecs.CreateEntity();
+		ecs.AddComponent(far, Position{ 500.0f, -500.0f });
+
+		REQUIRE(grid.Size() == 3);
+
+		auto nearby = grid.QueryRadius({ 0.0f, 0.0f, 0.0f }, 5.0f);
+		REQUIRE(nearby.size() == 2);
+		REQUIRE(Found(nearby, before));
+		REQUIRE(Found(nearby, after));
+
+		auto box = grid.QueryBox({ { 400.0f, -600.0f, -1.0f }, { 600.0f, -400.0f, 1.0f } });
+		REQUIRE(box.size() == 1);
+		REQUIRE(box[0] == far);
+	}
+
+	TEST_CASE("Radius queries check the exact distance")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		spatial::HashGrid<Position> grid(ecs, 4.0f, Locate);
+
+		babs_ecs::Entity inside = ecs.CreateEntity();
+		ecs.AddComponent(inside, Position{ 3.0f, 4.0f });
+
+		// inside the bounding box of the query, but outside the circle
+		babs_ecs::Entity corner = ecs.CreateEntity();
+		ecs.AddComponent(corner, Position{ 4.5f, 4.5f });
+
+		auto found = grid.QueryRadius({ 0.0f, 0.0f, 0.0f }, 5.0f);
+		REQUIRE(found.size() == 1);
+		REQUIRE(found[0] == inside);
+	}
+
+	TEST_CASE("Positions past the grid's range, infinite or NaN are still indexed")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		spatial::HashGrid<Position> grid(ecs, 1.0f, Locate);
+
+		const float infinity = std::numeric_limits<float>::infinity();
+		babs_ecs::Entity far = ecs.CreateEntity();
+		ecs.AddComponent(far, Position{ 1e30f, -1e30f });
+		babs_ecs::Entity edge = ecs.CreateEntity();
+		ecs.AddComponent(edge, Position{ 1e29f, -1e29f });
+		babs_ecs::Entity lost = ecs.CreateEntity();
+		ecs.AddComponent(lost, Position{ infinity, std::numeric_limits<float>::quiet_NaN() });
+		babs_ecs::Entity home = ecs.CreateEntity();
+		ecs.AddComponent(home, Position{ 0.5f, 0.5f });
+		REQUIRE(grid.Size() == 4);
+
+		// far and edge share the outermost cell, the exact check tells them apart
+		auto found = grid.QueryRadius({ 1e30f, -1e30f, 0.0f }, 1.0f);
+		REQUIRE(found.size() == 1);
+		REQUIRE(found[0] == far);
+
+		// an infinite box covers everything that has a position to compare
+		auto everything = grid.QueryBox({ { -infinity, -infinity, -1.0f }, { infinity, infinity, 1.0f } });
+		REQUIRE(everything.size() == 3);
+		REQUIRE_FALSE(Found(everything, lost));
+
+		REQUIRE(grid.QueryRadius({ 0.0f, 0.0f, 0.0f }, 1.0f).size() == 1);
+		ecs.RemoveEntity(lost);
+		REQUIRE(grid.Size() == 3);
+	}
+
+	TEST_CASE("Patch, RemoveComponent and RemoveEntity keep the grid up to date")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		spatial::HashGrid<Position> grid(ecs, 10.0f, Locate);
+
+		babs_ecs::Entity mover = ecs.CreateEntity();
+		ecs.AddComponent(mover, Position{ 0.0f, 0.0f });
+		babs_ecs::Entity stripped = ecs.CreateEntity();
+		ecs.AddComponent(stripped, Position{ 1.0f, 0.0f });
+		babs_ecs::Entity removed = ecs.CreateEntity();
+		ecs.AddComponent(removed, Position{ 2.0f, 0.0f });
+
+		ecs.Patch<Position>(mover, [](Position& p) { p.x = 100.0f; });
+		ecs.RemoveComponent<Position>(stripped);
+		ecs.RemoveEntity(removed);
+
+		REQUIRE(grid.Size() == 1);
+		REQUIRE(grid.QueryRadius({ 0.0f, 0.0f, 0.0f }, 50.0f).empty());
+
+		auto moved = grid.QueryRadius({ 100.0f, 0.0f, 0.0f }, 1.0f);
+		REQUIRE(moved.size() == 1);
+		REQUIRE(moved[0] == mover);
+	}
+
+	TEST_CASE("Deferred grids apply changes on Flush")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		spatial::HashGrid<Position> grid(ecs, 10.0f, Locate, spatial::UpdateMode::Deferred);
+
+		babs_ecs::Entity e = ecs.CreateEntity();
+		ecs.AddComponent(e, Position{ 0.0f, 0.0f });
+		ecs.Patch<Position>(e, [](Position& p) { p.y = 30.0f; });
+
+		REQUIRE(grid.Size() == 0);
+
+		grid.Flush();
+		REQUIRE(grid.Size() == 1);
+		REQUIRE(grid.QueryRadius({ 0.0f, 30.0f, 0.0f }, 1.0f).size() == 1);
+
+		ecs.RemoveEntity(e);
+		REQUIRE(grid.Size() == 1);
+
+		grid.Flush();
+		REQUIRE(grid.Size() == 0);
+	}
+
+	TEST_CASE("Grid stops listening once destroyed")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+
+		{
+			spatial::HashGrid<Position> grid(ecs, 10.0f, Locate);
+		}
+
+		babs_ecs::Entity e = ecs.CreateEntity();
+		CHECK_NOTHROW(ecs.AddComponent(e, Position{ 0.0f, 0.0f }));
+		CHECK_NOTHROW(ecs.RemoveEntity(e));
+	}
+
+	TEST_CASE("Instantiated entities are indexed")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		spatial::HashGrid<Position> grid(ecs, 10.0f, Locate);
+
+		babs_ecs::Prefab prefab;
+		prefab.Set(Position{ 5.0f, 5.0f });
+		ecs.Instantiate(prefab, 20);
+
+		REQUIRE(grid.Size() == 20);
+		REQUIRE(grid.QueryRadius({ 5.0f, 5.0f, 0.0f }, 1.0f).size() == 20);
+	}
+
+	TEST_CASE("Bulk operations keep the grid up to date")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		ecs.RegisterComponent<int>();
+		spatial::HashGrid<Position> grid(ecs, 10.0f, Locate);
+
+		for (int i = 0; i < 10; ++i)
+		{
+			babs_ecs::Entity e = ecs.CreateEntity();
+			if (i % 2 == 0) ecs.AddComponent(e, i);
+		}
+
+		ecs.AddToAll<int>(Position{ 5.0f, 5.0f });
+		REQUIRE(grid.Size() == 5);
+
+		ecs.DestroyAll<int>();
+		REQUIRE(grid.Size() == 0);
+
+		ecs.AddToAll(Position{ 1.0f, 1.0f });
+		REQUIRE(grid.QueryRadius({ 1.0f, 1.0f, 0.0f }, 1.0f).size() == 5);
+
+		ecs.Clear<Position>();
+		REQUIRE(grid.Size() == 0);
+	}
+}
@@ -0,0 +1,473 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../ECSManager.hpp"
+#include "../Entity.hpp"
+#include "../Exceptions.hpp"
+#include "../Layout.hpp"
+
+// The streaming namespace moves sets of entities between the world and local files, so only the
+// regions that are in use have to stay resident.
+namespace streaming
+{
+	// Partition files are written in native byte order:
+	//
+	//   header      "BABP", uint32 version, uint32 component count, uint32 entity count
+	//   layout      per component: uint32 sizeof, uint32 alignof
+	//   entities    per entity: uint32 UUID at the time it was saved
+	//   components  per component: uint32 count, count uint32 entity slots, count raw components
+	//
+	// Components are matched by their position in the Ts list, so saving and loading have to use
+	// the same list. The layout block catches components that changed size or alignment.
+	constexpr char partitionMagic[4] = { 'B', 'A', 'B', 'P' };
+	constexpr uint32_t partitionVersion = 1;
+
+	// StagedPartition holds a partition that has been read from disk but not yet added to a world.
+	// Loading one doesn't touch the ECSManager, so it can happen on any thread. Merge then moves it
+	// into the world on the simulation thread, a bounded number of entities at a time.
+	template <typename... Ts>
+	class StagedPartition
+	{
+	public:
+		// status is Status::PartitionFailed, and error says why, if the file couldn't be loaded
+		babs_ecs::Status status = babs_ecs::Status::Ok;
+		std::string path;
+		std::string error;
+
+		// Size returns the number of entities in the partition.
+		size_t Size() const
+		{
+			return this->uuids.size();
+		}
+
+		// Merged returns true once every entity has been added to the world.
+		bool Merged() const
+		{
+			return this->merged == this->uuids.size();
+		}
+
+		// Merge creates up to maxEntities of the staged entities in the world, with their
+		// components, and returns Status::Ok. Call it once per frame until Merged() is true to
+		// spread a large partition over several frames. Every one of Ts has to be registered. If
+		// a component can't be added, the entities of this call are removed again, so the next
+		// call retries the same batch.
+		babs_ecs::Status Merge(babs_ecs::ECSManager& ecs, size_t maxEntities = std::numeric_limits<size_t>::max())
+		{
+			if (this->status != babs_ecs::Status::Ok)
+			{
+				BABS_ECS_ERROR(babs_ecs::PartitionException(this->path, this->error), this->status);
+			}
+
+			// checked up front, so a missing registration doesn't leave entities without components
+			if (!(ecs.ComponentIsRegistered(babs_ecs::ECSManager::ComponentId<Ts>()) && ...))
+			{
+				BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(ecs.UnregisteredComponentName<Ts...>()), babs_ecs::Status::ComponentNotRegistered);
+			}
+
+			size_t end = this->merged + std::min(maxEntities, this->uuids.size() - this->merged);
+
+			for (size_t slot = this->merged; slot < end; ++slot)
+			{
+				this->created[slot] = ecs.CreateEntity();
+			}
+
+			size_t next[sizeof...(Ts)];
+			babs_ecs::Status result = babs_ecs::Status::Ok;
+			std::apply([&](auto&... columns) {
+				size_t i = 0;
+				((next[i++] = columns.next), ...);
+				((result = result == babs_ecs::Status::Ok ? this->MergeColumn(ecs, columns, end) : result), ...);
+
+				if (result != babs_ecs::Status::Ok)
+				{
+					i = 0;
+					((columns.next = next[i++]), ...);
+				}
+			}, this->columns);
+
+			if (result != babs_ecs::Status::Ok)
+			{
+				for (size_t slot = this->merged; slot < end; ++slot)
+				{
+					ecs.RemoveEntity(this->created[slot]);
+					this->created[slot] = babs_ecs::Entity();
+				}
+
+				return result;
+			}
+
+			this->merged = end;
+			return babs_ecs::Status::Ok;
+		}
+
+		// Remap returns the entity that the given saved UUID was merged as, or a dummy entity
+		// (UUID 0) if it isn't part of the partition or hasn't been merged yet. Use it to fix up
+		// components that refer to other entities.
+		babs_ecs::Entity Remap(uint32_t savedUUID) const
+		{
+			auto slot = this->slots.find(savedUUID);
+			if (slot == this->slots.end() || slot->second >= this->merged)
+			{
+				return babs_ecs::Entity();
+			}
+
+			return this->created[slot->second];
+		}
+
+	private:
+		template <typename... Us>
+		friend class Partition;
+
+		template <typename T>
+		struct Column
+		{
+			std::vector<uint32_t> slots;
+			std::vector<T> data;
+			size_t next = 0;
+		};
+
+		std::vector<uint32_t> uuids;
+		std::tuple<Column<Ts>...> columns;
+
+		// slots maps a saved UUID to its index in uuids, built while loading so Merge doesn't have to
+		std::unordered_map<uint32_t, size_t> slots;
+		std::vector<babs_ecs::Entity> created;
+		size_t merged = 0;
+
+		template <typename T>
+		babs_ecs::Status MergeColumn(babs_ecs::ECSManager& ecs, Column<T>& column, size_t end)
+		{
+			for (; column.next < column.slots.size() && column.slots[column.next] < end; ++column.next)
+			{
+				babs_ecs::Status added = ecs.AddComponent(this->created[column.slots[column.next]], column.data[column.next]);
+				if (added != babs_ecs::Status::Ok)
+				{
+					return added;
+				}
+			}
+
+			return babs_ecs::Status::Ok;
+		}
+
+		void Fail(std::string reason)
+		{
+			this->status = babs_ecs::Status::PartitionFailed;
+			this->error = std::move(reason);
+			this->uuids.clear();
+			this->created.clear();
+		}
+	};
+
+	// Partition saves and loads sets of entities with the components Ts. Every one of Ts has to be
+	// trivially copyable, since they're written to disk as raw bytes. Components an entity has
+	// that aren't in Ts aren't saved.
+	//
+	// Typical usage:
+	//   using Region = streaming::Partition<Position, Velocity, Health>;
+	//   Region::Evict(ecs, regionEntities, "region_4_7.bin");
+	//   ...
+	//   auto loading = Region::LoadAsync("region_4_7.bin");
+	//   ... later, once loading is ready:
+	//   auto region = loading.get();
+	//   while (!region.Merged()) { region.Merge(ecs, 1000); /* next frame */ }
+	template <typename... Ts>
+	class Partition
+	{
+	public:
+		static_assert(sizeof...(Ts) > 0, "A partition needs at least one component type");
+		static_assert((std::is_trivially_copyable_v<Ts> && ...), "Partitions can only store trivially copyable components");
+		static_assert(!(babs_ecs::is_soa_v<Ts> || ...), "SoA components can't be stored in a partition");
+
+		// Save writes the entities and their components in Ts to the file at path. Every one of Ts
+		// has to be registered, and every entity has to be alive. The file is written next to the
+		// old one and then renamed over it, so a failed save never leaves a partial partition behind.
+		static babs_ecs::Status Save(babs_ecs::ECSManager& ecs, const std::vector<babs_ecs::Entity>& entities, const std::string& path)
+		{
+			if (!(ecs.ComponentIsRegistered(babs_ecs::ECSManager::ComponentId<Ts>()) && ...))
+			{
+				BABS_ECS_ERROR(babs_ecs::ComponentNotRegisteredException(ecs.UnregisteredComponentName<Ts...>()), babs_ecs::Status::ComponentNotRegistered);
+			}
+
+			for (const babs_ecs::Entity& e : entities)
+			{
+				if (!ecs.IsAlive(e))
+				{
+					BABS_ECS_ERROR(babs_ecs::EntityNotFoundException(e.UUID), babs_ecs::Status::EntityNotFound);
+				}
+			}
+
+			std::string temporary = path + ".tmp";
+			std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				BABS_ECS_ERROR(babs_ecs::PartitionException(temporary, "can't be opened for writing"), babs_ecs::Status::PartitionFailed);
+			}
+
+			uint32_t header[3] = { partitionVersion, static_cast<uint32_t>(sizeof...(Ts)), static_cast<uint32_t>(entities.size()) };
+			uint32_t layout[2 * sizeof...(Ts)];
+			Layout(layout);
+
+			file.write(partitionMagic, sizeof(partitionMagic));
+			Write(file, header, 3);
+			Write(file, layout, 2 * sizeof...(Ts));
+
+			std::vector<uint32_t> uuids;
+			uuids.reserve(entities.size());
+			for (const babs_ecs::Entity& e : entities)
+			{
+				uuids.push_back(e.UUID);
+			}
+			Write(file, uuids.data(), uuids.size());
+
+			(SaveColumn<Ts>(ecs, entities, file), ...);
+
+			file.close();
+			if (!file || !Replace(temporary, path))
+			{
+				std::remove(temporary.c_str());
+				BABS_ECS_ERROR(babs_ecs::PartitionException(path, "couldn't be written"), babs_ecs::Status::PartitionFailed);
+			}
+
+			return babs_ecs::Status::Ok;
+		}
+
+		// Evict saves the entities and then removes them from the world. Removing an entity in the
+		// hierarchy removes its descendants too, so every descendant of a listed entity has to be
+		// listed as well, or nothing is saved or removed and Status::PartitionFailed is returned.
+		// The hierarchy itself isn't saved, since Relationship is managed by the world.
+		static babs_ecs::Status Evict(babs_ecs::ECSManager& ecs, const std::vector<babs_ecs::Entity>& entities, const std::string& path)
+		{
+			if (ecs.ComponentIsRegistered(babs_ecs::ECSManager::ComponentId<babs_ecs::Relationship>()))
+			{
+				std::unordered_map<uint32_t, bool> listed;
+				for (const babs_ecs::Entity& e : entities)
+				{
+					listed[e.UUID] = true;
+				}
+
+				for (const babs_ecs::Entity& e : entities)
+				{
+					if (!ecs.IsAlive(e) || !ecs.HasComponent<babs_ecs::Relationship>(e))
+					{
+						continue;
+					}
+
+					for (uint32_t descendant : ecs.GetDescendants(e.UUID))
+					{
+						if (listed.find(descendant) == listed.end())
+						{
+							BABS_ECS_ERROR(babs_ecs::PartitionException(path, "entity " + std::to_string(descendant) + " would be removed with its ancestor without being saved"), babs_ecs::Status::PartitionFailed);
+						}
+					}
+				}
+			}
+
+			babs_ecs::Status saved = Save(ecs, entities, path);
+			if (saved != babs_ecs::Status::Ok)
+			{
+				return saved;
+			}
+
+			for (const babs_ecs::Entity& e : entities)
+			{
+				// descendants are already gone if their ancestor came first
+				if (ecs.IsAlive(e))
+				{
+					ecs.RemoveEntity(e);
+				}
+			}
+
+			return babs_ecs::Status::Ok;
+		}
+
+		// Load reads a partition into staging storage. It doesn't touch any world, and reports
+		// errors through the staged partition's status, so it's safe to call from any thread.
+		static StagedPartition<Ts...> Load(const std::string& path)
+		{
+			StagedPartition<Ts...> staged;
+			staged.path = path;
+
+			std::ifstream file(path, std::ios::binary | std::ios::ate);
+			if (!file)
+			{
+				staged.Fail("can't be opened for reading");
+				return staged;
+			}
+
+			// counts are checked against what's left of the file before anything is allocated
+			std::streamoff size = file.tellg();
+			file.seekg(0);
+
+			char magic[4] = {};
+			uint32_t header[3] = {};
+			file.read(magic, sizeof(magic));
+			if (!Read(file, header, 3) || std::memcmp(magic, partitionMagic, sizeof(magic)) != 0)
+			{
+				staged.Fail("isn't a partition file");
+				return staged;
+			}
+
+			if (header[0] != partitionVersion)
+			{
+				staged.Fail("was written by partition format version " + std::to_string(header[0]));
+				return staged;
+			}
+
+			uint32_t expected[2 * sizeof...(Ts)];
+			uint32_t layout[2 * sizeof...(Ts)];
+			Layout(expected);
+
+			if (header[1] != sizeof...(Ts) || !Read(file, layout, 2 * sizeof...(Ts)) || std::memcmp(layout, expected, sizeof(layout)) != 0)
+			{
+				staged.Fail("was saved with different component types");
+				return staged;
+			}
+
+			if (uint64_t(header[2]) * sizeof(uint32_t) > Remaining(file, size))
+			{
+				staged.Fail("is truncated");
+				return staged;
+			}
+
+			staged.uuids.resize(header[2]);
+			if (!Read(file, staged.uuids.data(), staged.uuids.size()))
+			{
+				staged.Fail("is truncated");
+				return staged;
+			}
+
+			bool complete = true;
+			std::apply([&](auto&... columns) {
+				((complete = complete && LoadColumn(file, size, columns, staged.uuids.size())), ...);
+			}, staged.columns);
+
+			if (!complete)
+			{
+				staged.Fail("is truncated");
+				return staged;
+			}
+
+			staged.slots.reserve(staged.uuids.size());
+			for (size_t slot = 0; slot < staged.uuids.size(); ++slot)
+			{
+				staged.slots.emplace(staged.uuids[slot], slot);
+			}
+			staged.created.resize(staged.uuids.size());
+
+			return staged;
+		}
+
+		// LoadAsync runs Load on a background thread.
+		static std::future<StagedPartition<Ts...>> LoadAsync(std::string path)
+		{
+			return std::async(std::launch::async, [path]() {
+				return Load(path);
+			});
+		}
+
+	private:
+		// Layout fills in the size and alignment of each of Ts
+		static void Layout(uint32_t* layout)
+		{
+			size_t i = 0;
+			((layout[i++] = static_cast<uint32_t>(sizeof(Ts)), layout[i++] = static_cast<uint32_t>(alignof(Ts))), ...);
+		}
+
+		template <typename T>
+		static void Write(std::ofstream& file, const T* data, size_t count)
+		{
+			file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+		}
+
+		template <typename T>
+		static bool Read(std::ifstream& file, T* data, size_t count)
+		{
+			file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+			return static_cast<bool>(file);
+		}
+
+		// Remaining returns how many bytes of the file, size bytes long, haven't been read yet
+		static uint64_t Remaining(std::ifstream& file, std::streamoff size)
+		{
+			std::streamoff offset = file.tellg();
+			return offset >= 0 && offset <= size ? static_cast<uint64_t>(size - offset) : 0;
+		}
+
+		// Replace renames from over to. Where rename can't replace an existing file, the old one is
+		// removed first.
+		static bool Replace(const std::string& from, const std::string& to)
+		{
+			if (std::rename(from.c_str(), to.c_str()) == 0)
+			{
+				return true;
+			}
+
+			std::remove(to.c_str());
+			return std::rename(from.c_str(), to.c_str()) == 0;
+		}
+
+		template <typename T>
+		static void SaveColumn(babs_ecs::ECSManager& ecs, const std::vector<babs_ecs::Entity>& entities, std::ofstream& file)
+		{
+			std::vector<uint32_t> slots;
+			std::vector<T> data;
+
+			for (size_t slot = 0; slot < entities.size(); ++slot)
+			{
+				if (const T* component = ecs.ReadComponent<T>(entities[slot]))
+				{
+					slots.push_back(static_cast<uint32_t>(slot));
+					data.push_back(*component);
+				}
+			}
+
+			uint32_t count = static_cast<uint32_t>(slots.size());
+			Write(file, &count, 1);
+			Write(file, slots.data(), slots.size());
+			Write(file, data.data(), data.size());
+		}
+
+		template <typename Column>
+		static bool LoadColumn(std::ifstream& file, std::streamoff size, Column& column, size_t entityCount)
+		{
+			using T = typename decltype(column.data)::value_type;
+
+			uint32_t count = 0;
+			if (!Read(file, &count, 1) || count > entityCount || uint64_t(count) * (sizeof(uint32_t) + sizeof(T)) > Remaining(file, size))
+			{
+				return false;
+			}
+
+			column.slots.resize(count);
+			column.data.resize(count);
+			if (!Read(file, column.slots.data(), count) || !Read(file, column.data.data(), count))
+			{
+				return false;
+			}
+
+			// Merge walks each column in entity order, so the slots have to be valid and ascending
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (column.slots[i] >= entityCount || (i > 0 && column.slots[i] <= column.slots[i - 1]))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+	};
+}
@@ -0,0 +1,220 @@
+#include "doctest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Partition.hpp"
+#include "../ECSManager.hpp"
+
+namespace
+{
+	struct Position
+	{
+		float x;
+		float y;
+	};
+
+	struct Health
+	{
+		int max;
+		int current;
+	};
+
+	// Target refers to another entity, so it has to be fixed up after a merge
+	struct Target
+	{
+		uint32_t entity;
+	};
+
+	using Region = streaming::Partition<Position, Health, Target>;
+
+	std::string TempPath(const char* name)
+	{
+		return std::string("babs_ecs_partition_") + name + ".bin";
+	}
+}
+
+TEST_SUITE("Partitions")
+{
+	TEST_CASE("Evicted entities come back with their components and references remapped")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		ecs.RegisterComponent<Health>();
+		ecs.RegisterComponent<Target>();
+
+		babs_ecs::Entity resident = ecs.CreateEntity();
+		ecs.AddComponent(resident, Position{ 9.0f, 9.0f });
+
+		std::vector<babs_ecs::Entity> region;
+		for (int i = 0; i < 5; ++i)
+		{
+			region.push_back(ecs.CreateEntity());
+			ecs.AddComponent(region.back(), Position{ static_cast<float>(i), 0.0f });
+			if (i % 2 == 0)
+			{
+				ecs.AddComponent(region.back(), Health{ 10, i });
+			}
+		}
+		ecs.AddComponent(region[4], Target{ region[1].UUID });
+
+		std::string path = TempPath("evict");
+		REQUIRE(Region::Evict(ecs, region, path) == babs_ecs::Status::Ok);
+		REQUIRE(ecs.EntitiesWith<Position>().size() == 1);
+		REQUIRE_FALSE(ecs.IsAlive(region[0]));
+		REQUIRE(ecs.IsAlive(resident));
+
+		// reuse some of the evicted ids so the merged entities can't keep theirs
+		ecs.CreateEntity();
+		ecs.CreateEntity();
+
+		auto loading = Region::LoadAsync(path);
+		streaming::StagedPartition<Position, Health, Target> staged = loading.get();
+		REQUIRE(staged.status == babs_ecs::Status::Ok);
+		REQUIRE(staged.Size() == 5);
+
+		// merge a bounded number per call
+		REQUIRE(staged.Merge(ecs, 2) == babs_ecs::Status::Ok);
+		REQUIRE_FALSE(staged.Merged());
+		REQUIRE(ecs.EntitiesWith<Position>().size() == 3);
+		REQUIRE(staged.Remap(region[4].UUID).UUID == 0);
+
+		while (!staged.Merged())
+		{
+			staged.Merge(ecs, 2);
+		}
+
+		REQUIRE(ecs.EntitiesWith<Position>().size() == 6);
+		REQUIRE(ecs.EntitiesWith<Health>().size() == 3);
+
+		for (int i = 0; i < 5; ++i)
+		{
+			babs_ecs::Entity merged = staged.Remap(region[i].UUID);
+			REQUIRE(merged.UUID != 0);
+			REQUIRE(ecs.GetComponent<Position>(merged)->x == static_cast<float>(i));
+			REQUIRE(ecs.HasComponent<Health>(merged) == (i % 2 == 0));
+		}
+
+		Target* target = ecs.GetComponent<Target>(staged.Remap(region[4].UUID));
+		target->entity = staged.Remap(target->entity).UUID;
+		REQUIRE(target->entity == staged.Remap(region[1].UUID).UUID);
+
+		std::remove(path.c_str());
+	}
+
+	TEST_CASE("Loading reports missing and mismatched files")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		ecs.RegisterComponent<Health>();
+
+		auto missing = Region::Load(TempPath("missing"));
+		REQUIRE(missing.status == babs_ecs::Status::PartitionFailed);
+		REQUIRE(missing.Size() == 0);
+
+		babs_ecs::Entity e = ecs.CreateEntity();
+		ecs.AddComponent(e, Position{ 1.0f, 2.0f });
+
+		std::string path = TempPath("mismatch");
+		REQUIRE(streaming::Partition<Position>::Save(ecs, { e }, path) == babs_ecs::Status::Ok);
+
+		auto mismatched = Region::Load(path);
+		REQUIRE(mismatched.status == babs_ecs::Status::PartitionFailed);
+		REQUIRE(mismatched.error == "was saved with different component types");
+		REQUIRE_THROWS_AS(mismatched.Merge(ecs), const babs_ecs::PartitionException&);
+
+		auto matching = streaming::Partition<Position>::Load(path);
+		REQUIRE(matching.status == babs_ecs::Status::Ok);
+
+		// cut the file short
+		{
+			std::ofstream truncate(path, std::ios::binary | std::ios::trunc);
+			truncate.write(streaming::partitionMagic, 4);
+		}
+		REQUIRE(streaming::Partition<Position>::Load(path).error == "isn't a partition file");
+
+		std::remove(path.c_str());
+	}
+
+	TEST_CASE("Unregistered components are refused before anything is written or created")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+		ecs.RegisterComponent<Health>();
+
+		babs_ecs::Entity e = ecs.CreateEntity();
+		ecs.AddComponent(e, Position{ 1.0f, 2.0f });
+
+		std::string path = TempPath("unregistered");
+		REQUIRE(streaming::Partition<Position>::Save(ecs, { e }, path) == babs_ecs::Status::Ok);
+
+		// Target isn't registered, so the earlier save is left alone
+		REQUIRE_THROWS_AS(Region::Save(ecs, { e }, path), const babs_ecs::ComponentNotRegisteredException&);
+		REQUIRE(streaming::Partition<Position>::Load(path).status == babs_ecs::Status::Ok);
+		REQUIRE_FALSE(std::ifstream(path + ".tmp").good());
+
+		auto staged = streaming::Partition<Position>::Load(path);
+		babs_ecs::ECSManager empty;
+		REQUIRE_THROWS_AS(staged.Merge(empty), const babs_ecs::ComponentNotRegisteredException&);
+		REQUIRE(empty.EntitiesWith().empty());
+
+		// once registered, the same staged partition merges in full
+		empty.RegisterComponent<Position>();
+		REQUIRE(staged.Merge(empty) == babs_ecs::Status::Ok);
+		REQUIRE(staged.Merged());
+		REQUIRE(empty.GetComponent<Position>(staged.Remap(e.UUID))->y == 2.0f);
+
+		std::remove(path.c_str());
+	}
+
+	TEST_CASE("Dead entities and unlisted descendants are refused before anything is written")
+	{
+		babs_ecs::ECSManager ecs;
+		ecs.RegisterComponent<Position>();
+
+		babs_ecs::Entity parent = ecs.CreateEntity();
+		babs_ecs::Entity child = ecs.CreateEntity();
+		babs_ecs::Entity dead = ecs.CreateEntity();
+		ecs.AddComponent(parent, Position{ 1.0f, 0.0f });
+		ecs.AddComponent(child, Position{ 2.0f, 0.0f });
+		ecs.SetParent(child, parent);
+		ecs.RemoveEntity(dead);
+
+		std::string path = TempPath("subtree");
+		REQUIRE_THROWS_AS(streaming::Partition<Position>::Save(ecs, { parent, dead }, path), const babs_ecs::EntityNotFoundException&);
+		REQUIRE_FALSE(std::ifstream(path).good());
+
+		// evicting the parent alone would remove the child without saving it
+		CHECK_THROWS_AS(streaming::Partition<Position>::Evict(ecs, { parent }, path), const babs_ecs::PartitionException&);
+		REQUIRE_FALSE(std::ifstream(path).good());
+		REQUIRE(ecs.IsAlive(child));
+
+		// the whole subtree can go
+		REQUIRE(streaming::Partition<Position>::Evict(ecs, { parent, child }, path) == babs_ecs::Status::Ok);
+		REQUIRE_FALSE(ecs.IsAlive(child));
+		REQUIRE(streaming::Partition<Position>::Load(path).Size() == 2);
+
+		std::remove(path.c_str());
+	}
+
+	TEST_CASE("Counts larger than the file are refused without allocating them")
+	{
+		std::string path = TempPath("oversized");
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			uint32_t header[3] = { streaming::partitionVersion, 1, 0xFFFFFFFFu };
+			uint32_t layout[2] = { sizeof(Position), alignof(Position) };
+			file.write(streaming::partitionMagic, 4);
+			file.write(reinterpret_cast<const char*>(header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(layout), sizeof(layout));
+		}
+
+		auto staged = streaming::Partition<Position>::Load(path);
+		REQUIRE(staged.status == babs_ecs::Status::PartitionFailed);
+		REQUIRE(staged.error == "is truncated");
+
+		std::remove(path.c_str());
+	}
+}